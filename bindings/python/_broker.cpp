@@ -123,6 +123,13 @@ PYBIND11_MODULE(_broker, m) {
     .def("send_rate", &broker::publisher::send_rate)
     .def("fd", &broker::publisher::fd)
     .def("drop_all_on_destruction", &broker::publisher::drop_all_on_destruction)
+    .def("set_batching",
+       [](broker::publisher& p, size_t max_size, double max_delay) {
+         using fractional_seconds = std::chrono::duration<double>;
+         auto delay = std::chrono::duration_cast<broker::timespan>(
+           fractional_seconds{max_delay});
+         p.set_batching(max_size, delay);
+       })
     .def("publish", (void (broker::publisher::*)(broker::data d)) &broker::publisher::publish)
     .def("publish_batch",
        [](broker::publisher& p, std::vector<broker::data> xs) { p.publish(xs); });
@@ -191,6 +198,7 @@ PYBIND11_MODULE(_broker, m) {
 
   py::class_<broker::subscriber, subscriber_base>(m, "Subscriber")
     .def("add_topic", &broker::subscriber::add_topic)
+    .def("set_unbatching", &broker::subscriber::set_unbatching)
     .def("remove_topic", &broker::subscriber::remove_topic);
 
   py::bind_vector<std::vector<broker::status_subscriber::value_type>>(m, "VectorStatusSubscriberValueType");
@@ -157,6 +157,9 @@ class Subscriber:
     def remove_topic(self, topic, block=False):
         return self._subscriber.remove_topic(_make_topic(topic), block)
 
+    def set_unbatching(self, enabled):
+        return self._subscriber.set_unbatching(enabled)
+
 class StatusSubscriber(_broker.Subscriber):
     def __init__(self, internal_subscriber):
         self._subscriber = internal_subscriber
@@ -224,6 +227,9 @@ class Publisher:
         batch = [Data.from_py(d) for d in batch]
         return self._publisher.publish_batch(_broker.Vector(batch))
 
+    def set_batching(self, max_size, max_delay=0.01):
+        return self._publisher.set_batching(max_size, max_delay)
+
 class Store:
     # This class does not derive from the internal class because we
     # need to pass in existign instances. That means we need to
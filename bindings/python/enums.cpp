@@ -36,7 +36,10 @@ void init_enums(py::module& m) {
     .value("Unspecified", broker::sc::unspecified)
     .value("PeerAdded", broker::sc::peer_added)
     .value("PeerRemoved", broker::sc::peer_removed)
-    .value("PeerLost", broker::sc::peer_lost);
+    .value("PeerLost", broker::sc::peer_lost)
+    .value("PeerBuffering", broker::sc::peer_buffering)
+    .value("PeerBufferOverflow", broker::sc::peer_buffer_overflow)
+    .value("PeerBufferDrained", broker::sc::peer_buffer_drained);
 
   py::enum_<broker::peer_status>(m, "PeerStatus")
     .value("Initialized", broker::peer_status::initialized)
@@ -43,6 +43,7 @@ using peer = caf::atom_constant<caf::atom("peer")>;
 using read = caf::atom_constant<caf::atom("read")>;
 using retry = caf::atom_constant<caf::atom("retry")>;
 using run = caf::atom_constant<caf::atom("run")>;
+using shard = caf::atom_constant<caf::atom("shard")>;
 using shutdown = caf::atom_constant<caf::atom("shutdown")>;
 using status = caf::atom_constant<caf::atom("status")>;
 using unpeer = caf::atom_constant<caf::atom("unpeer")>;
@@ -50,11 +51,14 @@ using write = caf::atom_constant<caf::atom("write")>;
 
 /// --- communication with workers ---------------------------------------------
 
+using flush = caf::atom_constant<caf::atom("flush")>;
 using resume = caf::atom_constant<caf::atom("resume")>;
 
 /// --- communication with stores ----------------------------------------------
 
 using attach = caf::atom_constant<caf::atom("attach")>;
+using batching = caf::atom_constant<caf::atom("batching")>;
+using buffers = caf::atom_constant<caf::atom("buffers")>;
 using clear = caf::atom_constant<caf::atom("clear")>;
 using clone = caf::atom_constant<caf::atom("clone")>;
 using decrement = caf::atom_constant<caf::atom("decrement")>;
@@ -63,6 +67,7 @@ using expire = caf::atom_constant<caf::atom("expire")>;
 using exists = caf::atom_constant<caf::atom("exists")>;
 using increment = caf::atom_constant<caf::atom("increment")>;
 using keys = caf::atom_constant<caf::atom("keys")>;
+using lanes = caf::atom_constant<caf::atom("lanes")>;
 using master = caf::atom_constant<caf::atom("master")>;
 using store = caf::atom_constant<caf::atom("store")>;
 using subtract = caf::atom_constant<caf::atom("subtract")>;
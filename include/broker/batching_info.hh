@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+#include "broker/endpoint_info.hh"
+#include "broker/time.hh"
+
+namespace broker {
+
+/// Estimates and decisions of the batching controller for a peer.
+/// @relates endpoint
+struct batching_info {
+  endpoint_info peer;        ///< Information about the peer.
+  double rate = 0;           ///< Estimated messages per second to the peer.
+  timespan rtt{0};           ///< Estimated round-trip time.
+  size_t batch_size = 0;     ///< Current size of outbound batches.
+  size_t open_credit = 0;    ///< Credit currently granted by the peer.
+  size_t credit_target = 0;  ///< Credit for sustaining the rate.
+};
+
+template <class Inspector>
+typename Inspector::result_type inspect(Inspector& f, batching_info& x) {
+  return f(x.peer, x.rate, x.rtt, x.batch_size, x.open_credit,
+           x.credit_target);
+}
+
+} // namespace broker
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <string>
+
 #include <caf/actor_system_config.hpp>
 
+#include "broker/time.hh"
+
 namespace broker {
 
 struct broker_options {
@@ -24,6 +29,53 @@ struct broker_options {
   /// Whether to ignore the `broker.conf` file.
   bool ignore_broker_conf = false;
 
+  /// Number of core actors that route messages in parallel. Each topic maps
+  /// to exactly one shard, which preserves the order of messages per topic.
+  /// All peering endpoints must use the same number of shards. A sharded
+  /// endpoint drops peerings to endpoints with a different number of shards.
+  /// Setting this to 1 disables sharding.
+  unsigned int core_shards = 1;
+
+  /// Whether store commands overtake queued data messages on their way to a
+  /// peer. Keeps store replication responsive while peers receive bulk data,
+  /// but gives up the ordering between store commands and data messages.
+  bool priority_lanes = false;
+
+  /// Whether the core sizes batches to peers from the observed message rate
+  /// and round-trip time instead of always using the batch size requested by
+  /// the peer.
+  bool adaptive_batching = false;
+
+  /// Maximum time a message to a peer waits for its batch to fill up when
+  /// using adaptive batching.
+  timespan batch_latency_target = std::chrono::milliseconds(5);
+
+  /// Messages per second that each peering should sustain when using
+  /// adaptive batching. Only affects the reported credit target.
+  size_t batch_throughput_target = 0;
+
+  /// Maximum number of bytes (estimated) that the core keeps in memory for
+  /// messages from a peer while waiting for status subscribers.
+  size_t peer_buffer_memory_limit = 64 * 1024 * 1024;
+
+  /// Directory for spilling messages from blocked peers to disk after
+  /// reaching the memory limit. The core drops messages instead if empty.
+  std::string peer_buffer_spill_directory;
+
+  /// Maximum size of a single spill file in bytes.
+  size_t peer_buffer_spill_limit = 1024 * 1024 * 1024;
+
+  /// Number of recent updates that a data store master keeps for clones that
+  /// reconnect. Clones that missed more updates receive a full snapshot.
+  /// Masters only start keeping updates once the first clone attached.
+  size_t replication_log_size = 1000;
+
+  /// Whether clones share their content with the threads that query them.
+  /// Queries on clones then read an immutable copy of the content directly
+  /// instead of sending a request to the clone actor, at the cost of copying
+  /// the content after each batch of updates.
+  bool clone_local_reads = false;
+
   broker_options() = default;
 
   broker_options(const broker_options&) = default;
@@ -74,10 +74,34 @@ struct core_state {
   /// Returns the policy object.
   detail::core_policy& policy();
 
+  /// Returns whether this core is an additional routing shard. Shards neither
+  /// initiate peerings nor host data stores and never emit status or error
+  /// events, since the primary core reports those already.
+  bool is_shard() const {
+    return primary != nullptr;
+  }
+
+  // --- sharding --------------------------------------------------------------
+
+  /// Checks whether `remote_core` uses the same number of shards after the
+  /// primary cores completed their handshake. On success, connects each
+  /// additional shard to its counterpart at `remote_core` if `connect` is
+  /// true. Otherwise, removes the peering.
+  void peer_shards(caf::actor remote_core, bool connect);
+
+  /// Removes the peering to `remote_core`, since the peer cannot receive
+  /// messages on topics that map to additional shards.
+  void drop_incompatible_peer(const caf::actor& remote_core, const char* msg);
+
+  /// Disconnects all additional shards from the shards at `remote_core`.
+  void unpeer_shards(const caf::actor& remote_core);
+
   // --- convenience functions for sending errors and events -------------------
 
   template <ec ErrorCode>
   void emit_error(caf::actor hdl, const char* msg) {
+    if (is_shard())
+      return;
     auto emit = [=](network_info x) {
       BROKER_INFO("error" << ErrorCode << x);
       // TODO: consider creating the data directly rather than going through the
@@ -102,6 +126,8 @@ struct core_state {
 
   template <ec ErrorCode>
   void emit_error(network_info inf, const char* msg) {
+    if (is_shard())
+      return;
     auto x = cache.find(inf);
     if (x)
       emit_error<ErrorCode>(std::move(*x), msg);
@@ -118,6 +144,8 @@ struct core_state {
   void emit_status(caf::actor hdl, const char* msg) {
     static_assert(StatusCode != sc::peer_added,
                   "Use emit_peer_added_status instead");
+    if (is_shard())
+      return;
     auto emit = [=](network_info x) {
       BROKER_INFO("status" << StatusCode << x);
       // TODO: consider creating the data directly rather than going through the
@@ -194,10 +222,22 @@ struct core_state {
 
   /// Handle for recording all peers (if enabled).
   std::ofstream peers_file;
+
+  /// Additional routing shards. Only the primary core knows its shards and
+  /// this list remains empty unless sharding is enabled.
+  std::vector<caf::actor> shards;
+
+  /// Points to the primary core if this core is an additional shard.
+  caf::actor primary;
 };
 
 caf::behavior core_actor(caf::stateful_actor<core_state>* self,
                          filter_type initial_filter, broker_options opts,
                          endpoint::clock* clock);
 
+/// Spawns an additional routing shard for the core `primary`.
+caf::behavior core_shard(caf::stateful_actor<core_state>* self,
+                         caf::actor primary, broker_options opts,
+                         endpoint::clock* clock);
+
 } // namespace broker
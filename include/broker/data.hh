@@ -1,8 +1,6 @@
 #pragma once
 
 #include <cstdint>
-#include <map>
-#include <set>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -23,6 +21,8 @@
 #include "broker/subnet.hh"
 #include "broker/time.hh"
 
+#include "broker/detail/flat_map.hh"
+#include "broker/detail/flat_set.hh"
 #include "broker/detail/hash.hh"
 #include "broker/detail/type_traits.hh"
 
@@ -36,14 +36,16 @@ using vector = std::vector<data>;
 /// @relates vector
 bool convert(const vector& v, std::string& str);
 
-/// An associative, ordered container of unique keys.
-using set = std::set<data>;
+/// An associative, ordered container of unique keys. Stores its elements in a
+/// sorted vector.
+using set = detail::flat_set<data>;
 
 /// @relates set
 bool convert(const set& s, std::string& str);
 
-/// An associative, ordered container that maps unique keys to values.
-using table = std::map<data, data>;
+/// An associative, ordered container that maps unique keys to values. Stores
+/// its key-value pairs in a vector sorted by key.
+using table = detail::flat_map<data, data>;
 
 /// @relates table
 bool convert(const table& t, std::string& str);
@@ -153,6 +155,9 @@ public:
 
   static data from_type(type);
 
+  /// Returns the hash value for this data.
+  size_t hash() const;
+
   // Needed by caf::default_variant_access.
   data_variant& get_data() {
     return data_;
@@ -217,6 +222,21 @@ typename Inspector::result_type inspect(Inspector& f, data& x) {
 /// @relates data
 bool convert(const data& d, std::string& str);
 
+/// Appends the textual representation of `x` to `buf`, i.e., the same output
+/// as `to_string(x)`. Nested values render directly into `buf`. Hence, callers
+/// can reuse a single buffer for rendering many values without allocating
+/// intermediate strings.
+/// @relates data
+void render(const data& x, std::string& buf);
+
+/// Appends a JSON representation of `x` to `buf`. Numbers, booleans and
+/// `nil` map to their JSON counterparts, strings and enum values to JSON
+/// strings, and vectors and sets to arrays. Tables become arrays of key-value
+/// pairs, where each pair is an array with two elements. All remaining types
+/// render as JSON strings in Broker's textual format.
+/// @relates data
+void render_json(const data& x, std::string& buf);
+
 /// @relates data
 inline std::string to_string(const broker::data& d) {
   std::string s;
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/detail/type_list.hpp>
+
+#include "broker/data.hh"
+#include "broker/detail/compact_encoding.hh"
+#include "broker/optional.hh"
+#include "broker/time.hh"
+
+namespace broker {
+
+/// A read-only view to a serialized ::data value. Navigates the encoding in
+/// place instead of deserializing the whole value, e.g., for
+/// looking at the first element of a large vector. A view never owns the
+/// buffer, i.e., users must keep the buffer alive while using the view or any
+/// view derived from it. Views support both CAF's binary encoding and
+/// Broker's compact encoding (see `detail::compact_encoding`).
+///
+/// Malformed input never causes undefined behavior. Instead, accessors return
+/// `nil` or an invalid view.
+/// @note Subscribers, workers, and stores still receive decoded values. Views
+///       are a building block for code with access to serialized data, such
+///       as `detail::payload_view` or Zeek event schemas.
+class data_view {
+public:
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// Constructs an invalid view.
+  data_view() = default;
+
+  /// Constructs a view to the value at the beginning of `buf`.
+  /// @param buf Points to the serialized value. Values in the compact
+  ///            encoding start with its version byte.
+  /// @param size The number of bytes in the buffer. The value may end before
+  ///             the end of the buffer.
+  data_view(const char* buf, size_t size) : first_(buf), last_(buf + size) {
+    if (detail::compact_encoding::is_compact(buf, size)) {
+      ++first_;
+      compact_ = true;
+    }
+  }
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns whether the view points to a value with a known type.
+  bool valid() const noexcept {
+    return first_ != last_ && index() < num_types && (!relative() || base_);
+  }
+
+  /// Returns the type of the value or `data::type::none` if the view is
+  /// invalid.
+  data::type get_type() const;
+
+  /// Returns whether the value has type `T`.
+  template <class T>
+  bool is() const noexcept {
+    return valid() && index() == tag_of<T>();
+  }
+
+  /// Returns the value if it has type `T`, where `T` is one of broker's
+  /// scalar types. Strings are available as `std::string_view` that points
+  /// into the buffer.
+  template <class T>
+  optional<T> as() const;
+
+  // -- container access -------------------------------------------------------
+
+  /// Returns the number of elements in a vector, set, or table and 0 for all
+  /// other values.
+  size_t size() const;
+
+  /// Returns the element at position `i` of a vector or set, or an invalid
+  /// view if `i` is out of range.
+  data_view operator[](size_t i) const;
+
+  /// Returns whether a set contains `key` or whether a table contains an entry
+  /// for `key`.
+  bool contains(const data& key) const;
+
+  /// Returns the value for `key` in a table, or an invalid view if the table
+  /// has no entry for `key`.
+  data_view find(const data& key) const;
+
+  /// Calls `f(x)` for each element `x` of a vector or set.
+  /// @returns `false` if the view does not point to a vector or set, or if
+  ///          the buffer ends prematurely, `true` otherwise.
+  template <class F>
+  bool for_each(F f) const {
+    if (!is<vector>() && !is<set>())
+      return false;
+    size_t n = 0;
+    auto pos = enter(n);
+    if (pos == nullptr)
+      return false;
+    optional<timestamp> base;
+    for (size_t i = 0; i < n; ++i) {
+      auto x = next(pos, base);
+      if (pos == nullptr)
+        return false;
+      f(x);
+    }
+    return true;
+  }
+
+  /// Calls `f(key, value)` for each entry of a table.
+  /// @returns `false` if the view does not point to a table, or if the buffer
+  ///          ends prematurely, `true` otherwise.
+  template <class F>
+  bool for_each_entry(F f) const {
+    if (!is<table>())
+      return false;
+    size_t n = 0;
+    auto pos = enter(n);
+    if (pos == nullptr)
+      return false;
+    optional<timestamp> base;
+    for (size_t i = 0; i < n; ++i) {
+      auto key = next(pos, base);
+      if (pos == nullptr)
+        return false;
+      auto value = next(pos, base);
+      if (pos == nullptr)
+        return false;
+      f(key, value);
+    }
+    return true;
+  }
+
+  // -- conversion -------------------------------------------------------------
+
+  /// Deserializes the value.
+  /// @returns `nil` if the view is invalid or the buffer ends prematurely.
+  optional<data> materialize() const;
+
+private:
+  // -- constructors -----------------------------------------------------------
+
+  data_view(const char* first, const char* last, bool compact,
+            optional<timestamp> base)
+    : first_(first), last_(last), compact_(compact), base_(base) {
+    // nop
+  }
+
+  // -- type tags --------------------------------------------------------------
+
+  static constexpr uint8_t num_types = static_cast<uint8_t>(
+    caf::detail::tl_size<data::types>::value);
+
+  template <class T>
+  static constexpr uint8_t tag_of() {
+    using types = data::types;
+    return static_cast<uint8_t>(caf::detail::tl_index_of<types, T>::value);
+  }
+
+  /// Returns the first byte of the encoding.
+  uint8_t tag() const noexcept {
+    return static_cast<uint8_t>(*first_);
+  }
+
+  /// Returns the index of the value type in `data::types`.
+  uint8_t index() const noexcept {
+    return compact_ ? detail::compact_encoding::type_index(tag()) : tag();
+  }
+
+  /// Returns whether the value is a timestamp relative to `base_`.
+  bool relative() const noexcept {
+    return compact_ && detail::compact_encoding::is_relative(tag());
+  }
+
+  // -- parsing ----------------------------------------------------------------
+
+  caf::binary_deserializer make_source() const {
+    auto size = static_cast<size_t>(last_ - first_);
+    return caf::binary_deserializer{nullptr, first_, size};
+  }
+
+  /// Reads the size of a container.
+  /// @returns The position of the first element or `nullptr` if the
+  ///          container is malformed.
+  const char* enter(size_t& size) const;
+
+  /// Returns a view to the element of this container at `pos` and moves
+  /// `pos` to the next element or sets it to `nullptr` if the element is
+  /// malformed. Keeps track of the previous timestamp in `base`.
+  data_view next(const char*& pos, optional<timestamp>& base) const;
+
+  /// Returns the number of bytes in the encoding or 0 if the value is
+  /// malformed.
+  size_t extent() const;
+
+  /// Returns the value if it has type `T`.
+  template <class T>
+  optional<T> as_scalar() const;
+
+  /// Searches a set or table for `key`. Returns the matching element of a
+  /// set, the value of the matching entry in a table, or an invalid view.
+  data_view lookup(const data& key) const;
+
+  const char* first_ = nullptr;
+  const char* last_ = nullptr;
+
+  /// Selects the compact encoding instead of CAF's binary encoding.
+  bool compact_ = false;
+
+  /// Stores the previous timestamp in the enclosing vector for decoding
+  /// relative timestamps in the compact encoding.
+  optional<timestamp> base_;
+};
+
+template <>
+optional<boolean> data_view::as<boolean>() const;
+
+template <>
+optional<count> data_view::as<count>() const;
+
+template <>
+optional<integer> data_view::as<integer>() const;
+
+template <>
+optional<real> data_view::as<real>() const;
+
+template <>
+optional<std::string_view> data_view::as<std::string_view>() const;
+
+template <>
+optional<address> data_view::as<address>() const;
+
+template <>
+optional<subnet> data_view::as<subnet>() const;
+
+template <>
+optional<port> data_view::as<port>() const;
+
+template <>
+optional<timestamp> data_view::as<timestamp>() const;
+
+template <>
+optional<timespan> data_view::as<timespan>() const;
+
+template <>
+optional<enum_value> data_view::as<enum_value>() const;
+
+/// Returns a view to the value of `x` in `buf` after serializing it to `buf`.
+/// Useful for working with a view to a value that only exists in memory.
+/// @relates data_view
+data_view make_data_view(const data& x, std::vector<char>& buf);
+
+/// @relates data_view
+bool convert(const data_view& x, data& y);
+
+/// @relates data_view
+bool convert(const data_view& x, std::string& str);
+
+} // namespace broker
@@ -2,6 +2,8 @@
 
 #include "caf/string_view.hpp"
 
+#include "broker/time.hh"
+
 // This header contains hard-coded default values for various Broker options.
 
 namespace broker {
@@ -11,5 +13,8 @@ extern const caf::string_view recording_directory;
 
 extern const size_t output_generator_file_cap;
 
+/// Interval between two checks for expired keys in a data store master.
+extern const timespan expiry_tick_interval;
+
 } // namespace defaults
 } // namespace broker
@@ -6,6 +6,8 @@
 #include "broker/snapshot.hh"
 
 #include <deque>
+#include <memory>
+#include <vector>
 
 namespace broker {
 namespace detail {
@@ -13,6 +15,23 @@ namespace detail {
 using expirable = std::pair<broker::data, timestamp>;
 using expirables = std::deque<expirable>;
 
+/// Iterates over the key-value pairs of a backend in chunks. A cursor reads
+/// the content of the backend at the time of its creation, i.e., the backend
+/// may receive modifications while a cursor is active.
+/// @note A cursor may not outlive its backend.
+class backend_cursor {
+public:
+  virtual ~backend_cursor() = default;
+
+  /// Appends up to `n` key-value pairs to `xs`.
+  /// @returns `true` if more key-value pairs may follow, `false` if the
+  ///          cursor reached the end.
+  virtual expected<bool> next(size_t n, std::vector<snapshot_entry>& xs) = 0;
+};
+
+/// @relates backend_cursor
+using backend_cursor_ptr = std::unique_ptr<backend_cursor>;
+
 /// Abstract base class for a key-value storage backend.
 class abstract_backend {
 public:
@@ -33,10 +52,12 @@ public:
   /// Adds one value to another value.
   /// @param key The key associated with the existing value to add to.
   /// @param value The value to add on top of the existing value at *key*.
+  ///              Backends may move *value* into containers, i.e., callers
+  ///              should pass an rvalue if they no longer need the value.
   /// @param init_type The type of data to initialize when the key doesn't exist.
   /// @param t The point in time this modification took place.
   /// @returns `nil` on success.
-  virtual expected<void> add(const data& key, const data& value,
+  virtual expected<void> add(const data& key, data value,
                              data::type init_type,
                              optional<timestamp> expiry = {});
 
@@ -69,6 +90,24 @@ public:
   virtual expected<bool> expire(const data& key,
                                 timestamp current_time) = 0;
 
+  // --- batches --------------------------------------------------------------
+
+  /// Starts a batch of modifications. Persistent backends write all
+  /// modifications of a batch at once in `commit_batch`, e.g., in a single
+  /// transaction. Each modification in a batch still succeeds or fails on its
+  /// own: a failed modification leaves the backend unchanged and doesn't
+  /// affect other modifications in the batch. Lookups via `get` and `exists`
+  /// already see the modifications of the current batch. Batches don't nest.
+  /// The default implementation does nothing.
+  /// @returns `nil` on success.
+  virtual expected<void> begin_batch();
+
+  /// Writes all modifications since the last call to `begin_batch`. On error,
+  /// the backend discards all modifications of the batch.
+  /// The default implementation does nothing.
+  /// @returns `nil` if the backend wrote all modifications of the batch.
+  virtual expected<void> commit_batch();
+
   // --- inspectors -----------------------------------------------------------
 
   /// Retrieves the value associated with a given key.
@@ -102,6 +141,12 @@ public:
 
   /// @returns the set of all keys that have expiry times.
   virtual expected<expirables> expiries() const = 0;
+
+  /// Creates a cursor for iterating over all key-value pairs at this point in
+  /// time without loading them into memory at once. Must not get called
+  /// during a batch. The default implementation iterates over the result of
+  /// `snapshot()`.
+  virtual expected<backend_cursor_ptr> cursor() const;
 };
 
 } // namespace detail
@@ -19,9 +19,20 @@ constexpr bool is_additive_group() {
     || std::is_same<T, timespan>::value;
 }
 
+/// Adds a value to the visited data. Passing an rvalue to the constructor
+/// transfers ownership of the value, i.e., allows the adder to move it into
+/// vectors, sets and tables instead of copying it.
 struct adder {
   using result_type = expected<void>;
 
+  explicit adder(const data& x) : value(x), owned(nullptr) {
+    // nop
+  }
+
+  explicit adder(data&& x) : value(x), owned(&x) {
+    // nop
+  }
+
   template <class T>
   auto operator()(T&) -> disable_if_t<is_additive_group<T>(), result_type> {
     return ec::type_clash;
@@ -53,12 +64,12 @@ struct adder {
   }
 
   result_type operator()(vector& v) {
-    v.push_back(value);
+    v.push_back(take());
     return {};
   }
 
   result_type operator()(set& s) {
-    s.insert(value);
+    s.insert(take());
     return {};
   }
 
@@ -70,11 +81,26 @@ struct adder {
       return ec::type_clash;
     if (v->size() != 2)
       return ec::invalid_data;
-    t[v->front()] = v->back();
+    if (owned != nullptr) {
+      auto& kvp = caf::get<vector>(*owned);
+      t[std::move(kvp.front())] = std::move(kvp.back());
+    } else {
+      t[v->front()] = v->back();
+    }
     return {};
   }
 
+  /// Moves `value` out if the adder owns it, copies it otherwise.
+  data take() {
+    if (owned != nullptr)
+      return std::move(*owned);
+    return value;
+  }
+
   const data& value;
+
+  /// Points to `value` if the adder may move from it, `nullptr` otherwise.
+  data* owned;
 };
 
 struct remover {
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <caf/actor_clock.hpp>
+
+#include "broker/time.hh"
+
+namespace broker {
+namespace detail {
+
+/// Sizes outbound batches for a single path based on the observed arrival
+/// rate of messages and the round-trip time to the receiver. Slow streams
+/// ship small batches as soon as possible, whereas fast streams wait for
+/// batches to fill up.
+class batching_controller {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using time_point = caf::actor_clock::time_point;
+
+  /// Targets shared by all controllers of a downstream manager.
+  struct settings {
+    /// Maximum time a message waits for its batch to fill up.
+    timespan latency_target = std::chrono::milliseconds(5);
+
+    /// Messages per second that each path should sustain. The controller
+    /// computes its credit target from this rate if the observed rate is
+    /// lower. A value of 0 means "observed rate only".
+    size_t throughput_target = 0;
+  };
+
+  // -- estimation -------------------------------------------------------------
+
+  /// Updates the estimates before emitting batches.
+  /// @param now The current time.
+  /// @param buffered The number of messages in the buffer of the path.
+  /// @param open_credit The credit the receiver has granted.
+  void before_emit(time_point now, size_t buffered, int32_t open_credit);
+
+  /// Updates the estimates after emitting batches.
+  /// @param now The current time.
+  /// @param buffered The number of messages left in the buffer of the path.
+  /// @param open_credit The credit left after emitting batches.
+  void after_emit(time_point now, size_t buffered, int32_t open_credit);
+
+  // -- decisions --------------------------------------------------------------
+
+  /// Returns the batch size for the path. The result never exceeds the
+  /// batch size requested by the receiver.
+  /// @param cfg The targets for this controller.
+  /// @param current The batch size currently stored in the path. Differs from
+  ///                the last result if the receiver has asked for a new size.
+  int32_t batch_size(const settings& cfg, int32_t current);
+
+  /// Returns whether the path should ship underfull batches now.
+  bool flush(const settings& cfg, time_point now) const;
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the estimated number of messages per second on this path.
+  double rate() const noexcept {
+    return rate_;
+  }
+
+  /// Returns the estimated round-trip time to the receiver.
+  timespan rtt() const noexcept {
+    return rtt_;
+  }
+
+  /// Returns the most recent result of `batch_size`.
+  int32_t assigned_batch_size() const noexcept {
+    return assigned_;
+  }
+
+  /// Returns the credit the receiver must keep open for sustaining the
+  /// current (or targeted) rate, i.e., the bandwidth-delay product.
+  size_t credit_target(const settings& cfg) const;
+
+private:
+  /// Collects messages for the next rate sample.
+  size_t arrivals_ = 0;
+
+  /// Messages left in the buffer after the last emit.
+  size_t buffered_ = 0;
+
+  /// Credit left after the last emit.
+  int32_t credit_ = 0;
+
+  /// Start of the current rate sample.
+  time_point sample_start_;
+
+  /// Time when the oldest message in the buffer arrived.
+  time_point oldest_buffered_;
+
+  /// Time when sending the oldest batch that awaits an acknowledgement.
+  time_point oldest_unacked_;
+
+  /// Stores whether `oldest_unacked_` is valid.
+  bool awaiting_ack_ = false;
+
+  /// Batch size requested by the receiver.
+  int32_t requested_ = 0;
+
+  /// Batch size computed by this controller.
+  int32_t assigned_ = 0;
+
+  /// Moving average of messages per second.
+  double rate_ = 0;
+
+  /// Moving average of the round-trip time.
+  timespan rtt_{0};
+};
+
+} // namespace detail
+} // namespace broker
@@ -6,6 +6,10 @@
 #include <caf/binary_deserializer.hpp>
 #include <caf/binary_serializer.hpp>
 
+#include "broker/data.hh"
+#include "broker/detail/compact_encoding.hh"
+#include "broker/expected.hh"
+
 namespace broker {
 namespace detail {
 
@@ -31,5 +35,37 @@ T from_blob(const Container& buf) {
   return from_blob<T>(buf.data(), buf.size());
 }
 
+/// Serializes a value for a persistent store. Values use the compact encoding
+/// while keys remain in the binary encoding, because backends look up keys by
+/// comparing their blobs with the blobs of previous Broker versions.
+inline std::vector<char> to_value_blob(const data& x) {
+  std::vector<char> buf;
+  compact_encoding::encode(x, buf);
+  return buf;
+}
+
+/// Deserializes a value from a persistent store. Accepts both the compact
+/// encoding and the binary encoding of previous Broker versions.
+/// @returns the decoded value or the error of the decoder if `buf` does not
+///          contain a valid value, e.g., because the store is corrupted.
+inline expected<data> from_value_blob(const void* buf, size_t size) {
+  auto bytes = reinterpret_cast<const char*>(buf);
+  data result;
+  if (!compact_encoding::is_compact(bytes, size)) {
+    caf::binary_deserializer source{nullptr, bytes, size};
+    if (auto err = source(result))
+      return err;
+    return result;
+  }
+  if (auto err = compact_encoding::decode(bytes, size, result))
+    return err;
+  return result;
+}
+
+template <class Container>
+expected<data> from_value_blob(const Container& buf) {
+  return from_value_blob(buf.data(), buf.size());
+}
+
 } // namespace detail
 } // namespace broker
@@ -1,18 +1,22 @@
 #pragma once
 
-#include <unordered_map>
 #include <vector>
 
 #include <caf/actor.hpp>
+#include <caf/node_id.hpp>
 #include <caf/stateful_actor.hpp>
 #include <caf/event_based_actor.hpp>
 #include <caf/behavior.hpp>
+#include <caf/stream_manager.hpp>
 
 #include "broker/data.hh"
 #include "broker/internal_command.hh"
+#include "broker/message.hh"
 #include "broker/topic.hh"
 #include "broker/endpoint.hh"
 
+#include "broker/detail/clone_view.hh"
+
 namespace broker {
 namespace detail {
 
@@ -26,7 +30,8 @@ public:
 
   /// Initializes the object.
   void init(caf::event_based_actor* ptr, std::string&& nm,
-            caf::actor&& parent, endpoint::clock* ep_clock);
+            caf::actor&& parent, clone_view_ptr&& vp,
+            endpoint::clock* ep_clock);
 
   /// Sends `x` to the master.
   void forward(internal_command&& x);
@@ -39,6 +44,13 @@ public:
 
   void command(internal_command::variant_type& cmd);
 
+  /// Applies or buffers a command from the update stream.
+  void update(internal_command& cmd);
+
+  /// Applies or buffers a batch of commands from the update stream.
+  void update(std::vector<command_message>& xs);
+
+  /// Applies `cmd` and keeps track of its sequence number.
   void command(internal_command& cmd);
 
   void operator()(none);
@@ -61,6 +73,29 @@ public:
 
   void operator()(clear_command&);
 
+  /// Replaces the content of the store with `x` and applies all updates that
+  /// arrived while waiting for the snapshot.
+  void install_snapshot(clone_map&& x);
+
+  /// Applies the commands that the clone missed while disconnected from the
+  /// master. Replaces a snapshot when reconnecting to the same master.
+  void install_delta(std::vector<internal_command>& xs);
+
+  /// Applies all updates that arrived while waiting for a snapshot or delta.
+  void catch_up();
+
+  /// Asks the master for a snapshot of its state, or only for the commands
+  /// after `since` if `since` is not zero.
+  void request_snapshot(sequence_number since);
+
+  /// Discards all progress towards the current snapshot and asks the master
+  /// for a new full snapshot. Called after a snapshot stream aborted.
+  void restart_snapshot();
+
+  /// Installs the current state as new version of the view if it changed
+  /// since the last version.
+  void publish();
+
   data keys() const;
 
   caf::event_based_actor* self;
@@ -73,7 +108,7 @@ public:
 
   caf::actor master;
 
-  std::unordered_map<data, data> store;
+  clone_map store;
 
   bool is_stale;
 
@@ -89,6 +124,35 @@ public:
 
   bool awaiting_snapshot_sync;
 
+  /// Sequence number of the last command from the master that `store`
+  /// reflects. Zero if the store is not in sync with any master.
+  sequence_number last_seq = 0;
+
+  /// Node of the master that assigned `last_seq`.
+  caf::node_id master_node;
+
+  /// Actor ID of the master that assigned `last_seq`. Together with
+  /// `master_node`, this tells a brief disconnect from a new master.
+  caf::actor_id master_id = 0;
+
+  /// Collects the entries of a snapshot stream until the stream completes.
+  clone_map incoming_snapshot;
+
+  /// Identifies the most recent snapshot stream. Entries from streams of
+  /// previous masters get dropped.
+  size_t snapshot_generation = 0;
+
+  /// Shares the content of the clone with readers in other threads. Null
+  /// unless the user enabled local reads on clones.
+  clone_view_ptr view;
+
+  /// Stores whether `store` or `is_stale` changed since the last version of
+  /// `view`.
+  bool view_dirty = false;
+
+  /// Consumes the stream of updates from the core.
+  caf::stream_manager_ptr sink;
+
   endpoint::clock* clock;
 };
 
@@ -96,7 +160,7 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
                           caf::actor core, std::string name,
                           double resync_interval, double stale_interval,
                           double mutation_buffer_interval,
-                          endpoint::clock* ep_clock);
+                          clone_view_ptr view, endpoint::clock* ep_clock);
 
 } // namespace detail
 } // namespace broker
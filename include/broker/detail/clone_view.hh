@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+
+#include <caf/allowed_unsafe_message_type.hpp>
+
+#include "broker/data.hh"
+#include "broker/expected.hh"
+
+#include "broker/detail/persistent_map.hh"
+
+namespace broker {
+namespace detail {
+
+/// Content of a clone. Copies share all unmodified entries, so taking a copy
+/// after a batch of updates costs constant time.
+using clone_map = persistent_map<data, data>;
+
+/// Publishes the content of a clone as a sequence of immutable versions. The
+/// clone actor installs a new version after applying updates, while user
+/// threads query the current version directly instead of messaging the clone.
+/// A reader keeps the version it loaded alive for as long as it needs it, so
+/// the clone never modifies or destroys a version underneath a reader.
+class clone_view {
+public:
+  /// An immutable state of a clone.
+  struct version {
+    /// Content of the clone.
+    clone_map store;
+
+    /// Whether the clone answers queries with `ec::stale_data`.
+    bool is_stale;
+  };
+
+  using version_ptr = std::shared_ptr<const version>;
+
+  /// Creates a view of an empty, stale clone.
+  clone_view();
+
+  /// Returns the current version.
+  version_ptr load() const;
+
+  /// Replaces the current version. Readers that already loaded the previous
+  /// version keep using it. Since `store` shares its entries with the map of
+  /// the clone, publishing costs constant time regardless of the store size.
+  void publish(clone_map store, bool is_stale);
+
+  // -- queries with the same semantics as requests to the clone actor ---------
+
+  expected<data> exists(const data& key) const;
+
+  expected<data> get(const data& key) const;
+
+  expected<data> get(const data& key, const data& aspect) const;
+
+  expected<data> keys() const;
+
+private:
+  version_ptr current_;
+};
+
+using clone_view_ptr = std::shared_ptr<clone_view>;
+
+} // namespace detail
+} // namespace broker
+
+CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::detail::clone_view_ptr)
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <caf/error.hpp>
+
+#include "broker/data.hh"
+#include "broker/optional.hh"
+#include "broker/time.hh"
+
+namespace broker {
+namespace detail {
+
+/// A compact, self-describing encoding for ::data that replaces CAF's binary
+/// encoding for data payloads and values in persistent stores. The encoding
+/// starts with a version byte, followed by the encoded value:
+///
+/// - Each value starts with a one-byte tag. Integral values use LEB128
+///   varints, signed values additionally use zig-zag encoding.
+/// - Small counts (0 to 63), small integers (-16 to 15), and short strings
+///   (up to 31 bytes) store their value or length in the tag itself.
+/// - Timestamps inside a vector store the difference to the previous
+///   timestamp in the same vector, since Zeek events and log records usually
+///   carry several timestamps close to each other.
+///
+/// The version byte never collides with the first byte of CAF's binary
+/// encoding (the variant index of the value). Hence, decoders accept both
+/// formats.
+namespace compact_encoding {
+
+/// Identifies the current version of the compact encoding.
+constexpr uint8_t version = 0xC2;
+
+/// Returns whether the bytes in `buf` use the compact encoding.
+inline bool is_compact(const char* buf, size_t size) noexcept {
+  return size > 0 && static_cast<uint8_t>(buf[0]) == version;
+}
+
+/// Appends the compact encoding of `x` (including the version byte) to
+/// `buf`.
+void encode(const data& x, std::vector<char>& buf);
+
+/// Decodes a value in the compact encoding.
+/// @returns `ec::invalid_data` if `buf` does not contain a valid encoding.
+caf::error decode(const char* buf, size_t size, data& x);
+
+// -- encoding without ::data ---------------------------------------------------
+
+/// Appends the encoding of individual values without version byte to a
+/// buffer. Allows encoding values of a known type without wrapping them into
+/// ::data first.
+class writer {
+public:
+  explicit writer(std::vector<char>& buf) : buf_(buf) {
+    // nop
+  }
+
+  void operator()(none);
+
+  void operator()(boolean x);
+
+  void operator()(count x);
+
+  void operator()(integer x);
+
+  void operator()(real x);
+
+  void operator()(const std::string& x);
+
+  void operator()(const address& x);
+
+  void operator()(const subnet& x);
+
+  void operator()(port x);
+
+  void operator()(timestamp x);
+
+  void operator()(timespan x);
+
+  void operator()(const enum_value& x);
+
+  void operator()(const set& xs);
+
+  void operator()(const table& xs);
+
+  void operator()(const vector& xs);
+
+  void operator()(const data& x);
+
+  /// Writes a timestamp that appears inside a vector, where `prev` points to
+  /// the previous timestamp in the same vector (if any).
+  void operator()(timestamp x, const timestamp* prev);
+
+  /// Writes the header of a vector with `n` elements. Callers must write
+  /// timestamps in the vector relative to their predecessor.
+  void begin_vector(size_t n);
+
+private:
+  void put(uint8_t x);
+
+  void put_varint(uint64_t x);
+
+  void put_address(const address& x);
+
+  std::vector<char>& buf_;
+};
+
+// -- access to individual values ----------------------------------------------
+
+// The functions in this section operate on a single value without version
+// byte. All functions that return a pointer return `nullptr` for malformed
+// input.
+
+/// Appends the encoding of `x` without version byte to `buf`.
+void write(const data& x, std::vector<char>& buf);
+
+/// Returns the index of the value type in `data::types` for a tag or 0xFF if
+/// `tag` is invalid.
+uint8_t type_index(uint8_t tag) noexcept;
+
+/// Returns whether `tag` denotes a timestamp relative to the previous
+/// timestamp in the same vector.
+bool is_relative(uint8_t tag) noexcept;
+
+/// Decodes the value at `first` into `x`. Relative timestamps require the
+/// previous timestamp in the same vector as `base`.
+/// @returns The position after the value.
+const char* read(const char* first, const char* last, data& x,
+                 const timestamp* base = nullptr);
+
+/// Returns the position after the value at `first`.
+const char* skip(const char* first, const char* last);
+
+/// Reads the number of elements of the set, table, or vector at `first`.
+/// @returns The position of the first element.
+const char* read_size(const char* first, const char* last, size_t& n);
+
+/// Reads the length of the string or enum value at `first`.
+/// @returns The position of the first character.
+const char* read_string(const char* first, const char* last, size_t& n);
+
+} // namespace compact_encoding
+
+} // namespace detail
+} // namespace broker
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+#include <memory>
 #include <vector>
 #include <utility>
 #include <unordered_set>
@@ -15,13 +17,18 @@
 #include <caf/message.hpp>
 #include <caf/stream_slot.hpp>
 
+#include "broker/batching_info.hh"
 #include "broker/data.hh"
 #include "broker/detail/assert.hh"
 #include "broker/detail/generator_file_writer.hh"
+#include "broker/detail/indexed_downstream_manager.hh"
+#include "broker/detail/peer_buffer.hh"
 #include "broker/filter_type.hh"
 #include "broker/internal_command.hh"
+#include "broker/lane_depths.hh"
 #include "broker/logger.hh"
 #include "broker/message.hh"
+#include "broker/peer_buffer_info.hh"
 #include "broker/peer_filter.hh"
 #include "broker/topic.hh"
 
@@ -51,8 +58,8 @@ public:
     using batch = std::vector<element>;
 
     /// Type of the downstream_manager that broadcasts data to local actors.
-    using manager = caf::broadcast_downstream_manager<element, filter_type,
-                                                      prefix_matcher>;
+    using manager = indexed_downstream_manager<element, filter_type,
+                                               prefix_matcher>;
   };
 
   /// Streaming-related types for workers.
@@ -69,8 +76,8 @@ public:
     using batch = std::vector<element>;
 
     /// Type of the downstream_manager that broadcasts data to local actors.
-    using manager = caf::broadcast_downstream_manager<element, peer_filter,
-                                                      peer_filter_matcher>;
+    using manager = indexed_downstream_manager<element, peer_filter,
+                                               peer_filter_matcher>;
   };
 
   /// Maps actor handles to path IDs.
@@ -152,6 +159,7 @@ public:
   bool has_peer(const caf::actor& hdl) const;
 
   /// Block peer messages from being handled.  They are buffered until unblocked.
+  /// The buffer for each peer is bounded by the `peer_buffer_*` options.
   void block_peer(caf::actor peer);
 
   /// Unblock peer messages and flush any buffered messages immediately.
@@ -240,9 +248,19 @@ public:
   /// Pushes data to peers and workers.
   void push(data_message msg);
 
+  /// Pushes all messages in `msgs` to peers and emits batches only once.
+  void push(std::vector<data_message> msgs);
+
   /// Pushes data to peers and stores.
   void push(command_message msg);
 
+  /// Pushes all commands in `msgs` to peers and emits batches only once.
+  void push(std::vector<command_message> msgs);
+
+  /// Pushes a message with a pre-encoded payload to peers. Sets the TTL of
+  /// `msg` to the initial TTL of this endpoint.
+  void push(node_message msg);
+
   // -- properties -------------------------------------------------------------
 
   /// Returns the fused downstream_manager of the parent.
@@ -286,6 +304,17 @@ public:
   /// Returns all known peers.
   std::vector<caf::actor> get_peer_handles();
 
+  /// Returns the number of buffered messages per lane for each peer with an
+  /// outbound path.
+  std::vector<lane_depths> get_lane_depths();
+
+  /// Returns the state of the batching controller for each peer with an
+  /// outbound path.
+  std::vector<batching_info> get_batching_info();
+
+  /// Returns the fill level of the buffer for each blocked peer.
+  std::vector<peer_buffer_info> get_peer_buffers();
+
   /// Finds the first peer handle that satisfies the predicate.
   template <class Predicate>
   caf::actor find_output_peer_hdl(Predicate pred) {
@@ -405,7 +434,7 @@ private:
   std::unordered_set<caf::actor> blocked_peers;
 
   /// Messages that are currently buffered.
-  std::unordered_map<caf::actor, std::vector<caf::message>> blocked_msgs;
+  std::unordered_map<caf::actor, std::unique_ptr<peer_buffer>> blocked_msgs;
 
   /// Helper for recording meta data of published messages.
   detail::generator_file_writer_ptr recorder_;
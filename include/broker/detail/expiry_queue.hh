@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "broker/data.hh"
+#include "broker/time.hh"
+
+namespace broker {
+namespace detail {
+
+/// Keeps track of the expiration times of keys in a data store. A min-heap
+/// orders the keys by their expiration time. Moving the expiration of a key
+/// to a later point in time (the common case when refreshing a key) only
+/// updates a hash map and never touches the heap. Instead, the heap entry of
+/// the key moves when reaching its old expiration time.
+class expiry_queue {
+public:
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the number of keys with an expiration time.
+  size_t size() const noexcept {
+    return keys_.size();
+  }
+
+  /// Returns whether no key has an expiration time.
+  bool empty() const noexcept {
+    return keys_.empty();
+  }
+
+  // -- modifiers --------------------------------------------------------------
+
+  /// Sets the expiration time of `key` to `deadline`, replacing any previous
+  /// expiration time.
+  void schedule(const data& key, timestamp deadline);
+
+  /// Removes the expiration time of `key`.
+  void cancel(const data& key);
+
+  /// Removes all expiration times.
+  void clear();
+
+  /// Removes all keys that expire at or before `now` and appends them to
+  /// `xs`.
+  void drain(timestamp now, std::vector<data>& xs);
+
+private:
+  struct entry {
+    /// Current expiration time of the key.
+    timestamp deadline;
+
+    /// Position of the valid heap entry for the key. Heap entries with a
+    /// different time are outdated.
+    timestamp scheduled;
+  };
+
+  using heap_entry = std::pair<timestamp, data>;
+
+  struct heap_order {
+    bool operator()(const heap_entry& x, const heap_entry& y) const noexcept {
+      return x.first > y.first;
+    }
+  };
+
+  void push(timestamp t, data key);
+
+  /// Rebuilds the heap from `keys_` if outdated entries dominate the heap.
+  void compact();
+
+  std::unordered_map<data, entry> keys_;
+
+  std::vector<heap_entry> heap_;
+};
+
+} // namespace detail
+} // namespace broker
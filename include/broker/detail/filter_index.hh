@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "broker/detail/radix_tree.hh"
+#include "broker/filter_type.hh"
+#include "broker/topic.hh"
+
+namespace broker {
+namespace detail {
+
+/// Maps topic prefixes to the subscribers that registered them. Answers
+/// "which subscribers want topic `t`?" with a single walk over a radix tree
+/// instead of testing each filter of each subscriber individually.
+/// @tparam Key Identifies a subscriber, e.g., a stream slot.
+template <class Key>
+class filter_index {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using key_type = Key;
+
+  using key_list = std::vector<Key>;
+
+  // -- constants --------------------------------------------------------------
+
+  /// Maximum number of memoized lookup results before dropping the cache.
+  static constexpr size_t max_cached_topics = 1024;
+
+  // -- modifiers --------------------------------------------------------------
+
+  /// Sets the filter for `key`, replacing any previously registered filter.
+  void update(const Key& key, const filter_type& filter) {
+    erase(key);
+    if (filter.empty())
+      return;
+    for (auto& prefix : filter) {
+      auto& str = prefix.string();
+      if (str.empty()) {
+        add_key(wildcard_, key);
+      } else {
+        auto i = prefixes_.find(str);
+        if (i == prefixes_.end())
+          prefixes_.insert({str, key_list{key}});
+        else
+          add_key(i->second, key);
+      }
+    }
+    filters_.emplace(key, filter);
+    cache_.clear();
+  }
+
+  /// Removes all prefixes registered for `key`.
+  void erase(const Key& key) {
+    auto i = filters_.find(key);
+    if (i == filters_.end())
+      return;
+    for (auto& prefix : i->second) {
+      auto& str = prefix.string();
+      if (str.empty()) {
+        remove_key(wildcard_, key);
+      } else {
+        auto j = prefixes_.find(str);
+        if (j != prefixes_.end()) {
+          remove_key(j->second, key);
+          if (j->second.empty())
+            prefixes_.erase(str);
+        }
+      }
+    }
+    filters_.erase(i);
+    cache_.clear();
+  }
+
+  /// Removes all entries.
+  void clear() {
+    prefixes_.clear();
+    wildcard_.clear();
+    filters_.clear();
+    cache_.clear();
+  }
+
+  // -- lookup -----------------------------------------------------------------
+
+  /// Returns all keys with at least one prefix matching `t`, sorted and
+  /// without duplicates. The result remains valid until the next call to a
+  /// non-const member function.
+  const key_list& match(const topic& t) {
+    // Topics are interned, i.e., hashing and comparing them is cheap.
+    auto i = cache_.find(t);
+    if (i != cache_.end())
+      return i->second;
+    key_list result = wildcard_;
+    for (auto& j : prefixes_.prefix_of(t.string()))
+      result.insert(result.end(), j->second.begin(), j->second.end());
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    if (cache_.size() >= max_cached_topics)
+      cache_.clear();
+    return cache_.emplace(t, std::move(result)).first->second;
+  }
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the number of registered keys.
+  size_t size() const noexcept {
+    return filters_.size();
+  }
+
+  /// Returns whether no key is registered.
+  bool empty() const noexcept {
+    return filters_.empty();
+  }
+
+private:
+  static void add_key(key_list& xs, const Key& key) {
+    auto i = std::lower_bound(xs.begin(), xs.end(), key);
+    if (i == xs.end() || *i != key)
+      xs.insert(i, key);
+  }
+
+  static void remove_key(key_list& xs, const Key& key) {
+    auto i = std::lower_bound(xs.begin(), xs.end(), key);
+    if (i != xs.end() && *i == key)
+      xs.erase(i);
+  }
+
+  /// Maps non-empty prefixes to subscribers.
+  radix_tree<key_list> prefixes_;
+
+  /// Subscribers to the empty topic, i.e., to all messages.
+  key_list wildcard_;
+
+  /// Stores the filter of each subscriber for removing it again.
+  std::map<Key, filter_type> filters_;
+
+  /// Memoizes results of `match`, since the same topics tend to repeat.
+  std::unordered_map<topic, key_list> cache_;
+};
+
+} // namespace detail
+} // namespace broker
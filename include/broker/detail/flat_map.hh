@@ -0,0 +1,661 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <caf/error.hpp>
+#include <caf/meta/load_callback.hpp>
+
+namespace broker {
+namespace detail {
+
+/// Iterates the pairs of a ::flat_map. The map stores pairs with a mutable
+/// key in order to shift them around in its vector, but the iterator only
+/// exposes a view with a constant key. Otherwise, users could break the order
+/// of the map by modifying keys.
+/// @relates flat_map
+template <class Iterator, class Value>
+class flat_map_iterator {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using iterator_category = std::random_access_iterator_tag;
+
+  using value_type = std::remove_const_t<Value>;
+
+  using difference_type =
+    typename std::iterator_traits<Iterator>::difference_type;
+
+  using pointer = Value*;
+
+  using reference = Value&;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  flat_map_iterator() = default;
+
+  explicit flat_map_iterator(Iterator pos) : pos_(pos) {
+    // nop
+  }
+
+  /// Converts an `iterator` to a `const_iterator`.
+  template <class I, class V,
+            class = std::enable_if_t<std::is_convertible<I, Iterator>::value>>
+  flat_map_iterator(const flat_map_iterator<I, V>& other)
+    : pos_(other.base()) {
+    // nop
+  }
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the iterator of the underlying vector.
+  Iterator base() const {
+    return pos_;
+  }
+
+  // -- operators --------------------------------------------------------------
+
+  reference operator*() const {
+    // The stored pair and the view only differ in the constness of `first`.
+    return reinterpret_cast<reference>(*pos_);
+  }
+
+  pointer operator->() const {
+    return &**this;
+  }
+
+  reference operator[](difference_type n) const {
+    return *(*this + n);
+  }
+
+  flat_map_iterator& operator++() {
+    ++pos_;
+    return *this;
+  }
+
+  flat_map_iterator operator++(int) {
+    return flat_map_iterator{pos_++};
+  }
+
+  flat_map_iterator& operator--() {
+    --pos_;
+    return *this;
+  }
+
+  flat_map_iterator operator--(int) {
+    return flat_map_iterator{pos_--};
+  }
+
+  flat_map_iterator& operator+=(difference_type n) {
+    pos_ += n;
+    return *this;
+  }
+
+  flat_map_iterator& operator-=(difference_type n) {
+    pos_ -= n;
+    return *this;
+  }
+
+  friend flat_map_iterator operator+(flat_map_iterator x, difference_type n) {
+    return x += n;
+  }
+
+  friend flat_map_iterator operator+(difference_type n, flat_map_iterator x) {
+    return x += n;
+  }
+
+  friend flat_map_iterator operator-(flat_map_iterator x, difference_type n) {
+    return x -= n;
+  }
+
+private:
+  Iterator pos_;
+};
+
+/// @relates flat_map_iterator
+template <class I1, class V1, class I2, class V2>
+auto operator-(const flat_map_iterator<I1, V1>& x,
+               const flat_map_iterator<I2, V2>& y) {
+  return x.base() - y.base();
+}
+
+/// @relates flat_map_iterator
+template <class I1, class V1, class I2, class V2>
+bool operator==(const flat_map_iterator<I1, V1>& x,
+                const flat_map_iterator<I2, V2>& y) {
+  return x.base() == y.base();
+}
+
+/// @relates flat_map_iterator
+template <class I1, class V1, class I2, class V2>
+bool operator!=(const flat_map_iterator<I1, V1>& x,
+                const flat_map_iterator<I2, V2>& y) {
+  return x.base() != y.base();
+}
+
+/// @relates flat_map_iterator
+template <class I1, class V1, class I2, class V2>
+bool operator<(const flat_map_iterator<I1, V1>& x,
+               const flat_map_iterator<I2, V2>& y) {
+  return x.base() < y.base();
+}
+
+/// @relates flat_map_iterator
+template <class I1, class V1, class I2, class V2>
+bool operator<=(const flat_map_iterator<I1, V1>& x,
+                const flat_map_iterator<I2, V2>& y) {
+  return x.base() <= y.base();
+}
+
+/// @relates flat_map_iterator
+template <class I1, class V1, class I2, class V2>
+bool operator>(const flat_map_iterator<I1, V1>& x,
+               const flat_map_iterator<I2, V2>& y) {
+  return x.base() > y.base();
+}
+
+/// @relates flat_map_iterator
+template <class I1, class V1, class I2, class V2>
+bool operator>=(const flat_map_iterator<I1, V1>& x,
+                const flat_map_iterator<I2, V2>& y) {
+  return x.base() >= y.base();
+}
+
+/// An associative, ordered container that maps unique keys to values and
+/// keeps its key-value pairs in a vector sorted by key. Provides the
+/// interface of `std::map`, but stores all pairs in contiguous memory.
+/// Inserting or erasing elements invalidates all iterators.
+template <class Key, class T, class Compare = std::less<Key>>
+class flat_map : private Compare {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using key_type = Key;
+
+  using mapped_type = T;
+
+  using value_type = std::pair<const Key, T>;
+
+  /// Stores pairs with a mutable key, since the vector moves pairs around.
+  using container_type = std::vector<std::pair<Key, T>>;
+
+  using stored_type = typename container_type::value_type;
+
+  using key_compare = Compare;
+
+  using size_type = typename container_type::size_type;
+
+  using difference_type = typename container_type::difference_type;
+
+  using reference = value_type&;
+
+  using const_reference = const value_type&;
+
+  using pointer = value_type*;
+
+  using const_pointer = const value_type*;
+
+  using iterator
+    = flat_map_iterator<typename container_type::iterator, value_type>;
+
+  using const_iterator
+    = flat_map_iterator<typename container_type::const_iterator,
+                        const value_type>;
+
+  using reverse_iterator = std::reverse_iterator<iterator>;
+
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  /// Orders key-value pairs by their key.
+  class value_compare {
+  public:
+    bool operator()(const value_type& x, const value_type& y) const {
+      return cmp_(x.first, y.first);
+    }
+
+  private:
+    friend class flat_map;
+
+    explicit value_compare(Compare cmp) : cmp_(std::move(cmp)) {
+      // nop
+    }
+
+    Compare cmp_;
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  flat_map() = default;
+
+  explicit flat_map(const Compare& cmp) : Compare(cmp) {
+    // nop
+  }
+
+  /// Constructs the map from an unsorted range. Keeps the first of several
+  /// pairs with equivalent keys.
+  template <class InputIterator>
+  flat_map(InputIterator first, InputIterator last,
+           const Compare& cmp = Compare())
+    : Compare(cmp), xs_(first, last) {
+    normalize();
+  }
+
+  flat_map(std::initializer_list<value_type> init,
+           const Compare& cmp = Compare())
+    : flat_map(init.begin(), init.end(), cmp) {
+    // nop
+  }
+
+  flat_map& operator=(std::initializer_list<value_type> init) {
+    xs_.assign(init.begin(), init.end());
+    normalize();
+    return *this;
+  }
+
+  // -- element access ---------------------------------------------------------
+
+  T& at(const key_type& key) {
+    auto i = find(key);
+    if (i == end())
+      throw std::out_of_range("broker::detail::flat_map::at");
+    return i->second;
+  }
+
+  const T& at(const key_type& key) const {
+    auto i = find(key);
+    if (i == end())
+      throw std::out_of_range("broker::detail::flat_map::at");
+    return i->second;
+  }
+
+  T& operator[](const key_type& key) {
+    return try_emplace(key).first->second;
+  }
+
+  T& operator[](key_type&& key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  // -- iterator access --------------------------------------------------------
+
+  iterator begin() noexcept {
+    return iterator{xs_.begin()};
+  }
+
+  const_iterator begin() const noexcept {
+    return const_iterator{xs_.begin()};
+  }
+
+  iterator end() noexcept {
+    return iterator{xs_.end()};
+  }
+
+  const_iterator end() const noexcept {
+    return const_iterator{xs_.end()};
+  }
+
+  const_iterator cbegin() const noexcept {
+    return begin();
+  }
+
+  const_iterator cend() const noexcept {
+    return end();
+  }
+
+  reverse_iterator rbegin() noexcept {
+    return reverse_iterator{end()};
+  }
+
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator{end()};
+  }
+
+  reverse_iterator rend() noexcept {
+    return reverse_iterator{begin()};
+  }
+
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator{begin()};
+  }
+
+  const_reverse_iterator crbegin() const noexcept {
+    return rbegin();
+  }
+
+  const_reverse_iterator crend() const noexcept {
+    return rend();
+  }
+
+  // -- capacity ---------------------------------------------------------------
+
+  bool empty() const noexcept {
+    return xs_.empty();
+  }
+
+  size_type size() const noexcept {
+    return xs_.size();
+  }
+
+  size_type max_size() const noexcept {
+    return xs_.max_size();
+  }
+
+  size_type capacity() const noexcept {
+    return xs_.capacity();
+  }
+
+  void reserve(size_type n) {
+    xs_.reserve(n);
+  }
+
+  void shrink_to_fit() {
+    xs_.shrink_to_fit();
+  }
+
+  // -- modifiers --------------------------------------------------------------
+
+  void clear() noexcept {
+    xs_.clear();
+  }
+
+  std::pair<iterator, bool> insert(const value_type& x) {
+    return insert_unique(x);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& x) {
+    return insert_unique(std::move(x));
+  }
+
+  /// Converts `x` to a pair with a mutable key first, which allows moving the
+  /// key into the map.
+  template <class P, class = std::enable_if_t<
+                       std::is_constructible<stored_type, P&&>::value>>
+  std::pair<iterator, bool> insert(P&& x) {
+    return insert_unique(stored_type(std::forward<P>(x)));
+  }
+
+  /// Inserts `x` at `hint` if possible. Appending sorted pairs via
+  /// `insert(end(), x)` runs in constant time.
+  iterator insert(const_iterator hint, const value_type& x) {
+    return insert_hint(hint, x);
+  }
+
+  iterator insert(const_iterator hint, value_type&& x) {
+    return insert_hint(hint, std::move(x));
+  }
+
+  /// Inserts all pairs from a range at once, sorting only the new pairs
+  /// before merging them into the map.
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    auto n = static_cast<difference_type>(xs_.size());
+    xs_.insert(xs_.end(), first, last);
+    auto mid = xs_.begin() + n;
+    std::stable_sort(mid, xs_.end(), pair_less());
+    std::inplace_merge(xs_.begin(), mid, xs_.end(), pair_less());
+    remove_duplicates();
+  }
+
+  void insert(std::initializer_list<value_type> init) {
+    insert(init.begin(), init.end());
+  }
+
+  template <class... Ts>
+  std::pair<iterator, bool> emplace(Ts&&... xs) {
+    return insert_unique(stored_type(std::forward<Ts>(xs)...));
+  }
+
+  template <class... Ts>
+  iterator emplace_hint(const_iterator hint, Ts&&... xs) {
+    return insert_hint(hint, stored_type(std::forward<Ts>(xs)...));
+  }
+
+  /// Inserts a new pair with a value constructed from `xs` unless the map
+  /// already contains `key`.
+  template <class K, class... Ts>
+  std::pair<iterator, bool> try_emplace(K&& key, Ts&&... xs) {
+    auto i = lower_bound(key);
+    if (i != end() && !cmp()(key, i->first))
+      return {i, false};
+    auto j = xs_.emplace(i.base(), std::piecewise_construct,
+                         std::forward_as_tuple(std::forward<K>(key)),
+                         std::forward_as_tuple(std::forward<Ts>(xs)...));
+    return {iterator{j}, true};
+  }
+
+  /// Assigns `x` to the value at `key`, inserting a new pair if necessary.
+  template <class K, class U>
+  std::pair<iterator, bool> insert_or_assign(K&& key, U&& x) {
+    auto i = lower_bound(key);
+    if (i != end() && !cmp()(key, i->first)) {
+      i->second = std::forward<U>(x);
+      return {i, false};
+    }
+    auto j = xs_.emplace(i.base(), std::forward<K>(key), std::forward<U>(x));
+    return {iterator{j}, true};
+  }
+
+  iterator erase(iterator pos) {
+    return iterator{xs_.erase(pos.base())};
+  }
+
+  iterator erase(const_iterator pos) {
+    return iterator{xs_.erase(pos.base())};
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    return iterator{xs_.erase(first.base(), last.base())};
+  }
+
+  size_type erase(const key_type& key) {
+    auto i = find(key);
+    if (i == end())
+      return 0;
+    xs_.erase(i.base());
+    return 1;
+  }
+
+  void swap(flat_map& other) {
+    using std::swap;
+    swap(xs_, other.xs_);
+    swap(static_cast<Compare&>(*this), static_cast<Compare&>(other));
+  }
+
+  // -- lookup -----------------------------------------------------------------
+
+  size_type count(const key_type& key) const {
+    return find(key) != end() ? 1 : 0;
+  }
+
+  iterator find(const key_type& key) {
+    auto i = lower_bound(key);
+    return i != end() && !cmp()(key, i->first) ? i : end();
+  }
+
+  const_iterator find(const key_type& key) const {
+    auto i = lower_bound(key);
+    return i != end() && !cmp()(key, i->first) ? i : end();
+  }
+
+  iterator lower_bound(const key_type& key) {
+    return std::lower_bound(begin(), end(), key, key_less());
+  }
+
+  const_iterator lower_bound(const key_type& key) const {
+    return std::lower_bound(begin(), end(), key, key_less());
+  }
+
+  iterator upper_bound(const key_type& key) {
+    return std::upper_bound(begin(), end(), key, key_greater());
+  }
+
+  const_iterator upper_bound(const key_type& key) const {
+    return std::upper_bound(begin(), end(), key, key_greater());
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& key) {
+    return {lower_bound(key), upper_bound(key)};
+  }
+
+  std::pair<const_iterator, const_iterator>
+  equal_range(const key_type& key) const {
+    return {lower_bound(key), upper_bound(key)};
+  }
+
+  // -- observers --------------------------------------------------------------
+
+  key_compare key_comp() const {
+    return cmp();
+  }
+
+  value_compare value_comp() const {
+    return value_compare{cmp()};
+  }
+
+  /// Returns the vector that stores all pairs sorted by key.
+  const container_type& container() const noexcept {
+    return xs_;
+  }
+
+  // -- inspection -------------------------------------------------------------
+
+  /// Uses the same format as `std::map`, i.e., a sequence of key-value pairs.
+  template <class Inspector>
+  friend typename Inspector::result_type inspect(Inspector& f, flat_map& x) {
+    // Restores the invariant in case the source did not sort the pairs.
+    auto load = caf::meta::load_callback([&]() -> caf::error {
+      x.normalize();
+      return caf::none;
+    });
+    return f(x.xs_, load);
+  }
+
+private:
+  static_assert(sizeof(stored_type) == sizeof(value_type)
+                  && alignof(stored_type) == alignof(value_type),
+                "flat_map_iterator requires identical layouts");
+
+  /// Stores the comparator as base class to avoid wasting space on stateless
+  /// comparators.
+  const Compare& cmp() const noexcept {
+    return *this;
+  }
+
+  /// Orders the pairs in `xs_` by their key.
+  auto pair_less() const {
+    return [this](const stored_type& x, const stored_type& y) {
+      return cmp()(x.first, y.first);
+    };
+  }
+
+  auto key_less() const {
+    return [this](const value_type& x, const key_type& key) {
+      return cmp()(x.first, key);
+    };
+  }
+
+  auto key_greater() const {
+    return [this](const key_type& key, const value_type& x) {
+      return cmp()(key, x.first);
+    };
+  }
+
+  template <class U>
+  std::pair<iterator, bool> insert_unique(U&& x) {
+    auto i = lower_bound(x.first);
+    if (i != end() && !cmp()(x.first, i->first))
+      return {i, false};
+    return {iterator{xs_.insert(i.base(), std::forward<U>(x))}, true};
+  }
+
+  template <class U>
+  iterator insert_hint(const_iterator hint, U&& x) {
+    if ((hint == cbegin() || cmp()(std::prev(hint)->first, x.first))
+        && (hint == cend() || cmp()(x.first, hint->first)))
+      return iterator{xs_.insert(hint.base(), std::forward<U>(x))};
+    return insert_unique(std::forward<U>(x)).first;
+  }
+
+  /// Sorts the pairs and removes duplicate keys unless `xs_` already is
+  /// strictly ordered.
+  void normalize() {
+    auto not_less = [this](const stored_type& x, const stored_type& y) {
+      return !cmp()(x.first, y.first);
+    };
+    if (std::adjacent_find(xs_.begin(), xs_.end(), not_less) == xs_.end())
+      return;
+    std::stable_sort(xs_.begin(), xs_.end(), pair_less());
+    remove_duplicates();
+  }
+
+  /// Removes all but the first of several pairs with equivalent keys from the
+  /// sorted vector.
+  void remove_duplicates() {
+    auto equivalent = [this](const stored_type& x, const stored_type& y) {
+      return !cmp()(x.first, y.first);
+    };
+    xs_.erase(std::unique(xs_.begin(), xs_.end(), equivalent), xs_.end());
+  }
+
+  container_type xs_;
+};
+
+// -- comparison operators -----------------------------------------------------
+
+/// @relates flat_map
+template <class Key, class T, class Compare>
+bool operator==(const flat_map<Key, T, Compare>& x,
+                const flat_map<Key, T, Compare>& y) {
+  return x.container() == y.container();
+}
+
+/// @relates flat_map
+template <class Key, class T, class Compare>
+bool operator!=(const flat_map<Key, T, Compare>& x,
+                const flat_map<Key, T, Compare>& y) {
+  return !(x == y);
+}
+
+/// @relates flat_map
+template <class Key, class T, class Compare>
+bool operator<(const flat_map<Key, T, Compare>& x,
+               const flat_map<Key, T, Compare>& y) {
+  return x.container() < y.container();
+}
+
+/// @relates flat_map
+template <class Key, class T, class Compare>
+bool operator<=(const flat_map<Key, T, Compare>& x,
+                const flat_map<Key, T, Compare>& y) {
+  return !(y < x);
+}
+
+/// @relates flat_map
+template <class Key, class T, class Compare>
+bool operator>(const flat_map<Key, T, Compare>& x,
+               const flat_map<Key, T, Compare>& y) {
+  return y < x;
+}
+
+/// @relates flat_map
+template <class Key, class T, class Compare>
+bool operator>=(const flat_map<Key, T, Compare>& x,
+                const flat_map<Key, T, Compare>& y) {
+  return !(x < y);
+}
+
+/// @relates flat_map
+template <class Key, class T, class Compare>
+void swap(flat_map<Key, T, Compare>& x, flat_map<Key, T, Compare>& y) {
+  x.swap(y);
+}
+
+} // namespace detail
+} // namespace broker
@@ -0,0 +1,361 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <caf/error.hpp>
+#include <caf/meta/load_callback.hpp>
+
+namespace broker {
+namespace detail {
+
+/// An associative, ordered container of unique keys that keeps its elements
+/// in a sorted vector. Provides the interface of `std::set`, but stores all
+/// elements in contiguous memory. Inserting or erasing elements invalidates
+/// all iterators.
+template <class T, class Compare = std::less<T>>
+class flat_set : private Compare {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using container_type = std::vector<T>;
+
+  using key_type = T;
+
+  using value_type = T;
+
+  using key_compare = Compare;
+
+  using value_compare = Compare;
+
+  using size_type = typename container_type::size_type;
+
+  using difference_type = typename container_type::difference_type;
+
+  using reference = value_type&;
+
+  using const_reference = const value_type&;
+
+  using pointer = value_type*;
+
+  using const_pointer = const value_type*;
+
+  /// Elements are immutable, since modifying them could break the order.
+  using iterator = typename container_type::const_iterator;
+
+  using const_iterator = typename container_type::const_iterator;
+
+  using reverse_iterator = typename container_type::const_reverse_iterator;
+
+  using const_reverse_iterator = typename container_type::const_reverse_iterator;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  flat_set() = default;
+
+  explicit flat_set(const Compare& cmp) : Compare(cmp) {
+    // nop
+  }
+
+  /// Constructs the set from an unsorted range. Keeps the first of several
+  /// equivalent elements.
+  template <class InputIterator>
+  flat_set(InputIterator first, InputIterator last,
+           const Compare& cmp = Compare())
+    : Compare(cmp), xs_(first, last) {
+    normalize();
+  }
+
+  flat_set(std::initializer_list<value_type> init,
+           const Compare& cmp = Compare())
+    : flat_set(init.begin(), init.end(), cmp) {
+    // nop
+  }
+
+  flat_set& operator=(std::initializer_list<value_type> init) {
+    xs_.assign(init.begin(), init.end());
+    normalize();
+    return *this;
+  }
+
+  // -- iterator access --------------------------------------------------------
+
+  const_iterator begin() const noexcept {
+    return xs_.begin();
+  }
+
+  const_iterator end() const noexcept {
+    return xs_.end();
+  }
+
+  const_iterator cbegin() const noexcept {
+    return xs_.cbegin();
+  }
+
+  const_iterator cend() const noexcept {
+    return xs_.cend();
+  }
+
+  const_reverse_iterator rbegin() const noexcept {
+    return xs_.rbegin();
+  }
+
+  const_reverse_iterator rend() const noexcept {
+    return xs_.rend();
+  }
+
+  const_reverse_iterator crbegin() const noexcept {
+    return xs_.crbegin();
+  }
+
+  const_reverse_iterator crend() const noexcept {
+    return xs_.crend();
+  }
+
+  // -- capacity ---------------------------------------------------------------
+
+  bool empty() const noexcept {
+    return xs_.empty();
+  }
+
+  size_type size() const noexcept {
+    return xs_.size();
+  }
+
+  size_type max_size() const noexcept {
+    return xs_.max_size();
+  }
+
+  size_type capacity() const noexcept {
+    return xs_.capacity();
+  }
+
+  void reserve(size_type n) {
+    xs_.reserve(n);
+  }
+
+  void shrink_to_fit() {
+    xs_.shrink_to_fit();
+  }
+
+  // -- modifiers --------------------------------------------------------------
+
+  void clear() noexcept {
+    xs_.clear();
+  }
+
+  std::pair<iterator, bool> insert(const value_type& x) {
+    return insert_unique(x);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& x) {
+    return insert_unique(std::move(x));
+  }
+
+  /// Inserts `x` at `hint` if possible. Appending sorted elements via
+  /// `insert(end(), x)` runs in constant time.
+  iterator insert(const_iterator hint, const value_type& x) {
+    return insert_hint(hint, x);
+  }
+
+  iterator insert(const_iterator hint, value_type&& x) {
+    return insert_hint(hint, std::move(x));
+  }
+
+  /// Inserts all elements from a range at once, sorting only the new
+  /// elements before merging them into the set.
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    auto n = static_cast<difference_type>(xs_.size());
+    xs_.insert(xs_.end(), first, last);
+    auto mid = xs_.begin() + n;
+    std::stable_sort(mid, xs_.end(), cmp());
+    std::inplace_merge(xs_.begin(), mid, xs_.end(), cmp());
+    remove_duplicates();
+  }
+
+  void insert(std::initializer_list<value_type> init) {
+    insert(init.begin(), init.end());
+  }
+
+  template <class... Ts>
+  std::pair<iterator, bool> emplace(Ts&&... xs) {
+    return insert_unique(value_type(std::forward<Ts>(xs)...));
+  }
+
+  template <class... Ts>
+  iterator emplace_hint(const_iterator hint, Ts&&... xs) {
+    return insert_hint(hint, value_type(std::forward<Ts>(xs)...));
+  }
+
+  iterator erase(const_iterator pos) {
+    return xs_.erase(pos);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    return xs_.erase(first, last);
+  }
+
+  size_type erase(const key_type& key) {
+    auto i = find(key);
+    if (i == end())
+      return 0;
+    xs_.erase(i);
+    return 1;
+  }
+
+  void swap(flat_set& other) {
+    using std::swap;
+    swap(xs_, other.xs_);
+    swap(static_cast<Compare&>(*this), static_cast<Compare&>(other));
+  }
+
+  // -- lookup -----------------------------------------------------------------
+
+  size_type count(const key_type& key) const {
+    return find(key) != end() ? 1 : 0;
+  }
+
+  const_iterator find(const key_type& key) const {
+    auto i = lower_bound(key);
+    return i != end() && !cmp()(key, *i) ? i : end();
+  }
+
+  const_iterator lower_bound(const key_type& key) const {
+    return std::lower_bound(begin(), end(), key, cmp());
+  }
+
+  const_iterator upper_bound(const key_type& key) const {
+    return std::upper_bound(begin(), end(), key, cmp());
+  }
+
+  std::pair<const_iterator, const_iterator>
+  equal_range(const key_type& key) const {
+    return std::equal_range(begin(), end(), key, cmp());
+  }
+
+  // -- observers --------------------------------------------------------------
+
+  key_compare key_comp() const {
+    return cmp();
+  }
+
+  value_compare value_comp() const {
+    return cmp();
+  }
+
+  /// Returns the sorted vector that stores all elements.
+  const container_type& container() const noexcept {
+    return xs_;
+  }
+
+  // -- inspection -------------------------------------------------------------
+
+  /// Uses the same format as `std::set`, i.e., a sequence of elements.
+  template <class Inspector>
+  friend typename Inspector::result_type inspect(Inspector& f, flat_set& x) {
+    // Restores the invariant in case the source did not sort the elements.
+    auto load = caf::meta::load_callback([&]() -> caf::error {
+      x.normalize();
+      return caf::none;
+    });
+    return f(x.xs_, load);
+  }
+
+private:
+  /// Stores the comparator as base class to avoid wasting space on stateless
+  /// comparators.
+  const Compare& cmp() const noexcept {
+    return *this;
+  }
+
+  template <class U>
+  std::pair<iterator, bool> insert_unique(U&& x) {
+    auto i = std::lower_bound(xs_.begin(), xs_.end(), x, cmp());
+    if (i != xs_.end() && !cmp()(x, *i))
+      return {i, false};
+    return {xs_.insert(i, std::forward<U>(x)), true};
+  }
+
+  template <class U>
+  iterator insert_hint(const_iterator hint, U&& x) {
+    if ((hint == begin() || cmp()(*std::prev(hint), x))
+        && (hint == end() || cmp()(x, *hint)))
+      return xs_.insert(hint, std::forward<U>(x));
+    return insert_unique(std::forward<U>(x)).first;
+  }
+
+  /// Sorts the elements and removes duplicates unless `xs_` already is
+  /// strictly ordered.
+  void normalize() {
+    auto not_less = [this](const value_type& x, const value_type& y) {
+      return !cmp()(x, y);
+    };
+    if (std::adjacent_find(xs_.begin(), xs_.end(), not_less) == xs_.end())
+      return;
+    std::stable_sort(xs_.begin(), xs_.end(), cmp());
+    remove_duplicates();
+  }
+
+  /// Removes all but the first of several equivalent elements from the sorted
+  /// vector.
+  void remove_duplicates() {
+    auto equivalent = [this](const value_type& x, const value_type& y) {
+      return !cmp()(x, y);
+    };
+    xs_.erase(std::unique(xs_.begin(), xs_.end(), equivalent), xs_.end());
+  }
+
+  container_type xs_;
+};
+
+// -- comparison operators -----------------------------------------------------
+
+/// @relates flat_set
+template <class T, class Compare>
+bool operator==(const flat_set<T, Compare>& x, const flat_set<T, Compare>& y) {
+  return x.container() == y.container();
+}
+
+/// @relates flat_set
+template <class T, class Compare>
+bool operator!=(const flat_set<T, Compare>& x, const flat_set<T, Compare>& y) {
+  return !(x == y);
+}
+
+/// @relates flat_set
+template <class T, class Compare>
+bool operator<(const flat_set<T, Compare>& x, const flat_set<T, Compare>& y) {
+  return x.container() < y.container();
+}
+
+/// @relates flat_set
+template <class T, class Compare>
+bool operator<=(const flat_set<T, Compare>& x, const flat_set<T, Compare>& y) {
+  return !(y < x);
+}
+
+/// @relates flat_set
+template <class T, class Compare>
+bool operator>(const flat_set<T, Compare>& x, const flat_set<T, Compare>& y) {
+  return y < x;
+}
+
+/// @relates flat_set
+template <class T, class Compare>
+bool operator>=(const flat_set<T, Compare>& x, const flat_set<T, Compare>& y) {
+  return !(x < y);
+}
+
+/// @relates flat_set
+template <class T, class Compare>
+void swap(flat_set<T, Compare>& x, flat_set<T, Compare>& y) {
+  x.swap(y);
+}
+
+} // namespace detail
+} // namespace broker
@@ -1,14 +1,119 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 
 namespace broker {
 namespace detail {
 
+// -- mixing and hashing of byte sequences -------------------------------------
+
+// The functions in this section follow wyhash: a 64x64 bit multiplication
+// mixes two words into a 128-bit product and the halves of the product get
+// folded into the result. This needs only a few instructions per 16 bytes of
+// input.
+
+/// Constants for seeding the mixing function.
+constexpr uint64_t hash_secret[] = {
+  0xa0761d6478bd642full,
+  0xe7037ed1a0b428dbull,
+  0x8ebc6af09c88c6e3ull,
+  0x589965cc75374cc3ull,
+};
+
+/// Multiplies `x` and `y` and folds the 128-bit product into 64 bits.
+inline uint64_t hash_mix(uint64_t x, uint64_t y) noexcept {
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 uint128;
+  auto r = static_cast<uint128>(x) * y;
+  return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#else
+  uint64_t xh = x >> 32;
+  uint64_t yh = y >> 32;
+  uint64_t xl = static_cast<uint32_t>(x);
+  uint64_t yl = static_cast<uint32_t>(y);
+  uint64_t hh = xh * yh;
+  uint64_t hl = xh * yl;
+  uint64_t lh = xl * yh;
+  uint64_t ll = xl * yl;
+  uint64_t t = ll + (hl << 32);
+  uint64_t carry = t < ll;
+  uint64_t lo = t + (lh << 32);
+  carry += lo < t;
+  uint64_t hi = hh + (hl >> 32) + (lh >> 32) + carry;
+  return lo ^ hi;
+#endif
+}
+
+/// Reads 8 bytes from `ptr`.
+inline uint64_t hash_read8(const uint8_t* ptr) noexcept {
+  uint64_t result;
+  memcpy(&result, ptr, sizeof(result));
+  return result;
+}
+
+/// Reads 4 bytes from `ptr`.
+inline uint64_t hash_read4(const uint8_t* ptr) noexcept {
+  uint32_t result;
+  memcpy(&result, ptr, sizeof(result));
+  return result;
+}
+
+/// Computes a 64-bit hash for `size` bytes at `buf`.
+inline uint64_t hash_bytes(const void* buf, size_t size,
+                           uint64_t seed = 0) noexcept {
+  auto p = static_cast<const uint8_t*>(buf);
+  auto& s = hash_secret;
+  seed ^= hash_mix(seed ^ s[0], s[1]);
+  uint64_t a = 0;
+  uint64_t b = 0;
+  if (size <= 16) {
+    if (size >= 4) {
+      auto offset = (size >> 3) << 2;
+      a = (hash_read4(p) << 32) | hash_read4(p + offset);
+      b = (hash_read4(p + size - 4) << 32)
+          | hash_read4(p + size - 4 - offset);
+    } else if (size > 0) {
+      a = (uint64_t{p[0]} << 16) | (uint64_t{p[size >> 1]} << 8)
+          | p[size - 1];
+    }
+  } else {
+    auto i = size;
+    if (i > 48) {
+      auto seed1 = seed;
+      auto seed2 = seed;
+      do {
+        seed = hash_mix(hash_read8(p) ^ s[1], hash_read8(p + 8) ^ seed);
+        seed1 = hash_mix(hash_read8(p + 16) ^ s[2],
+                         hash_read8(p + 24) ^ seed1);
+        seed2 = hash_mix(hash_read8(p + 32) ^ s[3],
+                         hash_read8(p + 40) ^ seed2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (i > 16) {
+      seed = hash_mix(hash_read8(p) ^ s[1], hash_read8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = hash_read8(p + i - 16);
+    b = hash_read8(p + i - 8);
+  }
+  return hash_mix(s[1] ^ size, hash_mix(a ^ s[1], b ^ seed));
+}
+
+// -- combining hashes ---------------------------------------------------------
+
 /// Calculate hash for an object and combine with a provided hash.
 template <class T>
 inline void hash_combine(size_t& seed, const T& v) {
-  seed ^= std::hash<T>()(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  auto h = static_cast<uint64_t>(std::hash<T>()(v));
+  seed = static_cast<size_t>(hash_mix(seed ^ hash_secret[0],
+                                      h ^ hash_secret[1]));
 }
 
 template <class It>
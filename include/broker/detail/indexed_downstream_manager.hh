@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include <caf/broadcast_downstream_manager.hpp>
+#include <caf/error.hpp>
+#include <caf/make_counted.hpp>
+#include <caf/outbound_path.hpp>
+#include <caf/stream_slot.hpp>
+
+#include "broker/detail/batching_controller.hh"
+#include "broker/detail/filter_index.hh"
+#include "broker/filter_type.hh"
+#include "broker/message.hh"
+#include "broker/peer_filter.hh"
+
+namespace broker {
+namespace detail {
+
+/// @relates indexed_downstream_manager
+inline const filter_type& filter_topics(const filter_type& x) {
+  return x;
+}
+
+/// @relates indexed_downstream_manager
+inline const filter_type& filter_topics(const peer_filter& x) {
+  return x.second;
+}
+
+/// Prepares `x` for getting copied to multiple paths. Elements for local
+/// actors never leave the process, i.e., there is nothing to prepare.
+/// @relates indexed_downstream_manager
+template <class T>
+void prepare_fan_out(T&) {
+  // nop
+}
+
+/// Attaches a serialization cache to `x` that all copies of `x` share. This
+/// makes sure that we encode the content only once, regardless of the number
+/// of peers receiving the message.
+/// @relates indexed_downstream_manager
+inline void prepare_fan_out(node_message& x) {
+  if (x.cache == nullptr)
+    x.cache = caf::make_counted<payload_cache>();
+}
+
+/// Appends `x` to the buffer of a path. Local actors receive only one type of
+/// message, i.e., their paths have a single lane.
+/// @relates indexed_downstream_manager
+template <class Buffer, class T>
+void enqueue(Buffer& bulk, Buffer&, const T& x, bool) {
+  bulk.emplace_back(x);
+}
+
+/// Appends `x` to one of the buffers of a peer. With `priority_lanes` set,
+/// store commands go to the `control` lane, which the manager drains before
+/// shipping anything from the `bulk` lane. Each lane keeps its own order.
+/// @relates indexed_downstream_manager
+template <class Buffer>
+void enqueue(Buffer& bulk, Buffer& control, const node_message& x,
+             bool priority_lanes) {
+  if (priority_lanes && is_command_message(x))
+    control.emplace_back(x);
+  else
+    bulk.emplace_back(x);
+}
+
+/// A broadcast downstream manager that dispatches elements to its paths via a
+/// `filter_index` instead of testing each element against the filter of each
+/// path. The selector only checks conditions besides the topic by providing a
+/// member function `accepts(const Filter&)`.
+/// @note Modifying the topics of a filter via `filter(slot)` bypasses the
+///       index. Always use `set_filter` for changing subscriptions.
+template <class T, class Filter, class Select>
+class indexed_downstream_manager
+  : public caf::broadcast_downstream_manager<T, Filter, Select> {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using super = caf::broadcast_downstream_manager<T, Filter, Select>;
+
+  using index_type = filter_index<caf::stream_slot>;
+
+  using batching_settings = batching_controller::settings;
+
+  using path_buffer = std::remove_reference_t<
+    decltype(std::declval<super&>().states().begin()->second.buf)>;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  using super::super;
+
+  // -- filter management ------------------------------------------------------
+
+  /// Sets the filter for `slot` and updates the index.
+  void set_filter(caf::stream_slot slot, Filter filter) {
+    index_.update(slot, filter_topics(filter));
+    super::set_filter(slot, std::move(filter));
+  }
+
+  /// Returns the index for looking up paths by topic.
+  const index_type& index() const noexcept {
+    return index_;
+  }
+
+  /// Returns whether at least one path subscribed to `t`.
+  bool has_subscribers(const topic& t) {
+    return !index_.match(t).empty();
+  }
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns whether store commands overtake data messages in path buffers.
+  bool priority_lanes() const noexcept {
+    return priority_lanes_;
+  }
+
+  /// Enables or disables priority lanes for all paths.
+  void priority_lanes(bool value) noexcept {
+    priority_lanes_ = value;
+  }
+
+  /// Returns the number of elements in the control lane of `slot`.
+  size_t control_buffered(caf::stream_slot slot) const noexcept {
+    auto i = control_.find(slot);
+    return i != control_.end() ? i->second.size() : 0u;
+  }
+
+  /// Returns whether batch sizes adapt to the observed traffic.
+  bool adaptive_batching() const noexcept {
+    return adaptive_batching_;
+  }
+
+  /// Lets batch sizes adapt to the observed traffic on each path.
+  void adaptive_batching(batching_settings targets) noexcept {
+    batching_ = targets;
+    adaptive_batching_ = true;
+  }
+
+  /// Returns the targets for adaptive batching.
+  const batching_settings& batching() const noexcept {
+    return batching_;
+  }
+
+  /// Returns the controller for `slot` or `nullptr` if the path did not emit
+  /// any batch yet or adaptive batching is disabled.
+  const batching_controller* controller(caf::stream_slot slot) const {
+    auto i = controllers_.find(slot);
+    return i != controllers_.end() ? &i->second : nullptr;
+  }
+
+  // -- overridden member functions --------------------------------------------
+
+  /// Moves elements from the central buffer to the buffers of all paths with
+  /// a matching filter. Hides the linear-scan implementation of the base type.
+  void fan_out_flush() {
+    auto& buf = this->buf_;
+    auto& states = this->states();
+    if (buf.empty() || states.empty())
+      return;
+    auto& select = this->selector();
+    for (auto& piece : buf) {
+      auto& slots = index_.match(get_topic(piece));
+      if (slots.size() > 1)
+        prepare_fan_out(piece);
+      for (auto slot : slots) {
+        auto i = states.find(slot);
+        if (i == states.end())
+          continue;
+        // Don't push new data into a closing path.
+        auto path = this->path(slot);
+        if (path == nullptr || path->closing)
+          continue;
+        auto& st = i->second;
+        if (!select.accepts(st.filter))
+          continue;
+        // Without priority lanes, everything goes to the bulk lane. Hence,
+        // we only create control lanes when actually using them.
+        if (priority_lanes_)
+          enqueue(st.buf, control_[slot], piece, true);
+        else
+          st.buf.emplace_back(piece);
+      }
+    }
+    buf.clear();
+  }
+
+  void emit_batches() override {
+    fan_out_flush();
+    emit_paths(false);
+  }
+
+  void force_emit_batches() override {
+    fan_out_flush();
+    emit_paths(true);
+  }
+
+  size_t buffered() const noexcept override {
+    size_t max_path_buf = 0;
+    for (auto& kvp : this->states())
+      max_path_buf = std::max(max_path_buf, kvp.second.buf.size()
+                                              + control_buffered(kvp.first));
+    return this->buf_.size() + max_path_buf;
+  }
+
+  size_t buffered(caf::stream_slot slot) const noexcept override {
+    return super::buffered(slot) + control_buffered(slot);
+  }
+
+protected:
+  void about_to_erase(caf::outbound_path* ptr, bool silent,
+                      caf::error* reason) override {
+    index_.erase(ptr->slots.sender);
+    controllers_.erase(ptr->slots.sender);
+    control_.erase(ptr->slots.sender);
+    super::about_to_erase(ptr, silent, reason);
+  }
+
+private:
+  /// Ships batches from the buffers of all paths. Replaces the implementation
+  /// of the base type, since `fan_out_flush` already emptied the central
+  /// buffer. Paths ship their control lane first and start on the bulk lane
+  /// only after the control lane ran empty. With adaptive batching, the
+  /// controller of each path overrides the batch size and decides when to
+  /// ship underfull batches.
+  void emit_paths(bool force_underfull) {
+    auto now = this->self()->clock().now();
+    auto& states = this->states();
+    for (auto& kvp : this->paths_) {
+      auto i = states.find(kvp.first);
+      if (i == states.end())
+        continue;
+      auto path = kvp.second.get();
+      auto& buf = i->second.buf;
+      auto j = control_.find(kvp.first);
+      auto* control = j != control_.end() ? &j->second : nullptr;
+      auto queued = [&] {
+        return buf.size() + (control != nullptr ? control->size() : 0u);
+      };
+      auto force = force_underfull || path->closing;
+      batching_controller* ctl = nullptr;
+      if (adaptive_batching_) {
+        ctl = &controllers_[kvp.first];
+        ctl->before_emit(now, queued(), path->open_credit);
+        path->desired_batch_size = ctl->batch_size(batching_,
+                                                   path->desired_batch_size);
+        force = force || ctl->flush(batching_, now);
+      }
+      // Store commands are latency-sensitive, i.e., never hold them back in
+      // order to fill up a batch.
+      if (control != nullptr && !control->empty())
+        path->emit_batches(this->self(), *control, true);
+      if (control == nullptr || control->empty())
+        path->emit_batches(this->self(), buf, force);
+      if (ctl != nullptr)
+        ctl->after_emit(now, queued(), path->open_credit);
+    }
+  }
+
+  /// Maps topic prefixes to the paths subscribed to them.
+  index_type index_;
+
+  /// Lets store commands overtake data messages if set.
+  bool priority_lanes_ = false;
+
+  /// Lets controllers override batch sizes if set.
+  bool adaptive_batching_ = false;
+
+  /// Targets for all controllers.
+  batching_settings batching_;
+
+  /// Stores the control lane of each path. Only holds store commands while
+  /// priority lanes are enabled.
+  std::unordered_map<caf::stream_slot, path_buffer> control_;
+
+  /// Estimates traffic and sizes batches per path.
+  std::unordered_map<caf::stream_slot, batching_controller> controllers_;
+};
+
+} // namespace detail
+} // namespace broker
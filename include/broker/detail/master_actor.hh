@@ -1,11 +1,14 @@
 #pragma once
 
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <caf/actor.hpp>
 #include <caf/behavior.hpp>
 #include <caf/stateful_actor.hpp>
 #include <caf/event_based_actor.hpp>
+#include <caf/stream_manager.hpp>
 
 #include "broker/data.hh"
 #include "broker/fwd.hh"
@@ -13,6 +16,9 @@
 #include "broker/topic.hh"
 #include "broker/endpoint.hh"
 
+#include "broker/detail/expiry_queue.hh"
+#include "broker/detail/replication_log.hh"
+
 namespace broker {
 namespace detail {
 
@@ -31,25 +37,55 @@ public:
 
   /// Initializes the object.
   void init(caf::event_based_actor* ptr, std::string&& nm,
-            backend_pointer&& bp, caf::actor&& parent, endpoint::clock* clock);
+            backend_pointer&& bp, caf::actor&& parent, size_t max_log_size,
+            endpoint::clock* clock);
 
-  /// Sends `x` to all clones.
+  /// Assigns the next sequence number to `x`, adds it to the replication log,
+  /// and sends it to all clones. Numbers commands even without any clones,
+  /// because disconnected clones may come back later. Inside a batch, holds
+  /// back `x` until the backend committed the batch.
   void broadcast(internal_command&& x);
 
+  /// Broadcasts all commands in `xs` to the clones with a single message.
+  void broadcast(std::vector<internal_command>&& xs);
+
   template <class T>
   void broadcast_cmd_to_clones(T cmd) {
-    if (!clones.empty())
-      broadcast(internal_command{std::move(cmd)});
+    broadcast(internal_command{std::move(cmd)});
   }
 
+  /// Schedules the expiration of `key` after `expiry`, replacing any
+  /// previous expiration time of `key`.
   void remind(timespan expiry, const data& key);
 
-  void expire(data& key);
+  /// Makes sure that a tick for checking expirations is pending as long as
+  /// keys may expire.
+  void schedule_tick();
+
+  /// Expires all keys that reached their expiration time.
+  void tick();
+
+  /// Removes all expired keys in `keys` in a single backend batch and
+  /// broadcasts the resulting erase commands to the clones at once.
+  void expire(std::vector<data>& keys);
 
   void command(internal_command& cmd);
 
   void command(internal_command::variant_type& cmd);
 
+  /// Applies a batch of commands from the core in a single backend batch.
+  void command(std::vector<command_message>& xs);
+
+  /// Starts a batch of modifications on the backend. Applies modifications
+  /// one by one if the backend fails to start a batch.
+  void begin_batch();
+
+  /// Writes all modifications since `begin_batch` to the backend, then sends
+  /// the commands of the batch to the clones and replies to its requests.
+  /// Drops all commands of the batch if the backend fails to write it.
+  /// @returns `true` if the backend wrote all modifications of the batch.
+  bool commit_batch();
+
   void operator()(none);
 
   void operator()(put_command&);
@@ -82,6 +118,32 @@ public:
 
   std::unordered_map<caf::actor_addr, caf::actor> clones;
 
+  /// Recent commands for clones that reconnect after missing some updates.
+  /// Only numbers commands until the first clone attaches.
+  replication_log log;
+
+  /// Maximum size of `log` after the first clone attached.
+  size_t log_size = 0;
+
+  /// Consumes the stream of commands from the core.
+  caf::stream_manager_ptr sink;
+
+  /// Keeps track of the expiration times of all keys.
+  expiry_queue expirations;
+
+  /// Stores whether a tick for checking expirations is pending.
+  bool tick_scheduled = false;
+
+  /// Stores whether the backend currently collects modifications in a batch.
+  bool in_batch = false;
+
+  /// Commands for the clones that wait for the current batch to commit.
+  std::vector<internal_command> batch_commands;
+
+  /// Successful put_unique requests that wait for the current batch to
+  /// commit before receiving their reply.
+  std::vector<std::pair<caf::actor, request_id>> batch_inserts;
+
   endpoint::clock* clock;
 
   static const char* name;
@@ -90,7 +152,7 @@ public:
 caf::behavior master_actor(caf::stateful_actor<master_state>* self,
                            caf::actor core, std::string id,
                            master_state::backend_pointer backend,
-                           endpoint::clock* clock);
+                           size_t log_size, endpoint::clock* clock);
 
 } // namespace detail
 } // namespace broker
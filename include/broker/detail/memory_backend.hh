@@ -19,7 +19,7 @@ public:
   expected<void> put(const data& key, data value,
                      optional<timestamp> expiry) override;
 
-  expected<void> add(const data& key, const data& value, data::type init_type,
+  expected<void> add(const data& key, data value, data::type init_type,
                      optional<timestamp> expiry) override;
 
   expected<void> subtract(const data& key, const data& value,
@@ -45,6 +45,8 @@ public:
 
   expected<expirables> expiries() const override;
 
+  expected<backend_cursor_ptr> cursor() const override;
+
 private:
   backend_options options_;
   std::unordered_map<data, std::pair<data, optional<timestamp>>> store_;
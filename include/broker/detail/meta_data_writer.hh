@@ -24,7 +24,7 @@ public:
   }
 
   template <class K, class V>
-  caf::error operator()(const std::pair<const K, V>& x) {
+  caf::error operator()(const std::pair<K, V>& x) {
     BROKER_TRY((*this)(x.first));
     return (*this)(x.second);
   }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <caf/error.hpp>
+#include <caf/intrusive_ptr.hpp>
+#include <caf/ref_counted.hpp>
+
+namespace broker {
+namespace detail {
+
+/// Stores the serialized value of a ::node_message. All copies of a message
+/// share the same cache. Hence, forwarding a message to multiple peers (or
+/// forwarding a message that we have received from a peer) encodes its
+/// content only once.
+/// @note The cache assumes that the content of a message no longer changes
+///       after attaching the cache.
+class payload_cache : public caf::ref_counted {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using buffer_type = std::vector<char>;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  payload_cache() = default;
+
+  /// Constructs a cache from a previously encoded payload.
+  explicit payload_cache(buffer_type buf) {
+    std::call_once(flag_, [&] { buf_ = std::move(buf); });
+  }
+
+  payload_cache(const payload_cache&) = delete;
+
+  payload_cache& operator=(const payload_cache&) = delete;
+
+  // -- properties -------------------------------------------------------------
+
+  /// Encodes the payload by calling `encode(buf)` on first access. Once
+  /// `encode` fails, all subsequent calls return the same error.
+  template <class F>
+  caf::error get_or_encode(F encode) {
+    std::call_once(flag_, [&] { err_ = encode(buf_); });
+    return err_;
+  }
+
+  /// Returns a pointer to the encoded payload.
+  /// @pre The cache was constructed from an encoded payload or a previous
+  ///      call to `get_or_encode` succeeded.
+  const char* data() const noexcept {
+    return buf_.data();
+  }
+
+  /// Returns the size of the encoded payload.
+  /// @pre The cache was constructed from an encoded payload or a previous
+  ///      call to `get_or_encode` succeeded.
+  size_t size() const noexcept {
+    return buf_.size();
+  }
+
+private:
+  std::once_flag flag_;
+  buffer_type buf_;
+  caf::error err_;
+};
+
+/// @relates payload_cache
+using payload_cache_ptr = caf::intrusive_ptr<payload_cache>;
+
+} // namespace detail
+} // namespace broker
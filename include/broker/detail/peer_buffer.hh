@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <caf/error.hpp>
+#include <caf/fwd.hpp>
+
+#include "broker/message.hh"
+
+namespace broker {
+namespace detail {
+
+/// Buffers batches from a peer while the core blocks it. Keeps batches in
+/// memory up to a limit and appends further batches to a spill file. Drops
+/// batches once the spill file reaches its limit as well (or if spilling is
+/// disabled). After failing to open the spill file, the buffer drops all
+/// overflowing batches until draining it.
+class peer_buffer {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using batch = std::vector<node_message>;
+
+  /// Configures the capacity of a buffer.
+  struct limits {
+    /// Maximum number of bytes (estimated) for batches in memory.
+    size_t memory = 64 * 1024 * 1024;
+
+    /// Directory for spill files. An empty string disables spilling.
+    std::string spill_directory;
+
+    /// Maximum size of a spill file in bytes.
+    size_t spill = 1024 * 1024 * 1024;
+  };
+
+  /// Describes where `push` has put a batch, ordered by severity.
+  enum class push_result : uint8_t {
+    buffered,
+    spilled,
+    dropped,
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  explicit peer_buffer(limits cfg);
+
+  peer_buffer(const peer_buffer&) = delete;
+
+  peer_buffer& operator=(const peer_buffer&) = delete;
+
+  ~peer_buffer();
+
+  // -- buffering --------------------------------------------------------------
+
+  /// Adds `xs` to the buffer. Once a batch went to the spill file, all
+  /// following batches go to the spill file as well to preserve their order.
+  push_result push(caf::execution_unit* ctx, batch& xs);
+
+  /// Passes all buffered batches in their original order to `f` and resets
+  /// the buffer afterwards.
+  template <class F>
+  caf::error drain(caf::execution_unit* ctx, F f) {
+    for (auto& xs : memory_)
+      f(xs);
+    memory_.clear();
+    memory_usage_ = 0;
+    caf::error err;
+    if (spill_usage_ > 0) {
+      batch xs;
+      bool done = false;
+      while (!(err = read_spilled(ctx, xs, done)) && !done)
+        f(xs);
+    }
+    close_spill_file();
+    spill_failed_ = false;
+    size_ = 0;
+    return err;
+  }
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the number of buffered messages in memory and on disk.
+  size_t size() const noexcept {
+    return size_;
+  }
+
+  /// Returns the estimated number of bytes for batches in memory.
+  size_t memory_usage() const noexcept {
+    return memory_usage_;
+  }
+
+  /// Returns the size of the spill file.
+  size_t spill_usage() const noexcept {
+    return spill_usage_;
+  }
+
+  /// Returns the number of dropped messages since creating this buffer.
+  size_t dropped() const noexcept {
+    return dropped_;
+  }
+
+  /// Returns the most severe result of all calls to `push`, i.e., `dropped`
+  /// if `push` dropped any batch.
+  push_result worst_result() const noexcept {
+    return worst_result_;
+  }
+
+  /// Returns an estimate of the number of bytes for `x` in memory.
+  static size_t approx_size(const node_message& x);
+
+private:
+  /// Stores `xs` in memory or appends it to the spill file.
+  push_result push_impl(caf::execution_unit* ctx, batch& xs);
+
+  /// Appends `xs` to the spill file.
+  push_result spill(caf::execution_unit* ctx, batch& xs);
+
+  /// Reads the next batch from the spill file into `xs`. Sets `done` after
+  /// reading all batches.
+  caf::error read_spilled(caf::execution_unit* ctx, batch& xs, bool& done);
+
+  /// Closes and removes the spill file.
+  void close_spill_file();
+
+  limits cfg_;
+
+  std::vector<batch> memory_;
+
+  size_t memory_usage_ = 0;
+
+  std::fstream spill_file_;
+
+  std::string spill_file_name_;
+
+  size_t spill_usage_ = 0;
+
+  /// Stores whether `drain` started reading from the spill file.
+  bool reading_ = false;
+
+  /// Stores whether opening the spill file failed. Suppresses further
+  /// attempts until the next call to `drain`.
+  bool spill_failed_ = false;
+
+  size_t size_ = 0;
+
+  size_t dropped_ = 0;
+
+  push_result worst_result_ = push_result::buffered;
+};
+
+/// @relates peer_buffer
+const char* to_string(peer_buffer::push_result x);
+
+} // namespace detail
+} // namespace broker
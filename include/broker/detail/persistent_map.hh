@@ -0,0 +1,344 @@
+#pragma once
+
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace broker {
+namespace detail {
+
+/// An unordered associative container with constant-time copies. Stores its
+/// entries in a hash array mapped trie whose nodes copies share, i.e., a
+/// modification copies only the nodes on the path to the modified entry and
+/// leaves all other copies of the map untouched. Hence, a copy serves as
+/// immutable snapshot that remains valid while the original keeps changing.
+/// Nodes that are not shared with another copy get modified in place.
+/// @note Copies of a map are safe to read concurrently, but each individual
+///       map object requires external synchronization for modifications.
+template <class Key, class T, class Hash = std::hash<Key>,
+          class KeyEqual = std::equal_to<Key>>
+class persistent_map {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using key_type = Key;
+
+  using mapped_type = T;
+
+  using value_type = std::pair<const Key, T>;
+
+  using size_type = size_t;
+
+  using hasher = Hash;
+
+  using key_equal = KeyEqual;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  persistent_map() : size_(0) {
+    // nop
+  }
+
+  template <class InputIterator>
+  persistent_map(InputIterator first, InputIterator last) : persistent_map() {
+    for (; first != last; ++first)
+      emplace(first->first, first->second);
+  }
+
+  persistent_map(std::initializer_list<value_type> xs)
+    : persistent_map(xs.begin(), xs.end()) {
+    // nop
+  }
+
+  persistent_map(const persistent_map&) = default;
+
+  persistent_map(persistent_map&& other) noexcept
+    : root_(std::move(other.root_)),
+      size_(other.size_) {
+    other.size_ = 0;
+  }
+
+  persistent_map& operator=(const persistent_map&) = default;
+
+  persistent_map& operator=(persistent_map&& other) noexcept {
+    root_ = std::move(other.root_);
+    size_ = other.size_;
+    other.size_ = 0;
+    return *this;
+  }
+
+  // -- properties -------------------------------------------------------------
+
+  size_type size() const noexcept {
+    return size_;
+  }
+
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+  // -- lookup -----------------------------------------------------------------
+
+  /// Returns a pointer to the value for `key` or `nullptr` if the map has no
+  /// such key.
+  const T* find(const Key& key) const {
+    auto h = Hash{}(key);
+    const node* n = root_.get();
+    for (unsigned shift = 0; n != nullptr; shift += bits_per_level) {
+      if (shift >= hash_bits) {
+        for (auto& s : n->slots)
+          if (matches(*s.entry, h, key))
+            return &s.entry->kvp.second;
+        return nullptr;
+      }
+      auto bit = bit_of(h, shift);
+      if ((n->bitmap & bit) == 0)
+        return nullptr;
+      auto& s = n->slots[position(n->bitmap, bit)];
+      if (s.entry != nullptr)
+        return matches(*s.entry, h, key) ? &s.entry->kvp.second : nullptr;
+      n = s.child.get();
+    }
+    return nullptr;
+  }
+
+  bool contains(const Key& key) const {
+    return find(key) != nullptr;
+  }
+
+  /// Calls `f(key, value)` for each entry in unspecified order.
+  template <class F>
+  void for_each(F f) const {
+    if (root_ != nullptr)
+      for_each(*root_, f);
+  }
+
+  // -- modifiers --------------------------------------------------------------
+
+  /// Returns a pointer to the value for `key` that callers may modify or
+  /// `nullptr` if the map has no such key. Detaches the entry from all copies
+  /// of this map first.
+  T* find_mutable(const Key& key) {
+    if (!contains(key))
+      return nullptr;
+    auto h = Hash{}(key);
+    auto* ptr = &root_;
+    for (unsigned shift = 0;; shift += bits_per_level) {
+      auto n = own(*ptr);
+      if (shift >= hash_bits) {
+        for (auto& s : n->slots)
+          if (matches(*s.entry, h, key))
+            return &detach(s.entry)->kvp.second;
+        return nullptr; // unreachable
+      }
+      auto& s = n->slots[position(n->bitmap, bit_of(h, shift))];
+      if (s.entry != nullptr)
+        return &detach(s.entry)->kvp.second;
+      ptr = &s.child;
+    }
+  }
+
+  /// Inserts `value` for `key` unless the map already contains `key`.
+  /// @returns `true` if the map did not contain `key`, `false` otherwise.
+  bool emplace(Key key, T value) {
+    if (contains(key))
+      return false;
+    auto h = Hash{}(key);
+    insert(root_, 0, make_entry(h, std::move(key), std::move(value)));
+    ++size_;
+    return true;
+  }
+
+  /// Inserts `value` for `key` or replaces the previous value for `key`.
+  /// @returns `true` if the map did not contain `key`, `false` otherwise.
+  bool insert_or_assign(Key key, T value) {
+    if (auto x = find_mutable(key)) {
+      *x = std::move(value);
+      return false;
+    }
+    auto h = Hash{}(key);
+    insert(root_, 0, make_entry(h, std::move(key), std::move(value)));
+    ++size_;
+    return true;
+  }
+
+  /// Removes `key` from the map.
+  /// @returns `true` if the map contained `key`, `false` otherwise.
+  bool erase(const Key& key) {
+    if (!contains(key))
+      return false;
+    erase(root_, 0, Hash{}(key), key);
+    --size_;
+    return true;
+  }
+
+  void clear() noexcept {
+    root_.reset();
+    size_ = 0;
+  }
+
+  void swap(persistent_map& other) noexcept {
+    root_.swap(other.root_);
+    std::swap(size_, other.size_);
+  }
+
+private:
+  // -- trie layout ------------------------------------------------------------
+
+  /// Number of hash bits that select a slot at each level of the trie.
+  static constexpr unsigned bits_per_level = 6;
+
+  /// Number of bits in a hash value. Nodes below this depth store colliding
+  /// entries in an unordered list.
+  static constexpr unsigned hash_bits = sizeof(size_t) * 8;
+
+  struct entry {
+    size_t hash;
+    value_type kvp;
+  };
+
+  struct node;
+
+  using entry_ptr = std::shared_ptr<entry>;
+
+  using node_ptr = std::shared_ptr<node>;
+
+  /// Holds either a single entry or a subtree.
+  struct slot {
+    node_ptr child;
+    entry_ptr entry;
+  };
+
+  struct node {
+    /// Marks the occupied slots of this level.
+    uint64_t bitmap = 0;
+
+    /// Stores one slot per set bit in `bitmap`, ordered by bit position.
+    std::vector<slot> slots;
+  };
+
+  // -- utility functions ------------------------------------------------------
+
+  static uint64_t bit_of(size_t hash, unsigned shift) {
+    return uint64_t{1} << ((hash >> shift) & ((1u << bits_per_level) - 1));
+  }
+
+  static size_t position(uint64_t bitmap, uint64_t bit) {
+    return std::bitset<64>{bitmap & (bit - 1)}.count();
+  }
+
+  static bool matches(const entry& x, size_t hash, const Key& key) {
+    return x.hash == hash && KeyEqual{}(x.kvp.first, key);
+  }
+
+  static entry_ptr make_entry(size_t hash, Key&& key, T&& value) {
+    return std::make_shared<entry>(
+      entry{hash, value_type{std::move(key), std::move(value)}});
+  }
+
+  /// Makes sure that no other map shares `*ptr` by copying it if necessary.
+  template <class U>
+  static U* detach(std::shared_ptr<U>& ptr) {
+    if (ptr.use_count() > 1) {
+      ptr = std::make_shared<U>(*ptr);
+    } else {
+      // Synchronize with the release of the last reference from another
+      // thread before touching the object.
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return ptr.get();
+  }
+
+  static node* own(node_ptr& ptr) {
+    if (ptr == nullptr) {
+      ptr = std::make_shared<node>();
+      return ptr.get();
+    }
+    return detach(ptr);
+  }
+
+  static void insert(node_ptr& ptr, unsigned shift, entry_ptr x) {
+    auto n = own(ptr);
+    if (shift >= hash_bits) {
+      n->slots.push_back(slot{nullptr, std::move(x)});
+      return;
+    }
+    auto bit = bit_of(x->hash, shift);
+    auto pos = position(n->bitmap, bit);
+    if ((n->bitmap & bit) == 0) {
+      n->bitmap |= bit;
+      n->slots.insert(n->slots.begin() + pos, slot{nullptr, std::move(x)});
+      return;
+    }
+    auto& s = n->slots[pos];
+    if (s.child != nullptr) {
+      insert(s.child, shift + bits_per_level, std::move(x));
+      return;
+    }
+    // Move both entries one level down.
+    node_ptr child;
+    insert(child, shift + bits_per_level, std::move(s.entry));
+    insert(child, shift + bits_per_level, std::move(x));
+    s.entry = nullptr;
+    s.child = std::move(child);
+  }
+
+  static void erase(node_ptr& ptr, unsigned shift, size_t hash,
+                    const Key& key) {
+    auto n = own(ptr);
+    if (shift >= hash_bits) {
+      for (auto i = n->slots.begin(); i != n->slots.end(); ++i) {
+        if (matches(*i->entry, hash, key)) {
+          n->slots.erase(i);
+          break;
+        }
+      }
+    } else {
+      auto bit = bit_of(hash, shift);
+      auto pos = position(n->bitmap, bit);
+      auto& s = n->slots[pos];
+      if (s.child != nullptr) {
+        erase(s.child, shift + bits_per_level, hash, key);
+        // Pull a lone entry back up to keep the trie shallow.
+        if (s.child != nullptr && s.child->slots.size() == 1
+            && s.child->slots.front().entry != nullptr) {
+          auto x = s.child->slots.front().entry;
+          s.child = nullptr;
+          s.entry = std::move(x);
+        }
+      }
+      if ((s.child == nullptr && s.entry == nullptr)
+          || (s.entry != nullptr && matches(*s.entry, hash, key))) {
+        n->bitmap &= ~bit;
+        n->slots.erase(n->slots.begin() + pos);
+      }
+    }
+    if (n->slots.empty())
+      ptr.reset();
+  }
+
+  template <class F>
+  static void for_each(const node& n, F& f) {
+    for (auto& s : n.slots) {
+      if (s.entry != nullptr)
+        f(s.entry->kvp.first, s.entry->kvp.second);
+      else
+        for_each(*s.child, f);
+    }
+  }
+
+  // -- member variables -------------------------------------------------------
+
+  node_ptr root_;
+
+  size_type size_;
+};
+
+} // namespace detail
+} // namespace broker
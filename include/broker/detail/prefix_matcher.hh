@@ -16,6 +16,12 @@ struct prefix_matcher {
 
   bool operator()(const filter_type& filter, const topic& t) const;
 
+  /// Checks all conditions except matching the topic, which the caller
+  /// performs separately via a `filter_index`.
+  bool accepts(const filter_type&) const noexcept {
+    return true;
+  }
+
   template <class T>
   bool operator()(const filter_type& filter, const T& x) const {
     return (*this)(filter, get_topic(x));
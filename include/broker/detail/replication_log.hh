@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "broker/fwd.hh"
+#include "broker/internal_command.hh"
+
+namespace broker {
+namespace detail {
+
+/// Numbers the commands that a master broadcasts to its clones and keeps the
+/// most recent ones around. A clone that briefly lost its master only needs
+/// the commands it missed instead of a full snapshot, as long as the log
+/// still contains all of them.
+class replication_log {
+public:
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// Creates a log that keeps at most `max_size` commands.
+  explicit replication_log(size_t max_size = 0);
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the sequence number of the most recent command.
+  sequence_number last_seq() const noexcept {
+    return last_seq_;
+  }
+
+  /// Returns the number of commands in the log.
+  size_t size() const noexcept {
+    return entries_.size();
+  }
+
+  /// Returns the maximum number of commands in the log.
+  size_t max_size() const noexcept {
+    return max_size_;
+  }
+
+  /// Returns whether the log contains all commands after `since`.
+  bool covers(sequence_number since) const noexcept;
+
+  // -- modifiers --------------------------------------------------------------
+
+  /// Sets the maximum number of commands, evicting the oldest commands if
+  /// the log contains more than `value` commands.
+  void max_size(size_t value);
+
+  /// Assigns the next sequence number to `x` and stores a copy of it, evicting
+  /// the oldest command when reaching the maximum size.
+  void append(internal_command& x);
+
+  // -- lookup -----------------------------------------------------------------
+
+  /// Returns all commands after `since` in their original order.
+  /// @pre `covers(since)`
+  std::vector<internal_command> since(sequence_number since) const;
+
+private:
+  size_t max_size_;
+  sequence_number last_seq_ = 0;
+  std::deque<internal_command> entries_;
+};
+
+} // namespace detail
+} // namespace broker
@@ -31,7 +31,7 @@ public:
   expected<void> put(const data& key, data value,
                      optional<timestamp> expiry) override;
 
-  expected<void> add(const data& key, const data& value,
+  expected<void> add(const data& key, data value,
                      data::type init_type,
                      optional<timestamp> expiry) override;
 
@@ -44,6 +44,10 @@ public:
 
   expected<bool> expire(const data& key, timestamp current_time) override;
 
+  expected<void> begin_batch() override;
+
+  expected<void> commit_batch() override;
+
   expected<data> get(const data& key) const override;
 
   expected<bool> exists(const data& key) const override;
@@ -56,6 +60,8 @@ public:
 
   expected<expirables> expiries() const override;
 
+  expected<backend_cursor_ptr> cursor() const override;
+
 private:
   bool open_db();
 
@@ -22,7 +22,7 @@ public:
   expected<void> put(const data& key, data value,
                      optional<timestamp> expiry) override;
 
-  expected<void> add(const data& key, const data& value, data::type init_type,
+  expected<void> add(const data& key, data value, data::type init_type,
                      optional<timestamp> expiry) override;
 
   expected<void> subtract(const data& key, const data& value,
@@ -34,6 +34,10 @@ public:
 
   expected<bool> expire(const data& key, timestamp current_time) override;
 
+  expected<void> begin_batch() override;
+
+  expected<void> commit_batch() override;
+
   expected<data> get(const data& key) const override;
 
   expected<bool> exists(const data& key) const override;
@@ -46,6 +50,8 @@ public:
 
   expected<expirables> expiries() const override;
 
+  expected<backend_cursor_ptr> cursor() const override;
+
 private:
   struct impl;
   std::unique_ptr<impl> impl_;
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "broker/topic_flags.hh"
+
+namespace broker {
+namespace detail {
+
+/// Shared, immutable storage for an interned topic string.
+struct topic_entry {
+  /// The full topic string.
+  std::string str;
+
+  /// Precomputed hash of `str`.
+  size_t hash;
+
+  /// Process-wide unique ID of this entry.
+  uint32_t id;
+
+  /// Properties of reserved topics.
+  topic_flags flags;
+};
+
+using topic_entry_ptr = std::shared_ptr<const topic_entry>;
+
+/// A process-wide intern table for topic strings. At most one entry exists for
+/// a given string as long as at least one reference to it is alive. Hence,
+/// comparing two entry pointers is equivalent to comparing the strings.
+class topic_table {
+public:
+  /// Returns the entry for `str`, creating it if needed. Returns `nullptr` for
+  /// the empty string.
+  topic_entry_ptr intern(const std::string& str);
+
+  /// Returns the entry for `str`, creating it if needed. Returns `nullptr` for
+  /// the empty string.
+  topic_entry_ptr intern(std::string&& str);
+
+  /// Returns the number of slots in the table, including expired entries that
+  /// have not been purged yet.
+  size_t size() const;
+
+  /// Returns the process-wide table.
+  static topic_table& instance();
+
+  /// Computes the flags for `str`.
+  static topic_flags classify(const std::string& str);
+
+private:
+  topic_table();
+
+  template <class String>
+  topic_entry_ptr intern_impl(String&& str);
+
+  /// Removes expired entries if the table grew past its threshold.
+  /// @pre `mtx_` is locked exclusively.
+  void purge_if_needed();
+
+  /// Guards all members.
+  mutable std::shared_mutex mtx_;
+
+  /// Maps topic strings to their entry. The table does not keep entries
+  /// alive. Expired entries get removed when the table grows.
+  std::unordered_map<std::string, std::weak_ptr<const topic_entry>> entries_;
+
+  /// Grows with the table to keep purging amortized constant.
+  size_t purge_threshold_;
+
+  /// Stores the ID for the next entry.
+  uint32_t next_id_;
+};
+
+} // namespace detail
+} // namespace broker
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <map>
@@ -14,18 +15,22 @@
 #include <caf/message.hpp>
 #include <caf/node_id.hpp>
 #include <caf/stream.hpp>
+#include <caf/stream_manager.hpp>
 #include <caf/timespan.hpp>
 #include <caf/timestamp.hpp>
 
 #include "broker/backend.hh"
 #include "broker/backend_options.hh"
+#include "broker/batching_info.hh"
 #include "broker/configuration.hh"
 #include "broker/endpoint_info.hh"
 #include "broker/expected.hh"
 #include "broker/frontend.hh"
 #include "broker/fwd.hh"
+#include "broker/lane_depths.hh"
 #include "broker/message.hh"
 #include "broker/network_info.hh"
+#include "broker/peer_buffer_info.hh"
 #include "broker/peer_info.hh"
 #include "broker/status.hh"
 #include "broker/status_subscriber.hh"
@@ -180,6 +185,18 @@ public:
   /// Retrieves a list of topics that peers have subscribed to on this endpoint.
   std::vector<topic> peer_subscriptions() const;
 
+  /// Retrieves the number of messages per priority lane that wait for
+  /// delivery to each peer.
+  std::vector<lane_depths> peer_lane_depths() const;
+
+  /// Retrieves the estimates and batch sizes of the batching controller for
+  /// each peer. With sharding, each core reports its own paths to a peer.
+  std::vector<batching_info> peer_batching() const;
+
+  /// Retrieves the fill levels of the buffers for messages from peers that
+  /// wait for status subscribers.
+  std::vector<peer_buffer_info> peer_buffers() const;
+
   // --- publishing ------------------------------------------------------------
 
   /// Publishes a message.
@@ -201,14 +218,34 @@ public:
   // Publishes the messages `x`.
   void publish(data_message x);
 
-  // Publishes all messages in `xs`.
+  // Publishes all messages in `xs`. Hands the messages to the core in a
+  // single batch rather than one at a time.
   void publish(std::vector<data_message> xs);
 
+  /// Publishes each element in `xs` as a separate message. Unlike
+  /// `publish(t, vector{...})`, which publishes a single message containing a
+  /// vector, this hands all messages to the core in a single batch.
+  /// @param t The topic of the messages.
+  /// @param xs The contents of the messages.
+  void publish_batch(topic t, std::vector<data> xs);
+
+  /// Publishes a message with a value in the compact encoding, e.g., the
+  /// output of `zeek::EventSchema::encode`. Forwards `buf` to peers without
+  /// decoding it.
+  /// @param t The topic of the message.
+  /// @param buf The encoded value, including the version byte.
+  /// @pre `detail::compact_encoding::is_compact(buf.data(), buf.size())`
+  void publish_encoded(topic t, std::vector<char> buf);
+
   publisher make_publisher(topic ts);
 
   /// Starts a background worker from the given set of functions that publishes
   /// a series of messages. The worker will run in the background, but `init`
   /// is guaranteed to be called before the function returns.
+  /// @note The worker streams all messages to the primary core, i.e., it
+  ///       bypasses sharding. With `broker.core-shards` greater than 1, its
+  ///       messages have no defined order relative to messages from
+  ///       `publish` or `make_publisher` on the same topic.
   template <class Init, class GetNext, class AtEnd>
   caf::actor publish_all(Init init, GetNext f, AtEnd pred) {
     std::mutex mx;
@@ -229,7 +266,7 @@ public:
   }
 
   /// Identical to ::publish_all, but does not guarantee that `init` is called
-  /// before the function returns.
+  /// before the function returns. Bypasses sharding as well.
   template <class Init, class GetNext, class AtEnd>
   caf::actor publish_all_nosync(Init init, GetNext f, AtEnd pred) {
     return make_actor([=](caf::event_based_actor* self) {
@@ -267,13 +304,8 @@ public:
     std::mutex mx;
     std::condition_variable cv;
     auto res = make_actor([=,&mx,&cv](caf::event_based_actor* self) {
-      self->send(self * core(), atom::join::value, std::move(topics));
-      self->become(
-        [=](const stream_type& in) {
-          self->make_sink(in, init, f, cleanup);
-          self->unbecome();
-        }
-      );
+      auto pending = join_cores(self, std::move(topics));
+      self->become(add_inputs(self, std::move(pending), init, f, cleanup));
       std::unique_lock<std::mutex> guard{mx};
       cv.notify_one();
     });
@@ -288,13 +320,8 @@ public:
   caf::actor subscribe_nosync(std::vector<topic> topics, Init init,
                               HandleMessage f, Cleanup cleanup) {
     return make_actor([=](caf::event_based_actor* self) {
-      self->send(self * core(), atom::join::value, std::move(topics));
-      self->become(
-        [=](const stream_type& in) {
-          self->make_sink(in, init, f, cleanup);
-          self->unbecome();
-        }
-      );
+      auto pending = join_cores(self, std::move(topics));
+      self->become(add_inputs(self, std::move(pending), init, f, cleanup));
     });
   }
 
@@ -334,6 +361,9 @@ public:
   ///                                 never buffer commands.
   /// @returns A handle to the frontend representing the clone, or an error if
   ///          a master *name* could not be found.
+  /// @note When enabling `broker.clone-local-reads`, synchronous queries on
+  ///       the returned store read the content of the clone directly from
+  ///       the calling thread.
   expected<store> attach_clone(std::string name, double resync_interval=10.0,
                                double stale_interval=300.0,
                                double mutation_buffer_interval=120.0);
@@ -376,10 +406,20 @@ public:
     return system_;
   }
 
+  /// Returns the primary core actor, which handles peerings and data stores.
   const caf::actor& core() const {
     return core_;
   }
 
+  /// Returns the core actor that routes messages for `t`. This is always the
+  /// primary core unless `broker.core-shards` is greater than 1.
+  const caf::actor& core(const topic& t) const;
+
+  /// Returns all core actors, starting with the primary core.
+  const std::vector<caf::actor>& cores() const {
+    return cores_;
+  }
+
   const configuration& config() const {
     return config_;
   }
@@ -390,11 +430,39 @@ protected:
 private:
   caf::actor make_actor(actor_init_fun f);
 
+  /// Subscribes `self` to `topics` on all cores. With sharding enabled, the
+  /// subscriber receives one input stream per core.
+  /// @returns the number of pending input streams.
+  std::shared_ptr<size_t> join_cores(caf::event_based_actor* self,
+                                     std::vector<topic> topics);
+
+  /// Returns a handler for the input streams from the cores that attaches all
+  /// of them to a single sink. Hence, the subscriber has only one state and
+  /// calls `init` and `cleanup` only once, regardless of the number of cores.
+  template <class Init, class HandleMessage, class Cleanup>
+  static auto add_inputs(caf::event_based_actor* self,
+                         std::shared_ptr<size_t> pending, Init init,
+                         HandleMessage f, Cleanup cleanup) {
+    auto sink = std::make_shared<caf::stream_manager_ptr>();
+    return [=](const stream_type& in) {
+      if (*sink == nullptr)
+        *sink = self->make_sink(in, init, f, cleanup).ptr();
+      else
+        (*sink)->add_unchecked_inbound_path(in);
+      if (--*pending == 0)
+        self->unbecome();
+    };
+  }
+
+  /// Returns the position of `core(t)` in `cores_`.
+  size_t core_index(const topic& t) const;
+
   configuration config_;
   union {
     mutable caf::actor_system system_;
   };
   caf::actor core_;
+  std::vector<caf::actor> cores_;
   bool await_stores_on_shutdown_;
   std::vector<caf::actor> children_;
   bool destroyed_;
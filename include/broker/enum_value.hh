@@ -4,6 +4,7 @@
 #include <ostream>
 #include <string>
 
+#include "broker/detail/hash.hh"
 #include "broker/detail/operators.hh"
 
 namespace broker {
@@ -51,7 +52,7 @@ namespace std {
 template <>
 struct hash<broker::enum_value> {
   size_t operator()(const broker::enum_value& v) const {
-    return std::hash<std::string>{}(v.name);
+    return broker::detail::hash_bytes(v.name.data(), v.name.size());
   }
 };
 
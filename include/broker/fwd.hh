@@ -49,6 +49,9 @@ using command_message = caf::cow_tuple<topic, internal_command>;
 /// A monotonic identifier to represent a specific lookup request.
 using request_id = uint64_t;
 
+/// A monotonic identifier for the commands that a master sends to its clones.
+using sequence_number = uint64_t;
+
 // Arithmetic data types.
 using boolean = bool;
 using count = uint64_t;
@@ -71,6 +74,7 @@ class IdentifierUpdate;
 
 namespace detail {
 
+class clone_view;
 class flare_actor;
 class mailbox;
 
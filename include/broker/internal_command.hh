@@ -76,15 +76,20 @@ typename Inspector::result_type inspect(Inspector& f, subtract_command& x) {
   return f(caf::meta::type_name("subtract"), x.key, x.value, x.expiry);
 }
 
-/// Causes the master to reply with a snapshot of its state.
+/// Causes the master to reply with a snapshot of its state. Clones that
+/// reconnect to the same master pass the sequence number of the last command
+/// they applied in `since`. The master then only sends the commands the
+/// clone missed, unless it no longer has all of them.
 struct snapshot_command {
   caf::actor remote_core;
   caf::actor remote_clone;
+  sequence_number since = 0;
 };
 
 template <class Inspector>
 typename Inspector::result_type inspect(Inspector& f, snapshot_command& x) {
-  return f(caf::meta::type_name("snapshot"), x.remote_core, x.remote_clone);
+  return f(caf::meta::type_name("snapshot"), x.remote_core, x.remote_clone,
+           x.since);
 }
 
 /// Since snapshots are sent to clones on a different channel, this allows
@@ -141,6 +146,11 @@ public:
 
   variant_type content;
 
+  /// Position of this command in the update stream of a master. Only commands
+  /// that a master broadcasts to its clones have a sequence number, all other
+  /// commands have the sequence number 0.
+  sequence_number seq = 0;
+
   internal_command(variant_type value);
 
   internal_command() = default;
@@ -157,7 +167,7 @@ internal_command make_internal_command(Ts&&... xs) {
 
 template <class Inspector>
 typename Inspector::result_type inspect(Inspector& f, internal_command& x) {
-  return f(caf::meta::type_name("internal_command"), x.content);
+  return f(caf::meta::type_name("internal_command"), x.content, x.seq);
 }
 
 namespace detail {
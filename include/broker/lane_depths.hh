@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+#include "broker/endpoint_info.hh"
+
+namespace broker {
+
+/// Number of messages waiting in the outbound buffer to a peer, split by
+/// priority lane. Without priority lanes, store commands wait in the bulk
+/// lane.
+/// @relates endpoint
+struct lane_depths {
+  endpoint_info peer;  ///< Information about the peer.
+  size_t control = 0;  ///< Queued messages in the control lane.
+  size_t bulk = 0;     ///< Queued messages in the bulk lane.
+};
+
+template <class Inspector>
+typename Inspector::result_type inspect(Inspector& f, lane_depths& x) {
+  return f(x.peer, x.control, x.bulk);
+}
+
+} // namespace broker
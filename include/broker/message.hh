@@ -1,11 +1,16 @@
 #pragma once
 
 #include <cstdint>
+#include <type_traits>
 
 #include <caf/cow_tuple.hpp>
+#include <caf/error.hpp>
+#include <caf/fwd.hpp>
 #include <caf/variant.hpp>
 
 #include "broker/data.hh"
+#include "broker/data_view.hh"
+#include "broker/detail/payload_cache.hh"
 #include "broker/internal_command.hh"
 #include "broker/topic.hh"
 
@@ -28,8 +33,42 @@ struct node_message {
 
   /// Time-to-life counter.
   uint16_t ttl;
+
+  /// Serialized form of the value in `content`, shared by all copies of this
+  /// message. Only present for messages that we forward to multiple peers or
+  /// that we have received from a peer.
+  detail::payload_cache_ptr cache;
+
+  /// Signals that `content` holds the topic but only a default-constructed
+  /// value, while `cache` holds the encoded value. Messages from peers remain
+  /// packed until a local actor needs the value, i.e., relaying a message
+  /// never decodes its value. Use `detail::unpack` to access the value.
+  bool packed = false;
 };
 
+namespace detail {
+
+/// Serializes `x` into `sink`. Writes a small header with TTL, message kind,
+/// and topic followed by the encoded value as a single blob. Data uses the
+/// compact encoding, commands use CAF's binary encoding. Uses the cache of `x`
+/// if available.
+caf::error save_node_message(caf::serializer& sink, node_message& x);
+
+/// Deserializes the header of `x` from `source` and keeps the encoded value
+/// as cache without decoding it. The result is a packed message.
+caf::error load_node_message(caf::deserializer& source, node_message& x);
+
+/// Decodes the value of a packed message. Does nothing if `x` is not packed.
+/// @param ctx Required for deserializing actor handles in commands.
+caf::error unpack(caf::execution_unit* ctx, node_message& x);
+
+/// Returns a view to the value of a packed data message without decoding it,
+/// or an invalid view if `x` is not a packed data message. The view remains
+/// valid as long as `x.cache` is alive.
+data_view payload_view(const node_message& x);
+
+} // namespace detail
+
 /// Returns whether `x` contains a ::node_message.
 inline bool is_data_message(const node_message::value_type& x) {
   return caf::holds_alternative<data_message>(x);
@@ -53,7 +92,12 @@ inline bool is_command_message(const node_message& x) {
 /// @relates node_message
 template <class Inspector>
 typename Inspector::result_type inspect(Inspector& f, node_message& x) {
-  return f(x.content, x.ttl);
+  if constexpr (std::is_base_of<caf::serializer, Inspector>::value)
+    return detail::save_node_message(f, x);
+  else if constexpr (std::is_base_of<caf::deserializer, Inspector>::value)
+    return detail::load_node_message(f, x);
+  else
+    return f(x.content, x.ttl);
 }
 
 /// Generates a broker ::data_message.
@@ -84,6 +128,13 @@ inline node_message make_node_message(node_message::value_type msg,
   return {std::move(msg), ttl};
 }
 
+/// Generates a packed ::node_message from a data payload in the compact
+/// encoding. Peers receive the payload as-is, i.e., without decoding and
+/// re-encoding it.
+node_message make_packed_node_message(topic t,
+                                      detail::payload_cache::buffer_type buf,
+                                      uint16_t ttl = 0);
+
 /// Retrieves the topic from a ::data_message.
 inline const topic& get_topic(const data_message& x) {
   return get<0>(x);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+#include "broker/endpoint_info.hh"
+
+namespace broker {
+
+/// Fill level of the buffer for messages from a blocked peer.
+/// @relates endpoint
+struct peer_buffer_info {
+  endpoint_info peer;       ///< Information about the peer.
+  size_t size = 0;          ///< Number of buffered messages.
+  size_t memory_usage = 0;  ///< Estimated bytes for messages in memory.
+  size_t spill_usage = 0;   ///< Bytes in the spill file.
+  size_t dropped = 0;       ///< Messages dropped after reaching all limits.
+};
+
+template <class Inspector>
+typename Inspector::result_type inspect(Inspector& f, peer_buffer_info& x) {
+  return f(x.peer, x.size, x.memory_usage, x.spill_usage, x.dropped);
+}
+
+} // namespace broker
@@ -20,6 +20,12 @@ struct peer_filter_matcher {
     detail::prefix_matcher g;
     return f.first != active_sender && g(f.second, x);
   }
+
+  /// Checks all conditions except matching the topic, which the caller
+  /// performs separately via a `filter_index`.
+  bool accepts(const peer_filter& f) const {
+    return f.first != active_sender;
+  }
 };
 
 } // namespace broker
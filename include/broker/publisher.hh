@@ -9,6 +9,7 @@
 #include "broker/atoms.hh"
 #include "broker/fwd.hh"
 #include "broker/message.hh"
+#include "broker/time.hh"
 
 #include "broker/detail/shared_publisher_queue.hh"
 
@@ -77,6 +78,19 @@ public:
   /// destructor gets called.
   void drop_all_on_destruction();
 
+  /// Configures the publisher to coalesce values into `zeek::Batch` messages.
+  /// The publisher ships a batch once it holds `max_size` values or once
+  /// `max_delay` has passed since adding the first value to the batch.
+  /// Subscribers receive the individual values again after enabling
+  /// unbatching via `subscriber::set_unbatching`.
+  /// @param max_size The maximum number of values per batch or 0 to disable
+  ///                 batching.
+  /// @param max_delay The maximum time a value waits for other values.
+  /// @note Intended for publishing Zeek messages, since Zeek unpacks batches
+  ///       on its own.
+  void set_batching(size_t max_size,
+                    timespan max_delay = std::chrono::milliseconds(10));
+
   // --- messaging -------------------------------------------------------------
 
   /// Sends `x` to all subscribers.
@@ -34,6 +34,12 @@ enum class sc : uint8_t {
   peer_removed,
   /// Lost connection to peer.
   peer_lost,
+  /// Started buffering messages from a blocked peer.
+  peer_buffering,
+  /// Exceeded the memory limit for buffering messages from a blocked peer.
+  peer_buffer_overflow,
+  /// Replayed all buffered messages from a previously blocked peer.
+  peer_buffer_drained,
 };
 
 /// @relates sc
@@ -75,7 +81,10 @@ public:
   static detail::enable_if_t<
     S == sc::peer_added
     || S == sc::peer_removed
-    || S == sc::peer_lost,
+    || S == sc::peer_lost
+    || S == sc::peer_buffering
+    || S == sc::peer_buffer_overflow
+    || S == sc::peer_buffer_drained,
     status
   >
   make(endpoint_info ei, std::string msg) {
@@ -103,6 +112,9 @@ public:
       case sc::peer_added:
       case sc::peer_removed:
       case sc::peer_lost:
+      case sc::peer_buffering:
+      case sc::peer_buffer_overflow:
+      case sc::peer_buffer_drained:
         return &context_.get_as<endpoint_info>(0);
     }
   }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -243,7 +244,8 @@ public:
   }
 
 private:
-  store(caf::actor actor, std::string name);
+  store(caf::actor actor, std::string name,
+        std::shared_ptr<detail::clone_view> view = nullptr);
 
   /// Adds a value to another one, with a type-specific meaning of
   /// "add". This is the backend for a number of the modifiers methods.
@@ -280,6 +282,10 @@ private:
 
   caf::actor frontend_;
   std::string name_;
+
+  /// Allows queries on clones without messaging the clone actor. Null for
+  /// masters and unless the endpoint enables `broker.clone-local-reads`.
+  std::shared_ptr<detail::clone_view> view_;
 };
 
 } // namespace broker
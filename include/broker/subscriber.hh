@@ -42,6 +42,11 @@ public:
 
   size_t rate() const;
 
+  /// Enables or disables unbatching. When enabled, the subscriber replaces
+  /// each `zeek::Batch` with the messages in the batch, e.g., for receiving
+  /// individual events from a batching ::publisher. Off by default.
+  void set_unbatching(bool x);
+
   const caf::actor& worker() const {
     return worker_;
   }
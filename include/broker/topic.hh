@@ -1,16 +1,22 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "broker/detail/operators.hh"
+#include "broker/detail/topic_table.hh"
+#include "broker/topic_flags.hh"
 
 namespace broker {
 
-/// A hierachical topic used as pub/sub communication pattern.
+/// A hierachical topic used as pub/sub communication pattern. Topics are
+/// interned: all topics with the same string share one immutable entry in a
+/// process-wide table. Hence, copying, hashing and comparing topics for
+/// equality never touches the string.
 class topic : detail::totally_ordered<topic> {
 public:
   /// The separator between topic hierarchies.
@@ -40,7 +46,7 @@ public:
       std::is_convertible<T, std::string>::value
     >::type
   >
-  topic(T&& x) : str_(std::forward<T>(x)) {
+  topic(T&& x) : entry_(intern(std::forward<T>(x))) {
     // nop
   }
 
@@ -55,19 +61,60 @@ public:
   /// Returns whether this topic is a prefix match for `t`.
   bool prefix_of(const topic& t) const;
 
+  /// Returns the ID of the interned topic string or 0 for the empty topic.
+  /// The ID remains stable for as long as any topic with the same string
+  /// exists.
+  uint32_t id() const noexcept {
+    return entry_ ? entry_->id : 0;
+  }
+
+  /// Returns a precomputed hash value of the topic string.
+  size_t hash() const noexcept {
+    return entry_ ? entry_->hash : 0;
+  }
+
+  /// Returns properties of reserved topics, computed once per topic string.
+  topic_flags flags() const noexcept {
+    return entry_ ? entry_->flags : topic_flags::none;
+  }
+
+  /// Returns whether this topic is empty.
+  bool empty() const noexcept {
+    return entry_ == nullptr;
+  }
+
+  friend bool operator==(const topic& lhs, const topic& rhs) noexcept {
+    return lhs.entry_ == rhs.entry_;
+  }
+
   template <class Inspector>
   friend typename Inspector::result_type inspect(Inspector& f, topic& t) {
-    return f(t.str_);
+    if constexpr (Inspector::reads_state) {
+      return f(t.string());
+    } else {
+      // Re-using the buffer avoids allocations for known topics.
+      thread_local std::string buf;
+      if (auto err = f(buf))
+        return err;
+      t.entry_ = detail::topic_table::instance().intern(buf);
+      return {};
+    }
   }
 
 private:
+  template <class T>
+  static detail::topic_entry_ptr intern(T&& x) {
+    auto& tbl = detail::topic_table::instance();
+    if constexpr (std::is_same<typename std::decay<T>::type,
+                               std::string>::value)
+      return tbl.intern(std::forward<T>(x));
+    else
+      return tbl.intern(std::string(std::forward<T>(x)));
+  }
 
-  std::string str_;
+  detail::topic_entry_ptr entry_;
 };
 
-/// @relates topic
-bool operator==(const topic& lhs, const topic& rhs);
-
 /// @relates topic
 bool operator<(const topic& lhs, const topic& rhs);
 
@@ -101,7 +148,7 @@ namespace std {
 template <>
 struct hash<broker::topic> {
   size_t operator()(const broker::topic& t) const {
-    return std::hash<std::string>{}(t.string());
+    return t.hash();
   }
 };
 
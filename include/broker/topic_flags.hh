@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+namespace broker {
+
+/// Describes properties of reserved topics. Broker computes the flags once
+/// per topic string when interning it.
+enum class topic_flags : uint8_t {
+  none = 0x00,
+  /// The topic ends with `topics::clone_suffix`.
+  clone = 0x01,
+  /// The topic ends with `topics::master_suffix`.
+  master = 0x02,
+  /// The topic is `topics::errors`.
+  errors = 0x04,
+  /// The topic is `topics::statuses`.
+  statuses = 0x08,
+};
+
+/// @relates topic_flags
+constexpr topic_flags operator+(topic_flags lhs, topic_flags rhs) {
+  return static_cast<topic_flags>(static_cast<int>(lhs)
+                                  | static_cast<int>(rhs));
+}
+
+/// @relates topic_flags
+constexpr bool is_clone(topic_flags x) {
+  return (static_cast<int>(x) & static_cast<int>(topic_flags::clone)) != 0;
+}
+
+/// @relates topic_flags
+constexpr bool is_master(topic_flags x) {
+  return (static_cast<int>(x) & static_cast<int>(topic_flags::master)) != 0;
+}
+
+/// @relates topic_flags
+constexpr bool is_errors(topic_flags x) {
+  return (static_cast<int>(x) & static_cast<int>(topic_flags::errors)) != 0;
+}
+
+/// @relates topic_flags
+constexpr bool is_statuses(topic_flags x) {
+  return (static_cast<int>(x) & static_cast<int>(topic_flags::statuses)) != 0;
+}
+
+/// Returns whether `x` marks an internal topic for errors or status updates.
+/// @relates topic_flags
+constexpr bool is_status_or_error(topic_flags x) {
+  auto mask = static_cast<int>(topic_flags::errors + topic_flags::statuses);
+  return (static_cast<int>(x) & mask) != 0;
+}
+
+} // namespace broker
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "broker/data.hh"
+#include "broker/data_view.hh"
+#include "broker/optional.hh"
 
 namespace broker {
 namespace zeek {
@@ -81,6 +83,21 @@ public:
     return Type(*cp);
   }
 
+  static Type type(const data_view& msg) {
+    if ( msg.size() < 2 )
+      return Type::Invalid;
+
+    auto cp = msg[1].as<count>();
+
+    if ( ! cp )
+      return Type::Invalid;
+
+    if ( *cp > Type::MAX )
+      return Type::Invalid;
+
+    return Type(*cp);
+  }
+
 protected:
   Message(Type type, vector content)
     : data_(vector{ProtocolVersion, count(type), std::move(content)}) {
@@ -144,6 +161,61 @@ class Event : public Message {
   }
 };
 
+/// A read-only view to a serialized Zeek event. Allows looking at the name
+/// and the arguments of an event without deserializing it.
+/// @note Subscribers and workers still receive decoded messages. Views are a
+///       building block for code that has access to the serialized form,
+///       e.g., via `detail::payload_view`.
+class EventView {
+public:
+  EventView(data_view msg) : msg_(msg) {}
+
+  /// Returns the name of the event or an empty string if the view does not
+  /// point to a valid event.
+  std::string_view name() const {
+    if ( auto x = msg_[2][0].as<std::string_view>() )
+      return *x;
+    return {};
+  }
+
+  /// Returns the arguments of the event or an invalid view if the view does
+  /// not point to a valid event.
+  data_view args() const {
+    return msg_[2][1];
+  }
+
+  /// Deserializes the event.
+  /// @returns the event or `nil` if the view does not point to a valid event.
+  optional<Event> materialize() const {
+    if ( ! valid() )
+      return nil;
+    if ( auto x = msg_.materialize() )
+      return Event(std::move(*x));
+    return nil;
+  }
+
+  bool valid() const {
+    if ( msg_.size() < 3 )
+      return false;
+
+    auto v = msg_[2];
+
+    if ( ! v.is<vector>() || v.size() < 2 )
+      return false;
+
+    if ( ! v[0].is<std::string>() )
+      return false;
+
+    if ( ! v[1].is<vector>() )
+      return false;
+
+    return true;
+  }
+
+private:
+  data_view msg_;
+};
+
 /// A batch of other messages.
 class Batch : public Message {
   public:
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <caf/detail/type_list.hpp>
+
+#include "broker/data.hh"
+#include "broker/detail/compact_encoding.hh"
+#include "broker/time.hh"
+#include "broker/zeek.hh"
+
+namespace broker {
+namespace zeek {
+
+/// Encodes and decodes Zeek events with a fixed signature. Unlike ::Event,
+/// which builds a nested ::vector for every event, a schema writes the
+/// compact encoding of an event directly from its arguments and decodes
+/// events into typed values without constructing ::data for the event as a
+/// whole. For example, publishing a `conn_seen(uid: string, ts: time)` event
+/// could look like this:
+///
+/// ~~~
+/// EventSchema<std::string, timestamp> conn_seen{"conn_seen"};
+/// std::vector<char> buf;
+/// conn_seen.encode(buf, uid, ts);
+/// ep.publish_encoded("/zeek/events", std::move(buf));
+/// ~~~
+///
+/// Each type in `Ts` must be one of the types in `data::types` or ::data
+/// itself, where ::data accepts any value.
+template <class... Ts>
+class EventSchema {
+public:
+  static_assert(((caf::detail::tl_contains<data::types, Ts>::value
+                  || std::is_same<Ts, data>::value)
+                 && ...),
+                "EventSchema requires Broker data types as arguments");
+
+  explicit EventSchema(std::string name) : name_(std::move(name)) {
+    // nop
+  }
+
+  /// Returns the name of the event.
+  const std::string& name() const {
+    return name_;
+  }
+
+  /// Returns the number of event arguments.
+  static constexpr size_t size() {
+    return sizeof...(Ts);
+  }
+
+  /// Appends the compact encoding of the event (including the version byte)
+  /// to `buf`. The result is identical to encoding the ::data of an ::Event
+  /// with the same name and arguments.
+  void encode(std::vector<char>& buf, const Ts&... xs) const {
+    buf.push_back(static_cast<char>(detail::compact_encoding::version));
+    detail::compact_encoding::writer f{buf};
+    f.begin_vector(3);
+    f(ProtocolVersion);
+    f(count{Message::Type::Event});
+    f.begin_vector(2);
+    f(name_);
+    f.begin_vector(sizeof...(Ts));
+    const timestamp* prev = nullptr;
+    (write_arg(f, xs, prev), ...);
+  }
+
+  /// Creates an ::Event with the name of this schema.
+  Event make_event(Ts... xs) const {
+    return Event(name_, vector{data{std::move(xs)}...});
+  }
+
+  /// Decodes an event in the compact encoding, e.g., the payload of a data
+  /// message or the output of `encode`.
+  /// @returns `true` if `buf` contains an event with the name and the
+  ///          signature of this schema, `false` otherwise.
+  bool decode(const char* buf, size_t size, Ts&... xs) const {
+    namespace ce = detail::compact_encoding;
+    if (!ce::is_compact(buf, size))
+      return false;
+    auto pos = buf + 1;
+    auto last = buf + size;
+    size_t n = 0;
+    data tmp;
+    // Read the header of `[version, type, [name, [args...]]]`.
+    if ((pos = read_vector(pos, last, n)) == nullptr || n != 3)
+      return false;
+    if ((pos = ce::read(pos, last, tmp)) == nullptr || tmp != ProtocolVersion)
+      return false;
+    if ((pos = ce::read(pos, last, tmp)) == nullptr
+        || tmp != count{Message::Type::Event})
+      return false;
+    if ((pos = read_vector(pos, last, n)) == nullptr || n != 2)
+      return false;
+    if (pos == last || ce::type_index(static_cast<uint8_t>(*pos))
+                         != index_of<std::string>())
+      return false;
+    if ((pos = ce::read_string(pos, last, n)) == nullptr
+        || std::string_view{pos, n} != name_)
+      return false;
+    pos += n;
+    if ((pos = read_vector(pos, last, n)) == nullptr || n != sizeof...(Ts))
+      return false;
+    // Read the arguments.
+    timestamp prev;
+    bool has_prev = false;
+    auto ok = true;
+    ((ok = ok
+           && (pos = read_arg(pos, last, xs, tmp, prev, has_prev)) != nullptr),
+     ...);
+    return ok && pos == last;
+  }
+
+  /// Extracts the arguments of an event.
+  /// @returns `true` if `msg` contains an event with the name and the
+  ///          signature of this schema, `false` otherwise.
+  bool decode(const data& msg, Ts&... xs) const {
+    if (Message::type(msg) != Message::Type::Event)
+      return false;
+    auto& outer = get<vector>(msg);
+    if (outer.size() < 3)
+      return false;
+    auto inner = get_if<vector>(outer[2]);
+    if (inner == nullptr || inner->size() < 2)
+      return false;
+    auto name = get_if<std::string>((*inner)[0]);
+    auto args = get_if<vector>((*inner)[1]);
+    if (name == nullptr || *name != name_ || args == nullptr
+        || args->size() != sizeof...(Ts))
+      return false;
+    return extract(*args, std::index_sequence_for<Ts...>{}, xs...);
+  }
+
+private:
+  template <class T>
+  static constexpr uint8_t index_of() {
+    return static_cast<uint8_t>(
+      caf::detail::tl_index_of<data::types, T>::value);
+  }
+
+  static const char* read_vector(const char* pos, const char* last,
+                                 size_t& n) {
+    namespace ce = detail::compact_encoding;
+    if (pos == last
+        || ce::type_index(static_cast<uint8_t>(*pos)) != index_of<vector>())
+      return nullptr;
+    return ce::read_size(pos, last, n);
+  }
+
+  template <class T>
+  static void write_arg(detail::compact_encoding::writer& f, const T& x,
+                        const timestamp*& prev) {
+    if constexpr (std::is_same<T, timestamp>::value) {
+      f(x, prev);
+      prev = &x;
+    } else if constexpr (std::is_same<T, data>::value) {
+      if (auto ts = get_if<timestamp>(x)) {
+        f(*ts, prev);
+        prev = ts;
+      } else {
+        f(x);
+      }
+    } else {
+      f(x);
+    }
+  }
+
+  template <class T>
+  static const char* read_arg(const char* pos, const char* last, T& x,
+                              data& tmp, timestamp& prev, bool& has_prev) {
+    namespace ce = detail::compact_encoding;
+    auto base = has_prev ? &prev : nullptr;
+    if constexpr (std::is_same<T, data>::value) {
+      if ((pos = ce::read(pos, last, x, base)) == nullptr)
+        return nullptr;
+      if (auto ts = get_if<timestamp>(x)) {
+        prev = *ts;
+        has_prev = true;
+      }
+    } else {
+      if ((pos = ce::read(pos, last, tmp, base)) == nullptr)
+        return nullptr;
+      auto ptr = get_if<T>(tmp);
+      if (ptr == nullptr)
+        return nullptr;
+      x = std::move(*ptr);
+      if constexpr (std::is_same<T, timestamp>::value) {
+        prev = x;
+        has_prev = true;
+      }
+    }
+    return pos;
+  }
+
+  template <size_t... Is>
+  static bool extract(const vector& args, std::index_sequence<Is...>,
+                      Ts&... xs) {
+    auto get_arg = [](const data& arg, auto& x) {
+      using type = std::decay_t<decltype(x)>;
+      if constexpr (std::is_same<type, data>::value) {
+        x = arg;
+        return true;
+      } else {
+        if (auto ptr = get_if<type>(arg)) {
+          x = *ptr;
+          return true;
+        }
+        return false;
+      }
+    };
+    return (get_arg(args[Is], xs) && ...);
+  }
+
+  std::string name_;
+};
+
+} // namespace zeek
+} // namespace broker
@@ -98,5 +98,6 @@ bool address::mask(uint8_t top_bits_to_keep) {
 } // namespace broker
 
 size_t std::hash<broker::address>::operator()(const broker::address& v) const {
-  return broker::detail::hash_range(v.bytes().begin(), v.bytes().end());
+  auto& bytes = v.bytes();
+  return broker::detail::hash_bytes(bytes.data(), bytes.size());
 }
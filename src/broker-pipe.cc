@@ -22,7 +22,6 @@
 #include <caf/atom.hpp>
 #include <caf/behavior.hpp>
 #include <caf/config_option_adder.hpp>
-#include <caf/deep_to_string.hpp>
 #include <caf/downstream.hpp>
 #include <caf/event_based_actor.hpp>
 #include <caf/exit_reason.hpp>
@@ -64,6 +63,9 @@ std::mutex cout_mtx;
 using guard_type = std::unique_lock<std::mutex>;
 
 bool rate = false;
+
+bool json_output = false;
+
 std::atomic<size_t> msg_count{0};
 
 void print_line(std::ostream& out, const std::string& line) {
@@ -71,6 +73,62 @@ void print_line(std::ostream& out, const std::string& line) {
   out << line << std::endl;
 }
 
+// Appends `x` as a quoted string to `buf`. Escapes quotes, backslashes and
+// control characters, i.e., the result is also a valid JSON string.
+void append_quoted(const std::string& x, std::string& buf) {
+  static constexpr char hex[] = "0123456789abcdef";
+  buf += '"';
+  for (auto c : x) {
+    switch (c) {
+      case '"':
+        buf += "\\\"";
+        break;
+      case '\\':
+        buf += "\\\\";
+        break;
+      case '\n':
+        buf += "\\n";
+        break;
+      case '\r':
+        buf += "\\r";
+        break;
+      case '\t':
+        buf += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          buf += "\\u00";
+          buf += hex[(c >> 4) & 0x0F];
+          buf += hex[c & 0x0F];
+        } else {
+          buf += c;
+        }
+    }
+  }
+  buf += '"';
+}
+
+void print_message(const data_message& msg) {
+  // Reuse the buffer to avoid allocations per message.
+  thread_local std::string buf;
+  auto& x = broker::get_data(msg);
+  if (!json_output) {
+    // Same format as deep_to_string, i.e., a tuple of topic and data.
+    buf = '(';
+    append_quoted(broker::get_topic(msg).string(), buf);
+    buf += ", ";
+    broker::render(x, buf);
+    buf += ')';
+  } else {
+    buf = "{\"topic\":";
+    append_quoted(broker::get_topic(msg).string(), buf);
+    buf += ",\"data\":";
+    broker::render_json(x, buf);
+    buf += '}';
+  }
+  print_line(std::cout, buf);
+}
+
 class config : public broker::configuration {
 public:
   using super = broker::configuration;
@@ -86,6 +144,7 @@ public:
     .add<bool>(rate, "rate,r",
                "print the rate of messages once per second instead of the "
                "message content")
+    .add<bool>(json_output, "json,j", "print received messages as JSON")
     .add(peers, "peers,p",
          "list of peers we connect to on startup (host:port notation)")
     .add(local_port, "local-port,l",
@@ -184,7 +243,7 @@ void subscribe_mode_blocking(broker::endpoint& ep, const std::string& topic_str,
   for (size_t i = 0; i < cap; ++i) {
     auto msg = in.get();
     if (!rate)
-      print_line(std::cout, deep_to_string(std::move(msg)));
+      print_message(msg);
     ++msg_count;
   }
 }
@@ -214,7 +273,7 @@ void subscribe_mode_select(broker::endpoint& ep, const std::string& topic_str,
     for (size_t j = 0; j < num; ++j) {
       auto msg = in.get();
       if (!rate)
-        print_line(std::cout, deep_to_string(std::move(msg)));
+        print_message(msg);
     }
     i += num;
     msg_count += num;
@@ -233,7 +292,7 @@ void subscribe_mode_stream(broker::endpoint& ep, const std::string& topic_str,
     [=](size_t& msgs, data_message x) {
       ++msg_count;
       if (!rate)
-        print_line(std::cout, deep_to_string(x));
+        print_message(x);
       if (++msgs >= cap)
         throw std::runtime_error("Reached cap");
     },
@@ -91,6 +91,26 @@ configuration::configuration(skip_init_t) {
     .add(options_.disable_ssl, "disable_ssl",
          "forces Broker to use unencrypted communication")
     .add(options_.ttl, "ttl", "drop messages after traversing TTL hops")
+    .add(options_.core_shards, "core-shards",
+         "number of core actors for routing messages in parallel")
+    .add(options_.priority_lanes, "priority-lanes",
+         "lets store commands overtake data messages to peers")
+    .add(options_.adaptive_batching, "adaptive-batching",
+         "sizes batches to peers from observed rate and round-trip time")
+    .add(options_.batch_latency_target, "batch-latency-target",
+         "maximum time a message waits for its batch when batching adaptively")
+    .add(options_.batch_throughput_target, "batch-throughput-target",
+         "messages per second that each peering should sustain")
+    .add(options_.peer_buffer_memory_limit, "peer-buffer-memory-limit",
+         "maximum bytes in memory for messages from a blocked peer")
+    .add(options_.peer_buffer_spill_directory, "peer-buffer-spill-directory",
+         "directory for spilling messages from blocked peers to disk")
+    .add(options_.peer_buffer_spill_limit, "peer-buffer-spill-limit",
+         "maximum size of a spill file for messages from a blocked peer")
+    .add(options_.replication_log_size, "replication-log-size",
+         "number of store updates that masters keep for reconnecting clones")
+    .add(options_.clone_local_reads, "clone-local-reads",
+         "lets threads query clones without messaging the clone actor")
     .add<std::string>("recording-directory",
                       "path for storing recorded meta information")
     .add<size_t>("output-generator-file-cap",
@@ -184,6 +204,19 @@ caf::settings configuration::dump_content() const {
   put_missing(grp, "disable_ssl", options_.disable_ssl);
   put_missing(grp, "ttl", options_.ttl);
   put_missing(grp, "forward", options_.forward);
+  put_missing(grp, "core-shards", options_.core_shards);
+  put_missing(grp, "priority-lanes", options_.priority_lanes);
+  put_missing(grp, "adaptive-batching", options_.adaptive_batching);
+  put_missing(grp, "batch-latency-target", options_.batch_latency_target);
+  put_missing(grp, "batch-throughput-target",
+              options_.batch_throughput_target);
+  put_missing(grp, "peer-buffer-memory-limit",
+              options_.peer_buffer_memory_limit);
+  put_missing(grp, "peer-buffer-spill-directory",
+              options_.peer_buffer_spill_directory);
+  put_missing(grp, "peer-buffer-spill-limit", options_.peer_buffer_spill_limit);
+  put_missing(grp, "replication-log-size", options_.replication_log_size);
+  put_missing(grp, "clone-local-reads", options_.clone_local_reads);
   if (auto path = get_if<std::string>(&content, "broker.recording-directory"))
     put_missing(grp, "recording-directory", *path);
   if (auto cap = get_if<size_t>(&content, "broker.output-generator-file-cap"))
@@ -209,9 +242,13 @@ void configuration::add_message_types(caf::actor_system_config& cfg) {
   ADD_MSG_TYPE(broker::optional<broker::timestamp>);
   ADD_MSG_TYPE(broker::optional<broker::timespan>);
   ADD_MSG_TYPE(broker::snapshot);
+  ADD_MSG_TYPE(broker::snapshot_entry);
   ADD_MSG_TYPE(broker::internal_command);
+  ADD_MSG_TYPE(std::vector<broker::internal_command>);
   ADD_MSG_TYPE(broker::command_message);
+  ADD_MSG_TYPE(std::vector<broker::command_message>);
   ADD_MSG_TYPE(broker::data_message);
+  ADD_MSG_TYPE(std::vector<broker::data_message>);
   ADD_MSG_TYPE(broker::node_message);
   ADD_MSG_TYPE(broker::node_message::value_type);
   ADD_MSG_TYPE(broker::set_command);
@@ -10,10 +10,12 @@
 #include <caf/exit_reason.hpp>
 #include <caf/group.hpp>
 #include <caf/make_counted.hpp>
+#include <caf/node_id.hpp>
 #include <caf/none.hpp>
 #include <caf/response_promise.hpp>
 #include <caf/result.hpp>
 #include <caf/sec.hpp>
+#include <caf/send.hpp>
 #include <caf/spawn_options.hpp>
 #include <caf/stateful_actor.hpp>
 #include <caf/stream.hpp>
@@ -28,6 +30,7 @@
 #include "broker/defaults.hh"
 #include "broker/detail/assert.hh"
 #include "broker/detail/clone_actor.hh"
+#include "broker/detail/clone_view.hh"
 #include "broker/detail/filesystem.hh"
 #include "broker/detail/make_backend.hh"
 #include "broker/detail/master_actor.hh"
@@ -37,6 +40,7 @@
 #include "broker/logger.hh"
 #include "broker/peer_status.hh"
 #include "broker/status.hh"
+#include "broker/timeout.hh"
 #include "broker/topic.hh"
 
 using namespace caf;
@@ -116,10 +120,18 @@ void core_state::init(filter_type initial_filter, broker_options opts,
   filter = std::move(initial_filter);
   cache.set_use_ssl(! options.disable_ssl);
   governor = caf::make_counted<governor_type>(self, this, filter);
+  policy().peers().priority_lanes(options.priority_lanes);
+  if (options.adaptive_batching) {
+    detail::batching_controller::settings targets;
+    targets.latency_target = options.batch_latency_target;
+    targets.throughput_target = options.batch_throughput_target;
+    policy().peers().adaptive_batching(targets);
+  }
   clock = ep_clock;
   auto meta_dir = get_or(self->config(), "broker.recording-directory",
                          defaults::recording_directory);
-  if (!meta_dir.empty() && detail::is_directory(meta_dir)) {
+  // Only the primary core records meta data.
+  if (!meta_dir.empty() && detail::is_directory(meta_dir) && !is_shard()) {
     auto file_name = meta_dir + "/topics.txt";
     topics_file.open(file_name);
     if (topics_file.is_open()) {
@@ -154,7 +166,7 @@ void core_state::add_to_filter(filter_type xs) {
   BROKER_TRACE(BROKER_ARG(xs));
   // Status and error topics are internal topics.
   auto status_or_error = [](const topic& x) {
-    return x == topics::errors || x == topics::statuses;
+    return is_status_or_error(x.flags());
   };
   xs.erase(std::remove_if(xs.begin(), xs.end(), status_or_error), xs.end());
   if (xs.empty())
@@ -204,6 +216,57 @@ detail::core_policy& core_state::policy() {
   return governor->policy();
 }
 
+void core_state::peer_shards(caf::actor remote_core, bool connect) {
+  if (shards.empty())
+    return;
+  BROKER_TRACE(BROKER_ARG(remote_core));
+  uint32_t num_shards = static_cast<uint32_t>(shards.size() + 1);
+  self->request(remote_core, timeout::peer, atom::get::value,
+                atom::shard::value)
+  .then(
+    [=](uint32_t remote_num_shards) {
+      // Topics map to shards by hash. Hence, shards only form consistent
+      // overlays if all endpoints use the same number of shards.
+      if (remote_num_shards != num_shards) {
+        BROKER_ERROR("peer uses" << remote_num_shards << "instead of"
+                                 << num_shards << "core shards");
+        drop_incompatible_peer(remote_core, "mismatched number of core shards");
+        return;
+      }
+      if (!connect)
+        return;
+      for (uint32_t i = 1; i < num_shards; ++i) {
+        self->request(remote_core, timeout::peer, atom::get::value,
+                      atom::shard::value, i)
+        .then(
+          [=](caf::actor& remote_shard) {
+            caf::anon_send(shards[i - 1], atom::peer::value,
+                           std::move(remote_shard));
+          },
+          [=](caf::error& err) {
+            BROKER_ERROR("cannot resolve remote shard" << i << ":" << err);
+          });
+      }
+    },
+    [=](caf::error& err) {
+      BROKER_ERROR("cannot query core shards of peer:" << err);
+      drop_incompatible_peer(remote_core, "peer does not support core shards");
+    });
+}
+
+void core_state::drop_incompatible_peer(const caf::actor& remote_core,
+                                        const char* msg) {
+  emit_error<ec::peer_incompatible>(remote_core, msg);
+  policy().remove_peer(remote_core, make_error(ec::peer_incompatible, msg),
+                       false, true);
+}
+
+void core_state::unpeer_shards(const caf::actor& remote_core) {
+  for (auto& shard : shards)
+    self->send(shard, atom::unpeer::value, atom::shard::value,
+               remote_core.node());
+}
+
 static void sync_peer_status(core_state* st, caf::actor new_peer) {
   auto it = st->peers_awaiting_status_sync.find(new_peer);
 
@@ -245,6 +308,8 @@ void core_state::sync_with_status_subscribers(caf::actor new_peer) {
 }
 
 void core_state::emit_peer_added_status(caf::actor hdl, const char* msg) {
+  if (is_shard())
+    return;
   auto emit = [=](network_info x) {
     BROKER_INFO("status" << sc::peer_added << x);
     auto stat = status::make<sc::peer_added>(
@@ -369,6 +434,9 @@ caf::behavior core_actor(caf::stateful_actor<core_state>* self,
       if (i != st.pending_peers.end()) {
         i->second.rp.deliver(peer_hdl);
         st.pending_peers.erase(i);
+        // Only the initiating side connects the shards to avoid racing
+        // handshakes for the same pair of shards.
+        st.peer_shards(peer_hdl, true);
       }
     },
     // Step #3: - A establishes a stream to B
@@ -388,6 +456,9 @@ caf::behavior core_actor(caf::stateful_actor<core_state>* self,
         st.policy().block_peer(peer_hdl);
       st.emit_peer_added_status(peer_hdl, "handshake successful");
       st.policy().ack_peering(in, peer_hdl);
+      // The initiating side may not use shards at all, so we check on our
+      // end as well.
+      st.peer_shards(peer_hdl, false);
     },
     // --- asynchronous communication to peers ---------------------------------
     [=](atom::update, filter_type f) {
@@ -448,6 +519,18 @@ caf::behavior core_actor(caf::stateful_actor<core_state>* self,
       BROKER_TRACE(BROKER_ARG(x));
       self->state.policy().push(std::move(x));
     },
+    [=](atom::publish, std::vector<data_message>& xs) {
+      BROKER_TRACE(BROKER_ARG2("num_msgs", xs.size()));
+      self->state.policy().push(std::move(xs));
+    },
+    [=](atom::publish, std::vector<command_message>& xs) {
+      BROKER_TRACE(BROKER_ARG2("num_msgs", xs.size()));
+      self->state.policy().push(std::move(xs));
+    },
+    [=](atom::publish, node_message& x) {
+      BROKER_TRACE(BROKER_ARG(x));
+      self->state.policy().push(std::move(x));
+    },
     // --- communication to local actors only, i.e., never forward to peers ----
     [=](atom::publish, atom::local, data_message& x) {
       BROKER_TRACE(BROKER_ARG(x));
@@ -505,7 +588,8 @@ caf::behavior core_actor(caf::stateful_actor<core_state>* self,
       BROKER_ASSERT(ptr);
       BROKER_INFO("spawning new master");
       auto ms = self->spawn<caf::linked + caf::lazy_init>(
-              detail::master_actor, self, name, std::move(ptr), clock);
+              detail::master_actor, self, name, std::move(ptr),
+              st.options.replication_log_size, clock);
       st.masters.emplace(name, ms);
       // Initiate stream handshake and add subscriber to the governor.
       using value_type = store::stream_type::value_type;
@@ -525,7 +609,8 @@ caf::behavior core_actor(caf::stateful_actor<core_state>* self,
     },
     [=](atom::store, atom::clone, atom::attach, std::string& name,
         double resync_interval, double stale_interval,
-        double mutation_buffer_interval) -> caf::result<caf::actor> {
+        double mutation_buffer_interval,
+        detail::clone_view_ptr& view) -> caf::result<caf::actor> {
       BROKER_INFO("attaching clone:" << name);
 
       auto i = self->state.masters.find(name);
@@ -546,7 +631,7 @@ caf::behavior core_actor(caf::stateful_actor<core_state>* self,
       BROKER_INFO("spawning new clone");
       auto clone = self->spawn<linked + lazy_init>(
               detail::clone_actor, self, name, resync_interval, stale_interval,
-              mutation_buffer_interval, clock);
+              mutation_buffer_interval, std::move(view), clock);
       auto cptr = actor_cast<strong_actor_ptr>(clone);
       auto& st = self->state;
       st.clones.emplace(name, clone);
@@ -623,11 +708,13 @@ caf::behavior core_actor(caf::stateful_actor<core_state>* self,
       */
     },
     [=](atom::store, atom::master, atom::snapshot, const std::string& name,
-        caf::actor& clone) {
-      // Instruct master to generate a snapshot.
+        caf::actor& clone, sequence_number since) {
+      // Instruct master to generate a snapshot (or to send all commands after
+      // `since` if possible).
       self->state.policy().push(make_command_message(
         name / topics::master_suffix,
-        make_internal_command<snapshot_command>(self, std::move(clone))));
+        make_internal_command<snapshot_command>(self, std::move(clone),
+                                                since)));
     },
     [=](atom::store, atom::master, atom::get,
         const std::string& name) -> result<actor> {
@@ -698,17 +785,41 @@ caf::behavior core_actor(caf::stateful_actor<core_state>* self,
         result.erase(e, result.end());
       return result;
     },
+    [=](atom::get, atom::peer, atom::lanes) {
+      return self->state.policy().get_lane_depths();
+    },
+    [=](atom::get, atom::peer, atom::batching) {
+      return self->state.policy().get_batching_info();
+    },
+    [=](atom::get, atom::peer, atom::buffers) {
+      return self->state.policy().get_peer_buffers();
+    },
     // --- destructive state manipulations -------------------------------------
     [=](atom::unpeer, network_info addr) {
       auto& st = self->state;
       auto x = self->state.cache.find(addr);
       if (!x || !st.policy().remove_peer(*x, caf::none, false, true))
         st.emit_error<ec::peer_invalid>(addr, "no such peer when unpeering");
+      else
+        st.unpeer_shards(*x);
     },
     [=](atom::unpeer, actor x) {
       auto& st = self->state;
       if (!x || !st.policy().remove_peer(x, caf::none, false, true))
         st.emit_error<ec::peer_invalid>(x, "no such peer when unpeering");
+      else
+        st.unpeer_shards(x);
+    },
+    [=](atom::unpeer, atom::shard, const caf::node_id& remote_node) {
+      // Sent by the primary core after removing a peer.
+      auto& st = self->state;
+      std::vector<actor> hdls;
+      st.policy().for_each_peer([&](const actor& hdl) {
+        if (hdl.node() == remote_node)
+          hdls.emplace_back(hdl);
+      });
+      for (auto& hdl : hdls)
+        st.policy().remove_peer(hdl, caf::none, false, true);
     },
     [=](atom::no_events) {
       // TODO: add extra state flag? Ingore?
@@ -756,7 +867,29 @@ caf::behavior core_actor(caf::stateful_actor<core_state>* self,
     },
     [=](atom::add, atom::status, caf::actor& ss) {
       self->state.status_subscribers.emplace(std::move(ss));
+    },
+    // --- sharding ------------------------------------------------------------
+    [=](atom::shard, std::vector<caf::actor>& shards) {
+      self->state.shards = std::move(shards);
+    },
+    [=](atom::get, atom::shard) {
+      return static_cast<uint32_t>(self->state.shards.size() + 1);
+    },
+    [=](atom::get, atom::shard, uint32_t i) -> result<actor> {
+      auto& shards = self->state.shards;
+      if (i == 0)
+        return actor{self};
+      if (i > shards.size())
+        return sec::invalid_argument;
+      return shards[i - 1];
     }};
 }
 
+caf::behavior core_shard(caf::stateful_actor<core_state>* self,
+                         caf::actor primary, broker_options options,
+                         endpoint::clock* clock) {
+  self->state.primary = std::move(primary);
+  return core_actor(self, filter_type{}, std::move(options), clock);
+}
+
 } // namespace broker
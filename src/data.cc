@@ -1,4 +1,10 @@
 #include "broker/data.hh"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
 #include "broker/convert.hh"
 
 namespace broker {
@@ -178,91 +184,309 @@ const char* data::get_type_name() const {
 
 namespace {
 
-template <class Container>
-void container_convert(Container& c, std::string& str,
-                       const char* left, const char* right,
-                       const char* delim = ", ") {
-  auto first = begin(c);
-  auto last = end(c);
-  str += left;
-  if (first != last) {
-    str += to_string(*first);
-    while (++first != last)
-      str += delim + to_string(*first);
-  }
-  str += right;
-}
-
-struct data_converter {
-  using result_type = bool;
+struct hasher {
+  using result_type = size_t;
 
   template <class T>
-  result_type operator()(const T& x) {
-    return convert(x, str);
+  result_type operator()(const T& x) const {
+    return std::hash<T>{}(x);
   }
 
-  result_type operator()(bool b) {
-    str = b ? 'T' : 'F';
-    return true;
+  result_type operator()(const std::string& x) const {
+    return detail::hash_bytes(x.data(), x.size());
   }
+};
+
+} // namespace
 
-  result_type operator()(const std::string& x) {
-    str = x;
-    return true;
+size_t data::hash() const {
+  size_t result = 0;
+  detail::hash_combine(result, data_.index());
+  detail::hash_combine(result, caf::visit(hasher{}, data_));
+  return result;
+}
+
+namespace {
+
+// Renders values directly into a string buffer. Nested values append to the
+// same buffer, i.e., rendering a value creates no intermediate strings.
+struct data_renderer {
+  using result_type = void;
+
+  template <class T>
+  void integral(T x) {
+    char tmp[24];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), x);
+    buf.append(tmp, res.ptr);
   }
 
-  std::string& str;
+  // Renders `x` as JSON string with the textual format as content. Only for
+  // types whose textual format contains no characters that require escaping.
+  template <class T>
+  void quoted(const T& x) {
+    buf += '"';
+    json = false;
+    (*this)(x);
+    json = true;
+    buf += '"';
+  }
+
+  void escaped(const std::string& x) {
+    static constexpr char hex[] = "0123456789abcdef";
+    buf += '"';
+    for (auto c : x) {
+      switch (c) {
+        case '"':
+          buf += "\\\"";
+          break;
+        case '\\':
+          buf += "\\\\";
+          break;
+        case '\b':
+          buf += "\\b";
+          break;
+        case '\f':
+          buf += "\\f";
+          break;
+        case '\n':
+          buf += "\\n";
+          break;
+        case '\r':
+          buf += "\\r";
+          break;
+        case '\t':
+          buf += "\\t";
+          break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20) {
+            buf += "\\u00";
+            buf += hex[(c >> 4) & 0x0F];
+            buf += hex[c & 0x0F];
+          } else {
+            buf += c;
+          }
+      }
+    }
+    buf += '"';
+  }
+
+  template <class Container>
+  void sequence(const Container& xs, const char* left, const char* right) {
+    buf += left;
+    auto first = xs.begin();
+    auto last = xs.end();
+    if (first != last) {
+      (*this)(*first);
+      while (++first != last) {
+        buf += json ? "," : ", ";
+        (*this)(*first);
+      }
+    }
+    buf += right;
+  }
+
+  void operator()(none) {
+    buf += json ? "null" : "nil";
+  }
+
+  void operator()(boolean x) {
+    if (json)
+      buf += x ? "true" : "false";
+    else
+      buf += x ? 'T' : 'F';
+  }
+
+  void operator()(count x) {
+    integral(x);
+  }
+
+  void operator()(integer x) {
+    integral(x);
+  }
+
+  void operator()(real x) {
+    char tmp[64];
+    int n;
+    if (json) {
+      // JSON has no representation for NaN and infinity.
+      if (!std::isfinite(x)) {
+        buf += "null";
+        return;
+      }
+      // Prefer the shorter representation unless it loses precision.
+      n = std::snprintf(tmp, sizeof(tmp), "%.15g", x);
+      if (std::strtod(tmp, nullptr) != x)
+        n = std::snprintf(tmp, sizeof(tmp), "%.17g", x);
+    } else {
+      // Same format as std::to_string, which may exceed our buffer for very
+      // large values.
+      n = std::snprintf(tmp, sizeof(tmp), "%f", x);
+      if (n < 0 || static_cast<size_t>(n) >= sizeof(tmp)) {
+        buf += std::to_string(x);
+        return;
+      }
+    }
+    buf.append(tmp, static_cast<size_t>(n));
+  }
+
+  void operator()(const std::string& x) {
+    if (json)
+      escaped(x);
+    else
+      buf += x;
+  }
+
+  void operator()(const address& x) {
+    if (json) {
+      quoted(x);
+    } else if (x.is_v4()) {
+      auto& bytes = x.bytes();
+      for (size_t i = 12; i < 16; ++i) {
+        if (i > 12)
+          buf += '.';
+        integral(bytes[i]);
+      }
+    } else {
+      // IPv6 addresses are rare enough to not warrant a custom implementation
+      // of the zero compression.
+      buf += to_string(x);
+    }
+  }
+
+  void operator()(const subnet& x) {
+    if (json) {
+      quoted(x);
+    } else {
+      (*this)(x.network());
+      buf += '/';
+      integral(x.length());
+    }
+  }
+
+  void operator()(port x) {
+    if (json) {
+      quoted(x);
+      return;
+    }
+    integral(x.number());
+    switch (x.type()) {
+      default:
+        buf += "/?";
+        break;
+      case port::protocol::tcp:
+        buf += "/tcp";
+        break;
+      case port::protocol::udp:
+        buf += "/udp";
+        break;
+      case port::protocol::icmp:
+        buf += "/icmp";
+        break;
+    }
+  }
+
+  void operator()(timestamp x) {
+    (*this)(x.time_since_epoch());
+  }
+
+  void operator()(timespan x) {
+    if (json) {
+      quoted(x);
+    } else {
+      integral(x.count());
+      buf += "ns";
+    }
+  }
+
+  void operator()(const enum_value& x) {
+    (*this)(x.name);
+  }
+
+  void operator()(const table::value_type& x) {
+    if (json) {
+      buf += '[';
+      (*this)(x.first);
+      buf += ',';
+      (*this)(x.second);
+      buf += ']';
+    } else {
+      (*this)(x.first);
+      buf += " -> ";
+      (*this)(x.second);
+    }
+  }
+
+  void operator()(const vector& xs) {
+    if (json)
+      sequence(xs, "[", "]");
+    else
+      sequence(xs, "(", ")");
+  }
+
+  void operator()(const set& xs) {
+    if (json)
+      sequence(xs, "[", "]");
+    else
+      sequence(xs, "{", "}");
+  }
+
+  void operator()(const table& xs) {
+    if (json)
+      sequence(xs, "[", "]");
+    else
+      sequence(xs, "{", "}");
+  }
+
+  void operator()(const data& x) {
+    caf::visit(*this, x);
+  }
+
+  std::string& buf;
+  bool json;
 };
 
 } // namespace <anonymous>
 
 bool convert(const table::value_type& e, std::string& str) {
-  str += to_string(e.first) + " -> " + to_string(e.second);
+  data_renderer{str, false}(e);
   return true;
 }
 
 bool convert(const vector& v, std::string& str) {
-  container_convert(v, str, "(", ")");
+  data_renderer{str, false}(v);
   return true;
 }
 
 bool convert(const set& s, std::string& str) {
-  container_convert(s, str, "{", "}");
+  data_renderer{str, false}(s);
   return true;
 }
 
 bool convert(const table& t, std::string& str) {
-  container_convert(t, str, "{", "}");
+  data_renderer{str, false}(t);
   return true;
 }
 
 bool convert(const data& d, std::string& str) {
-  caf::visit(data_converter{str}, d);
+  str.clear();
+  render(d, str);
   return true;
 }
 
-} // namespace broker
-
-namespace std {
-
-namespace {
+void render(const data& x, std::string& buf) {
+  data_renderer{buf, false}(x);
+}
 
-struct hasher {
-  using result_type = size_t;
+void render_json(const data& x, std::string& buf) {
+  data_renderer{buf, true}(x);
+}
 
-  template <class T>
-  result_type operator()(const T& x) const {
-    return std::hash<T>{}(x);
-  }
-};
+} // namespace broker
 
-} // namespace <anonymous>
+namespace std {
 
 size_t hash<broker::data>::operator()(const broker::data& v) const {
-  size_t result = 0;
-  broker::detail::hash_combine(result, v.get_data().index());
-  broker::detail::hash_combine(result, caf::visit(hasher{}, v));
-  return result;
+  return v.hash();
 }
 
 } // namespace std
@@ -0,0 +1,356 @@
+#include "broker/data_view.hh"
+
+#include <cstring>
+
+#include <caf/binary_serializer.hpp>
+
+namespace broker {
+
+namespace compact = detail::compact_encoding;
+
+// -- properties ---------------------------------------------------------------
+
+data::type data_view::get_type() const {
+  if (!valid())
+    return data::type::none;
+  switch (index()) {
+    default:
+      return data::type::none;
+    case tag_of<boolean>():
+      return data::type::boolean;
+    case tag_of<count>():
+      return data::type::count;
+    case tag_of<integer>():
+      return data::type::integer;
+    case tag_of<real>():
+      return data::type::real;
+    case tag_of<std::string>():
+      return data::type::string;
+    case tag_of<address>():
+      return data::type::address;
+    case tag_of<subnet>():
+      return data::type::subnet;
+    case tag_of<port>():
+      return data::type::port;
+    case tag_of<timestamp>():
+      return data::type::timestamp;
+    case tag_of<timespan>():
+      return data::type::timespan;
+    case tag_of<enum_value>():
+      return data::type::enum_value;
+    case tag_of<set>():
+      return data::type::set;
+    case tag_of<table>():
+      return data::type::table;
+    case tag_of<vector>():
+      return data::type::vector;
+  }
+}
+
+template <class T>
+optional<T> data_view::as_scalar() const {
+  if (!is<T>())
+    return nil;
+  if (compact_) {
+    auto x = materialize();
+    if (!x)
+      return nil;
+    return get<T>(*x);
+  }
+  auto source = make_source();
+  // Skip the type tag.
+  source.skip(1);
+  T result;
+  if (source(result))
+    return nil;
+  return result;
+}
+
+template <>
+optional<boolean> data_view::as<boolean>() const {
+  return as_scalar<boolean>();
+}
+
+template <>
+optional<count> data_view::as<count>() const {
+  return as_scalar<count>();
+}
+
+template <>
+optional<integer> data_view::as<integer>() const {
+  return as_scalar<integer>();
+}
+
+template <>
+optional<real> data_view::as<real>() const {
+  return as_scalar<real>();
+}
+
+template <>
+optional<std::string_view> data_view::as<std::string_view>() const {
+  if (!is<std::string>())
+    return nil;
+  size_t n = 0;
+  if (compact_) {
+    auto pos = compact::read_string(first_, last_, n);
+    if (pos == nullptr)
+      return nil;
+    return std::string_view{pos, n};
+  }
+  auto pos = enter(n);
+  if (pos == nullptr || n > static_cast<size_t>(last_ - pos))
+    return nil;
+  return std::string_view{pos, n};
+}
+
+template <>
+optional<address> data_view::as<address>() const {
+  return as_scalar<address>();
+}
+
+template <>
+optional<subnet> data_view::as<subnet>() const {
+  return as_scalar<subnet>();
+}
+
+template <>
+optional<port> data_view::as<port>() const {
+  return as_scalar<port>();
+}
+
+template <>
+optional<timestamp> data_view::as<timestamp>() const {
+  return as_scalar<timestamp>();
+}
+
+template <>
+optional<timespan> data_view::as<timespan>() const {
+  return as_scalar<timespan>();
+}
+
+template <>
+optional<enum_value> data_view::as<enum_value>() const {
+  return as_scalar<enum_value>();
+}
+
+// -- container access ---------------------------------------------------------
+
+size_t data_view::size() const {
+  if (!is<vector>() && !is<set>() && !is<table>())
+    return 0;
+  size_t n = 0;
+  if (enter(n) == nullptr)
+    return 0;
+  return n;
+}
+
+data_view data_view::operator[](size_t i) const {
+  if (!is<vector>() && !is<set>())
+    return {};
+  size_t n = 0;
+  auto pos = enter(n);
+  if (pos == nullptr || i >= n)
+    return {};
+  optional<timestamp> base;
+  for (size_t j = 0; j < i; ++j) {
+    next(pos, base);
+    if (pos == nullptr)
+      return {};
+  }
+  return next(pos, base);
+}
+
+bool data_view::contains(const data& key) const {
+  return lookup(key).valid();
+}
+
+data_view data_view::find(const data& key) const {
+  if (!is<table>())
+    return {};
+  return lookup(key);
+}
+
+// -- conversion ---------------------------------------------------------------
+
+optional<data> data_view::materialize() const {
+  if (!valid())
+    return nil;
+  data result;
+  if (compact_) {
+    auto base = base_ ? &*base_ : nullptr;
+    if (compact::read(first_, last_, result, base) == nullptr)
+      return nil;
+    return result;
+  }
+  auto source = make_source();
+  if (source(result))
+    return nil;
+  return result;
+}
+
+// -- parsing ------------------------------------------------------------------
+
+const char* data_view::enter(size_t& size) const {
+  if (first_ == last_)
+    return nullptr;
+  if (compact_)
+    return compact::read_size(first_, last_, size);
+  auto source = make_source();
+  source.skip(1);
+  if (source.begin_sequence(size))
+    return nullptr;
+  return source.current();
+}
+
+data_view data_view::next(const char*& pos, optional<timestamp>& base) const {
+  data_view x{pos, last_, compact_, base};
+  auto n = x.extent();
+  if (n == 0)
+    pos = nullptr;
+  else
+    pos += n;
+  if (compact_ && x.is<timestamp>())
+    base = x.as<timestamp>();
+  return x;
+}
+
+size_t data_view::extent() const {
+  if (!valid())
+    return 0;
+  if (compact_) {
+    auto pos = compact::skip(first_, last_);
+    return pos != nullptr ? static_cast<size_t>(pos - first_) : 0;
+  }
+  auto source = make_source();
+  source.skip(1);
+  auto skip_scalar = [&](auto tmp) {
+    return !source(tmp);
+  };
+  auto skip_bytes = [&] {
+    size_t n = 0;
+    if (source.begin_sequence(n) || n > source.remaining())
+      return false;
+    source.skip(n);
+    return true;
+  };
+  auto skip_elements = [&](size_t values_per_element) {
+    size_t n = 0;
+    if (source.begin_sequence(n))
+      return false;
+    for (size_t i = 0; i < n * values_per_element; ++i) {
+      data_view x{source.current(), last_, false, nil};
+      auto len = x.extent();
+      if (len == 0)
+        return false;
+      source.skip(len);
+    }
+    return true;
+  };
+  auto ok = false;
+  switch (tag()) {
+    case tag_of<none>():
+      ok = true;
+      break;
+    case tag_of<boolean>():
+      ok = skip_scalar(boolean{});
+      break;
+    case tag_of<count>():
+      ok = skip_scalar(count{});
+      break;
+    case tag_of<integer>():
+      ok = skip_scalar(integer{});
+      break;
+    case tag_of<real>():
+      ok = skip_scalar(real{});
+      break;
+    case tag_of<std::string>():
+    case tag_of<enum_value>():
+      ok = skip_bytes();
+      break;
+    case tag_of<address>():
+      ok = skip_scalar(address{});
+      break;
+    case tag_of<subnet>():
+      ok = skip_scalar(subnet{});
+      break;
+    case tag_of<port>():
+      ok = skip_scalar(port{});
+      break;
+    case tag_of<timestamp>():
+      ok = skip_scalar(timestamp{});
+      break;
+    case tag_of<timespan>():
+      ok = skip_scalar(timespan{});
+      break;
+    case tag_of<set>():
+    case tag_of<vector>():
+      ok = skip_elements(1);
+      break;
+    case tag_of<table>():
+      ok = skip_elements(2);
+      break;
+  }
+  if (!ok)
+    return 0;
+  return static_cast<size_t>(source.current() - first_);
+}
+
+data_view data_view::lookup(const data& key) const {
+  if (!is<set>() && !is<table>())
+    return {};
+  // Equal values have equal encodings in both formats, since sets and tables
+  // serialize their elements in order. Hence, comparing bytes is sufficient.
+  std::vector<char> buf;
+  if (compact_)
+    compact::write(key, buf);
+  else if (!make_data_view(key, buf).valid())
+    return {};
+  size_t n = 0;
+  auto pos = enter(n);
+  if (pos == nullptr)
+    return {};
+  auto with_value = is<table>();
+  optional<timestamp> base;
+  for (size_t i = 0; i < n; ++i) {
+    auto first = pos;
+    auto x = next(pos, base);
+    if (pos == nullptr)
+      return {};
+    auto len = static_cast<size_t>(pos - first);
+    auto match = len == buf.size() && memcmp(first, buf.data(), len) == 0;
+    if (with_value) {
+      auto y = next(pos, base);
+      if (match)
+        return y;
+      if (pos == nullptr)
+        return {};
+    } else if (match) {
+      return x;
+    }
+  }
+  return {};
+}
+
+data_view make_data_view(const data& x, std::vector<char>& buf) {
+  buf.clear();
+  caf::binary_serializer sink{nullptr, buf};
+  if (sink(const_cast<data&>(x)))
+    return {};
+  return {buf.data(), buf.size()};
+}
+
+bool convert(const data_view& x, data& y) {
+  if (auto val = x.materialize()) {
+    y = std::move(*val);
+    return true;
+  }
+  return false;
+}
+
+bool convert(const data_view& x, std::string& str) {
+  if (auto val = x.materialize())
+    return convert(*val, str);
+  return false;
+}
+
+} // namespace broker
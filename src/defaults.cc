@@ -1,5 +1,6 @@
 #include "broker/defaults.hh"
 
+#include <chrono>
 #include <limits>
 
 namespace broker {
@@ -9,5 +10,7 @@ const caf::string_view recording_directory = "";
 
 const size_t output_generator_file_cap = std::numeric_limits<size_t>::max();
 
+const timespan expiry_tick_interval = std::chrono::milliseconds(100);
+
 } // namespace defaults
 } // namespace broker
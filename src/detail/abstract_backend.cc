@@ -1,10 +1,36 @@
 #include "broker/detail/appliers.hh"
 #include "broker/detail/abstract_backend.hh"
 
+#include <iterator>
+#include <utility>
+
 namespace broker {
 namespace detail {
 
-expected<void> abstract_backend::add(const data& key, const data& value,
+namespace {
+
+/// Iterates over a fully materialized snapshot.
+class snapshot_cursor : public backend_cursor {
+public:
+  explicit snapshot_cursor(broker::snapshot xs)
+    : xs_(std::move(xs)), pos_(xs_.begin()) {
+    // nop
+  }
+
+  expected<bool> next(size_t n, std::vector<snapshot_entry>& xs) override {
+    for (; n > 0 && pos_ != xs_.end(); --n, ++pos_)
+      xs.emplace_back(pos_->first, std::move(pos_->second));
+    return pos_ != xs_.end();
+  }
+
+private:
+  broker::snapshot xs_;
+  broker::snapshot::iterator pos_;
+};
+
+} // namespace
+
+expected<void> abstract_backend::add(const data& key, data value,
                                      data::type init_type,
                                      optional<timestamp> expiry) {
   auto v = get(key);
@@ -14,10 +40,10 @@ expected<void> abstract_backend::add(const data& key, const data& value,
   v = expected<data>{data::from_type(init_type)};
   }
 
-  auto result = caf::visit(adder{value}, *v);
+  auto result = caf::visit(adder{std::move(value)}, *v);
   if (!result)
     return result;
-  return put(key, *v, expiry);
+  return put(key, std::move(*v), expiry);
 }
 
 expected<void> abstract_backend::subtract(const data& key, const data& value,
@@ -28,7 +54,22 @@ expected<void> abstract_backend::subtract(const data& key, const data& value,
   auto result = caf::visit(remover{value}, *v);
   if (!result)
     return result;
-  return put(key, *v, expiry);
+  return put(key, std::move(*v), expiry);
+}
+
+expected<void> abstract_backend::begin_batch() {
+  return {};
+}
+
+expected<void> abstract_backend::commit_batch() {
+  return {};
+}
+
+expected<backend_cursor_ptr> abstract_backend::cursor() const {
+  auto ss = snapshot();
+  if (!ss)
+    return ss.error();
+  return {std::make_unique<snapshot_cursor>(std::move(*ss))};
 }
 
 expected<data> abstract_backend::get(const data& key, const data& value) const {
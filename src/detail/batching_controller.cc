@@ -0,0 +1,96 @@
+#include "broker/detail/batching_controller.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace broker {
+namespace detail {
+
+namespace {
+
+/// Weight of a new sample when updating the rate.
+constexpr double rate_weight = 0.25;
+
+/// Weight of a new sample when updating the round-trip time.
+constexpr double rtt_weight = 0.125;
+
+/// Minimum duration of a single rate sample.
+constexpr auto min_sample_duration = std::chrono::milliseconds(1);
+
+double seconds(timespan x) {
+  return std::chrono::duration<double>(x).count();
+}
+
+} // namespace
+
+void batching_controller::before_emit(time_point now, size_t buffered,
+                                      int32_t open_credit) {
+  auto first_call = sample_start_ == time_point{};
+  if (first_call)
+    sample_start_ = now;
+  // The buffer only grows between two emits. Messages that arrived before the
+  // first call don't belong to any sample.
+  if (buffered > buffered_) {
+    if (buffered_ == 0)
+      oldest_buffered_ = now;
+    if (!first_call)
+      arrivals_ += buffered - buffered_;
+  }
+  buffered_ = buffered;
+  auto dt = now - sample_start_;
+  if (dt >= min_sample_duration) {
+    auto sample = arrivals_ / seconds(dt);
+    if (rate_ == 0)
+      rate_ = sample;
+    else
+      rate_ = rate_weight * sample + (1 - rate_weight) * rate_;
+    arrivals_ = 0;
+    sample_start_ = now;
+  }
+  // The credit only grows when receiving an acknowledgement.
+  if (awaiting_ack_ && open_credit > credit_) {
+    auto sample = std::chrono::duration_cast<timespan>(now - oldest_unacked_);
+    if (rtt_.count() == 0)
+      rtt_ = sample;
+    else
+      rtt_ = timespan{static_cast<timespan::rep>(
+        rtt_weight * sample.count() + (1 - rtt_weight) * rtt_.count())};
+    awaiting_ack_ = false;
+  }
+  credit_ = open_credit;
+}
+
+void batching_controller::after_emit(time_point now, size_t buffered,
+                                     int32_t open_credit) {
+  if (open_credit < credit_ && !awaiting_ack_) {
+    oldest_unacked_ = now;
+    awaiting_ack_ = true;
+  }
+  buffered_ = buffered;
+  credit_ = open_credit;
+}
+
+int32_t batching_controller::batch_size(const settings& cfg,
+                                        int32_t current) {
+  if (current != assigned_)
+    requested_ = current;
+  if (requested_ <= 0)
+    return current;
+  // Messages that arrive within the latency target form a batch.
+  auto wanted = std::ceil(rate_ * seconds(cfg.latency_target));
+  auto upper = static_cast<double>(requested_);
+  assigned_ = static_cast<int32_t>(std::max(1.0, std::min(wanted, upper)));
+  return assigned_;
+}
+
+bool batching_controller::flush(const settings& cfg, time_point now) const {
+  return buffered_ > 0 && now - oldest_buffered_ >= cfg.latency_target;
+}
+
+size_t batching_controller::credit_target(const settings& cfg) const {
+  auto r = std::max(rate_, static_cast<double>(cfg.throughput_target));
+  return static_cast<size_t>(std::ceil(r * seconds(rtt_)));
+}
+
+} // namespace detail
+} // namespace broker
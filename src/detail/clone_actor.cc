@@ -10,11 +10,16 @@
 #include <caf/make_message.hpp>
 #include <caf/system_messages.hpp>
 #include <caf/stateful_actor.hpp>
+#include <caf/stream.hpp>
+#include <caf/stream_sink.hpp>
+#include <caf/downstream_msg.hpp>
+#include <caf/inbound_path.hpp>
 
 #include "broker/atoms.hh"
 #include "broker/convert.hh"
 #include "broker/data.hh"
 #include "broker/error.hh"
+#include "broker/snapshot.hh"
 #include "broker/store.hh"
 #include "broker/topic.hh"
 
@@ -32,6 +37,35 @@ static double now(endpoint::clock* clock)
   return std::chrono::duration_cast<std::chrono::duration<double>>(d).count();
   }
 
+namespace {
+
+/// Applies each batch of updates from the core before publishing a new
+/// version of the clone's view.
+class clone_sink : public caf::stream_sink<command_message> {
+public:
+  using super = caf::stream_sink<command_message>;
+
+  clone_sink(caf::scheduled_actor* self, clone_state* state)
+    : caf::stream_manager(self), super(self), state_(state) {
+    // nop
+  }
+
+protected:
+  void handle(caf::inbound_path*, caf::downstream_msg::batch& x) override {
+    using vec_type = std::vector<command_message>;
+    if (x.xs.match_elements<vec_type>()) {
+      state_->update(x.xs.get_mutable_as<vec_type>(0));
+      return;
+    }
+    BROKER_ERROR("received unexpected batch type (dropped)");
+  }
+
+private:
+  clone_state* state_;
+};
+
+} // namespace
+
 clone_state::clone_state() : self(nullptr), name(), master_topic(), core(),
   master(), store(), is_stale(), stale_time(), unmutable_time(),
   mutation_buffer(), pending_remote_updates(), awaiting_snapshot(),
@@ -40,7 +74,8 @@ clone_state::clone_state() : self(nullptr), name(), master_topic(), core(),
 }
 
 void clone_state::init(caf::event_based_actor* ptr, std::string&& nm,
-                       caf::actor&& parent, endpoint::clock* ep_clock) {
+                       caf::actor&& parent, clone_view_ptr&& vp,
+                       endpoint::clock* ep_clock) {
 
   self = ptr;
   name = std::move(nm);
@@ -50,6 +85,7 @@ void clone_state::init(caf::event_based_actor* ptr, std::string&& nm,
   is_stale = true;
   stale_time = -1.0;
   unmutable_time = -1.0;
+  view = std::move(vp);
   clock = ep_clock;
   awaiting_snapshot = true;
   awaiting_snapshot_sync = true;
@@ -62,10 +98,37 @@ void clone_state::forward(internal_command&& x) {
 
 void clone_state::command(internal_command::variant_type& cmd) {
   caf::visit(*this, cmd);
+  view_dirty = true;
 }
 
 void clone_state::command(internal_command& cmd) {
   command(cmd.content);
+  // We only see commands after our sync point here. The sync point itself
+  // marks the state of the snapshot (or delta) that we receive.
+  if (cmd.seq != 0 && !awaiting_snapshot_sync)
+    last_seq = cmd.seq;
+}
+
+void clone_state::update(internal_command& cmd) {
+  if (caf::holds_alternative<snapshot_sync_command>(cmd.content)) {
+    command(cmd);
+    return;
+  }
+  if (awaiting_snapshot_sync)
+    return;
+  if (awaiting_snapshot) {
+    pending_remote_updates.emplace_back(std::move(cmd));
+    return;
+  }
+  command(cmd);
+}
+
+void clone_state::update(std::vector<command_message>& xs) {
+  // TODO: our operator() overloads require mutable references, but only a
+  //       fraction actually benefit from it.
+  for (auto& x : xs)
+    update(std::get<1>(x.unshared()));
+  publish();
 }
 
 void clone_state::operator()(none) {
@@ -74,11 +137,7 @@ void clone_state::operator()(none) {
 
 void clone_state::operator()(put_command& x) {
   BROKER_INFO("PUT" << x.key << "->" << x.value << "with expiry" << x.expiry);
-  auto i = store.find(x.key);
-  if (i != store.end())
-    i->second = std::move(x.value);
-  else
-    store.emplace(std::move(x.key), std::move(x.value));
+  store.insert_or_assign(std::move(x.key), std::move(x.value));
 }
 
 void clone_state::operator()(put_unique_command& x) {
@@ -93,17 +152,18 @@ void clone_state::operator()(erase_command& x) {
 
 void clone_state::operator()(add_command& x) {
   BROKER_INFO("ADD" << x.key << "->" << x.value);
-  auto i = store.find(x.key);
-  if (i == store.end())
-    i = store.emplace(std::move(x.key), data::from_type(x.init_type)).first;
-  caf::visit(adder{x.value}, i->second);
+  auto v = store.find_mutable(x.key);
+  if (v == nullptr) {
+    store.emplace(x.key, data::from_type(x.init_type));
+    v = store.find_mutable(x.key);
+  }
+  caf::visit(adder{std::move(x.value)}, *v);
 }
 
 void clone_state::operator()(subtract_command& x) {
   BROKER_INFO("SUBTRACT" << x.key << "->" << x.value);
-  auto i = store.find(x.key);
-  if (i != store.end()) {
-    caf::visit(remover{x.value}, i->second);
+  if (auto v = store.find_mutable(x.key)) {
+    caf::visit(remover{x.value}, *v);
   } else {
     // can happen if we joined a stream but did not yet receive set_command
     BROKER_WARNING("received substract_command for unknown key");
@@ -122,7 +182,7 @@ void clone_state::operator()(snapshot_sync_command& x) {
 
 void clone_state::operator()(set_command& x) {
   BROKER_INFO("SET" << x.state);
-  store = std::move(x.state);
+  store = clone_map{x.state.begin(), x.state.end()};
 }
 
 void clone_state::operator()(clear_command&) {
@@ -130,10 +190,60 @@ void clone_state::operator()(clear_command&) {
   store.clear();
 }
 
+void clone_state::install_snapshot(clone_map&& x) {
+  store = std::move(x);
+  view_dirty = true;
+  catch_up();
+}
+
+void clone_state::install_delta(std::vector<internal_command>& xs) {
+  // The delta ends right before our sync point. Hence, these commands must
+  // not touch last_seq.
+  for (auto& x : xs)
+    command(x.content);
+  catch_up();
+}
+
+void clone_state::catch_up() {
+  awaiting_snapshot = false;
+  if (!awaiting_snapshot_sync) {
+    for (auto& update : pending_remote_updates)
+      command(update);
+    pending_remote_updates.clear();
+    pending_remote_updates.shrink_to_fit();
+  }
+  publish();
+}
+
+void clone_state::request_snapshot(sequence_number since) {
+  self->send(core, atom::store::value, atom::master::value,
+             atom::snapshot::value, name, self, since);
+}
+
+void clone_state::restart_snapshot() {
+  // Our store reflects no state of the master after an incomplete snapshot.
+  // Hence, we start over as if we had lost the master.
+  last_seq = 0;
+  awaiting_snapshot = true;
+  awaiting_snapshot_sync = true;
+  pending_remote_updates.clear();
+  pending_remote_updates.shrink_to_fit();
+  ++snapshot_generation;
+  incoming_snapshot.clear();
+  if (master)
+    request_snapshot(0);
+}
+
+void clone_state::publish() {
+  if (view == nullptr || !view_dirty)
+    return;
+  view->publish(store, is_stale);
+  view_dirty = false;
+}
+
 data clone_state::keys() const {
   set result;
-  for (auto& kvp : store)
-    result.emplace(kvp.first);
+  store.for_each([&](const data& key, const data&) { result.emplace(key); });
   return result;
 }
 
@@ -141,9 +251,14 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
                           caf::actor core, std::string name,
                           double resync_interval, double stale_interval,
                           double mutation_buffer_interval,
-                          endpoint::clock* clock) {
+                          clone_view_ptr view, endpoint::clock* clock) {
   self->monitor(core);
-  self->state.init(self, std::move(name), std::move(core), clock);
+  if (view != nullptr) {
+    // Readers must not see the content of a clone that no longer exists.
+    self->attach_functor([view] { view->publish({}, true); });
+  }
+  self->state.init(self, std::move(name), std::move(core), std::move(view),
+                   clock);
   self->set_down_handler(
     [=](const caf::down_msg& msg) {
       if (msg.source == core) {
@@ -151,11 +266,17 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
         self->quit(msg.reason);
       } else {
         BROKER_INFO("lost master");
+        // Without a complete snapshot, our store isn't in sync with the
+        // master and the next master must send us a full snapshot.
+        if (self->state.awaiting_snapshot)
+          self->state.last_seq = 0;
         self->state.master = nullptr;
         self->state.awaiting_snapshot = true;
         self->state.awaiting_snapshot_sync = true;
         self->state.pending_remote_updates.clear();
         self->state.pending_remote_updates.shrink_to_fit();
+        ++self->state.snapshot_generation;
+        self->state.incoming_snapshot.clear();
         self->send(self, atom::master::value, atom::resolve::value);
 
         if ( stale_interval >= 0 )
@@ -212,16 +333,15 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
       self->state.mutation_buffer.emplace_back(std::move(x));
     },
     [=](set_command& x) {
-      self->state.store = std::move(x.state);
-      self->state.awaiting_snapshot = false;
-
-      if ( ! self->state.awaiting_snapshot_sync ) {
-        for ( auto& update : self->state.pending_remote_updates )
-          self->state.command(update);
-
-        self->state.pending_remote_updates.clear();
-        self->state.pending_remote_updates.shrink_to_fit();
+      self->state.install_snapshot(clone_map{x.state.begin(), x.state.end()});
+    },
+    [=](atom::update, std::vector<internal_command>& xs) {
+      if (!self->state.awaiting_snapshot) {
+        BROKER_WARNING("received unexpected delta from master");
+        return;
       }
+      BROKER_INFO("received" << xs.size() << "missed commands from master");
+      self->state.install_delta(xs);
     },
     [=](atom::sync_point, caf::actor& who) {
       self->send(who, atom::sync_point::value);
@@ -243,8 +363,19 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
         return;
 
       BROKER_INFO("resolved master");
+      // We only need the updates we missed when reconnecting to the same
+      // master, otherwise we ask for a full snapshot.
+      auto& st = self->state;
+      sequence_number since = 0;
+      if (st.last_seq > 0 && master.node() == st.master_node
+          && master.id() == st.master_id)
+        since = st.last_seq;
+      st.master_node = master.node();
+      st.master_id = master.id();
       self->state.master = std::move(master);
       self->state.is_stale = false;
+      self->state.view_dirty = true;
+      self->state.publish();
       self->state.stale_time = -1.0;
       self->state.unmutable_time = -1.0;
       self->monitor(self->state.master);
@@ -255,8 +386,7 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
       self->state.mutation_buffer.clear();
       self->state.mutation_buffer.shrink_to_fit();
 
-      self->send(self->state.core, atom::store::value, atom::master::value,
-                 atom::snapshot::value, self->state.name, self);
+      self->state.request_snapshot(since);
     },
     [=](atom::master, caf::error err) {
       if ( self->state.master )
@@ -275,6 +405,8 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
         return;
 
       self->state.is_stale = true;
+      self->state.view_dirty = true;
+      self->state.publish();
     },
     [=](atom::tick, atom::mutable_check) {
       if ( self->state.unmutable_time < 0 )
@@ -306,7 +438,7 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
       if ( self->state.is_stale )
         return {ec::stale_data};
 
-      auto result = (self->state.store.find(key) != self->state.store.end());
+      auto result = self->state.store.contains(key);
       BROKER_INFO("EXISTS" << key << "->" << result);
       return {result};
     },
@@ -314,7 +446,7 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
       if ( self->state.is_stale )
         return caf::make_message(make_error(ec::stale_data), id);
 
-      auto r = (self->state.store.find(key) != self->state.store.end());
+      auto r = self->state.store.contains(key);
       auto result = caf::make_message(data{r}, id);
       BROKER_INFO("EXISTS" << key << "with id" << id << "->" << r);
       return result;
@@ -324,9 +456,8 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
         return {ec::stale_data};
 
       expected<data> result = ec::no_such_key;
-      auto i = self->state.store.find(key);
-      if (i != self->state.store.end())
-        result = i->second;
+      if (auto x = self->state.store.find(key))
+        result = *x;
       BROKER_INFO("GET" << key << "->" << result);
       return result;
     },
@@ -335,9 +466,8 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
         return {ec::stale_data};
 
       expected<data> result = ec::no_such_key;
-      auto i = self->state.store.find(key);
-      if (i != self->state.store.end())
-        result = caf::visit(retriever{aspect}, i->second);
+      if (auto x = self->state.store.find(key))
+        result = caf::visit(retriever{aspect}, *x);
       BROKER_INFO("GET" << key << aspect << "->" << result);
       return result;
     },
@@ -346,10 +476,9 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
         return caf::make_message(make_error(ec::stale_data), id);
 
       caf::message result;
-      auto i = self->state.store.find(key);
-      if (i != self->state.store.end()) {
-        result = caf::make_message(i->second, id);
-        BROKER_INFO("GET" << key << "with id" << id << "->" << i->second);
+      if (auto x = self->state.store.find(key)) {
+        result = caf::make_message(*x, id);
+        BROKER_INFO("GET" << key << "with id" << id << "->" << *x);
       } else {
         result = caf::make_message(make_error(ec::no_such_key), id);
         BROKER_INFO("GET" << key << "with id" << id << "-> no_such_key");
@@ -361,9 +490,8 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
         return caf::make_message(make_error(ec::stale_data), id);
 
       caf::message result;
-      auto i = self->state.store.find(key);
-      if (i != self->state.store.end()) {
-        auto x = caf::visit(retriever{aspect}, i->second);
+      if (auto v = self->state.store.find(key)) {
+        auto x = caf::visit(retriever{aspect}, *v);
         BROKER_INFO("GET" << key << aspect << "with id" << id << "->" << x);
         if (x)
           result = caf::make_message(*x, id);
@@ -379,8 +507,13 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
     [=](atom::get, atom::name) {
       return self->state.name;
     },
-    // --- stream handshake with core ------------------------------------------
-    [=](const store::stream_type& in) {
+    // --- snapshot stream from the master -------------------------------------
+    [=](const caf::stream<snapshot_entry>& in) {
+      // Install the snapshot only after receiving all entries. Until then,
+      // queries still operate on the previous state. Note that this buffers
+      // the entire snapshot rather than installing it incrementally.
+      auto generation = ++self->state.snapshot_generation;
+      self->state.incoming_snapshot.clear();
       self->make_sink(
         // input stream
         in,
@@ -389,26 +522,37 @@ caf::behavior clone_actor(caf::stateful_actor<clone_state>* self,
           // nop
         },
         // processing step
-        [=](caf::unit_t&, store::stream_type::value_type y) {
-          // TODO: our operator() overloads require mutable references, but
-          //       only a fraction actually benefit from it.
-          auto cmd = move_command(y);
-          if (caf::holds_alternative<snapshot_sync_command>(cmd)) {
-            self->state.command(cmd);
-            return;
-          }
-
-          if ( self->state.awaiting_snapshot_sync )
+        [=](caf::unit_t&, snapshot_entry x) {
+          auto& st = self->state;
+          if (st.snapshot_generation == generation)
+            st.incoming_snapshot.emplace(std::move(x.first),
+                                         std::move(x.second));
+        },
+        // cleanup
+        [=](caf::unit_t&, const caf::error& err) {
+          auto& st = self->state;
+          if (st.snapshot_generation != generation)
             return;
-
-          if ( self->state.awaiting_snapshot ) {
-            self->state.pending_remote_updates.emplace_back(std::move(cmd));
+          if (err) {
+            BROKER_WARNING("snapshot stream aborted, request a new one:"
+                           << err);
+            st.restart_snapshot();
             return;
           }
-
-          self->state.command(cmd);
+          BROKER_INFO("received snapshot with" << st.incoming_snapshot.size()
+                                               << "entries");
+          st.install_snapshot(std::move(st.incoming_snapshot));
+          st.incoming_snapshot.clear();
         }
       );
+    },
+    // --- stream handshake with core ------------------------------------------
+    [=](const store::stream_type& in) {
+      auto& st = self->state;
+      if (st.sink == nullptr)
+        st.sink = caf::make_counted<clone_sink>(self, &st);
+      if (st.sink->add_unchecked_inbound_path(in) == caf::invalid_stream_slot)
+        BROKER_WARNING("failed to init stream to clone");
     }
   };
 }
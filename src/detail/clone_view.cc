@@ -0,0 +1,66 @@
+#include "broker/detail/clone_view.hh"
+
+#include <atomic>
+#include <utility>
+
+#include "broker/error.hh"
+
+#include "broker/detail/appliers.hh"
+
+namespace broker {
+namespace detail {
+
+clone_view::clone_view()
+  : current_(std::make_shared<version>(version{{}, true})) {
+  // nop
+}
+
+clone_view::version_ptr clone_view::load() const {
+  return std::atomic_load(&current_);
+}
+
+void clone_view::publish(clone_map store, bool is_stale) {
+  auto x = std::make_shared<version>(version{std::move(store), is_stale});
+  std::atomic_store(&current_, version_ptr{std::move(x)});
+}
+
+expected<data> clone_view::exists(const data& key) const {
+  auto v = load();
+  if (v->is_stale)
+    return {ec::stale_data};
+  return {data{v->store.contains(key)}};
+}
+
+expected<data> clone_view::get(const data& key) const {
+  auto v = load();
+  if (v->is_stale)
+    return {ec::stale_data};
+  auto x = v->store.find(key);
+  if (x == nullptr)
+    return {ec::no_such_key};
+  return {*x};
+}
+
+expected<data> clone_view::get(const data& key, const data& aspect) const {
+  auto v = load();
+  if (v->is_stale)
+    return {ec::stale_data};
+  auto x = v->store.find(key);
+  if (x == nullptr)
+    return {ec::no_such_key};
+  return caf::visit(retriever{aspect}, *x);
+}
+
+expected<data> clone_view::keys() const {
+  auto v = load();
+  if (v->is_stale)
+    return {ec::stale_data};
+  set result;
+  v->store.for_each([&](const data& key, const data&) {
+    result.emplace(key);
+  });
+  return {data{std::move(result)}};
+}
+
+} // namespace detail
+} // namespace broker
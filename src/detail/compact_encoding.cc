@@ -0,0 +1,662 @@
+#include "broker/detail/compact_encoding.hh"
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include <caf/detail/type_list.hpp>
+
+#include "broker/error.hh"
+
+namespace broker {
+namespace detail {
+namespace compact_encoding {
+
+namespace {
+
+// -- tags ---------------------------------------------------------------------
+
+enum tag : uint8_t {
+  none_tag = 0x00,
+  false_tag = 0x01,
+  true_tag = 0x02,
+  count_tag = 0x03,
+  integer_tag = 0x04,
+  real_tag = 0x05,
+  string_tag = 0x06,
+  v4_address_tag = 0x07,
+  v6_address_tag = 0x08,
+  v4_subnet_tag = 0x09,
+  v6_subnet_tag = 0x0A,
+  port_tag = 0x0B,
+  timestamp_tag = 0x0C,
+  timestamp_delta_tag = 0x0D,
+  timespan_tag = 0x0E,
+  enum_value_tag = 0x0F,
+  set_tag = 0x10,
+  table_tag = 0x11,
+  vector_tag = 0x12,
+  // Integers in the range [-16, 15].
+  small_integer_tag = 0x20,
+  // Counts in the range [0, 63].
+  small_count_tag = 0x40,
+  // Strings with up to 31 bytes.
+  short_string_tag = 0x80,
+};
+
+constexpr integer min_small_integer = -16;
+
+constexpr integer max_small_integer = 15;
+
+constexpr count max_small_count = 63;
+
+constexpr size_t max_short_string = 31;
+
+uint64_t zigzag(int64_t x) {
+  return (static_cast<uint64_t>(x) << 1) ^ static_cast<uint64_t>(x >> 63);
+}
+
+int64_t unzigzag(uint64_t x) {
+  return static_cast<int64_t>(x >> 1) ^ -static_cast<int64_t>(x & 1);
+}
+
+// Deltas between timestamps wrap around instead of overflowing, i.e., any two
+// timestamps have a delta.
+
+int64_t delta(timestamp x, timestamp base) {
+  auto lhs = static_cast<uint64_t>(x.time_since_epoch().count());
+  auto rhs = static_cast<uint64_t>(base.time_since_epoch().count());
+  return static_cast<int64_t>(lhs - rhs);
+}
+
+timestamp apply_delta(timestamp base, int64_t x) {
+  auto lhs = static_cast<uint64_t>(base.time_since_epoch().count());
+  auto result = static_cast<int64_t>(lhs + static_cast<uint64_t>(x));
+  return timestamp{timespan{result}};
+}
+
+// -- decoding -----------------------------------------------------------------
+
+class decoder {
+public:
+  decoder(const char* first, const char* last) : pos_(first), end_(last) {
+    // nop
+  }
+
+  const char* pos() const noexcept {
+    return pos_;
+  }
+
+  bool at_end() const noexcept {
+    return pos_ == end_;
+  }
+
+  bool read(data& x, const timestamp* base = nullptr) {
+    uint8_t tag = 0;
+    return get(tag) && read(tag, x, base);
+  }
+
+  bool skip() {
+    uint8_t tag = 0;
+    return get(tag) && skip(tag);
+  }
+
+  bool read_size(size_t& n) {
+    uint8_t tag = 0;
+    uint64_t val = 0;
+    if (!get(tag) || (tag != set_tag && tag != table_tag && tag != vector_tag)
+        || !get_size(val))
+      return false;
+    n = static_cast<size_t>(val);
+    return true;
+  }
+
+  bool read_string(size_t& n) {
+    uint8_t tag = 0;
+    if (!get(tag))
+      return false;
+    uint64_t val = 0;
+    if (tag >= short_string_tag)
+      val = tag - short_string_tag;
+    else if ((tag != string_tag && tag != enum_value_tag) || !get_varint(val))
+      return false;
+    if (val > max_short_string && tag >= short_string_tag)
+      return false;
+    if (val > remaining())
+      return false;
+    n = static_cast<size_t>(val);
+    return true;
+  }
+
+private:
+  bool read(uint8_t tag, data& x, const timestamp* base) {
+    if (tag >= short_string_tag) {
+      size_t n = tag - short_string_tag;
+      if (n > max_short_string)
+        return false;
+      return read_string(n, x);
+    }
+    if (tag >= small_count_tag) {
+      x = static_cast<count>(tag - small_count_tag);
+      return true;
+    }
+    if (tag >= small_integer_tag) {
+      x = static_cast<integer>(tag - small_integer_tag + min_small_integer);
+      return true;
+    }
+    switch (tag) {
+      default:
+        return false;
+      case none_tag:
+        x = nil;
+        return true;
+      case false_tag:
+        x = false;
+        return true;
+      case true_tag:
+        x = true;
+        return true;
+      case count_tag: {
+        uint64_t val = 0;
+        if (!get_varint(val))
+          return false;
+        x = count{val};
+        return true;
+      }
+      case integer_tag: {
+        uint64_t val = 0;
+        if (!get_varint(val))
+          return false;
+        x = integer{unzigzag(val)};
+        return true;
+      }
+      case real_tag: {
+        if (remaining() < 8)
+          return false;
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i)
+          bits |= static_cast<uint64_t>(static_cast<uint8_t>(*pos_++))
+                  << (i * 8);
+        real val;
+        memcpy(&val, &bits, sizeof(val));
+        x = val;
+        return true;
+      }
+      case string_tag: {
+        uint64_t n = 0;
+        return get_varint(n) && read_string(n, x);
+      }
+      case v4_address_tag:
+      case v6_address_tag: {
+        address addr;
+        if (!get_address(tag == v4_address_tag, addr))
+          return false;
+        x = std::move(addr);
+        return true;
+      }
+      case v4_subnet_tag:
+      case v6_subnet_tag: {
+        address addr;
+        uint8_t len = 0;
+        if (!get_address(tag == v4_subnet_tag, addr) || !get(len))
+          return false;
+        x = subnet{std::move(addr), len};
+        return true;
+      }
+      case port_tag: {
+        uint64_t num = 0;
+        uint8_t proto = 0;
+        if (!get_varint(num) || num > 0xFFFF || !get(proto))
+          return false;
+        x = port{static_cast<port::number_type>(num),
+                 static_cast<port::protocol>(proto)};
+        return true;
+      }
+      case timestamp_tag: {
+        uint64_t val = 0;
+        if (!get_varint(val))
+          return false;
+        x = timestamp{timespan{unzigzag(val)}};
+        return true;
+      }
+      case timestamp_delta_tag: {
+        uint64_t val = 0;
+        if (base == nullptr || !get_varint(val))
+          return false;
+        x = apply_delta(*base, unzigzag(val));
+        return true;
+      }
+      case timespan_tag: {
+        uint64_t val = 0;
+        if (!get_varint(val))
+          return false;
+        x = timespan{unzigzag(val)};
+        return true;
+      }
+      case enum_value_tag: {
+        uint64_t n = 0;
+        if (!get_varint(n) || n > remaining())
+          return false;
+        x = enum_value{std::string{pos_, static_cast<size_t>(n)}};
+        pos_ += n;
+        return true;
+      }
+      case set_tag: {
+        uint64_t n = 0;
+        if (!get_size(n))
+          return false;
+        std::vector<data> xs;
+        xs.resize(n);
+        for (auto& y : xs)
+          if (!read(y))
+            return false;
+        x = set{std::make_move_iterator(xs.begin()),
+                std::make_move_iterator(xs.end())};
+        return true;
+      }
+      case table_tag: {
+        uint64_t n = 0;
+        if (!get_size(n))
+          return false;
+        std::vector<std::pair<data, data>> xs;
+        xs.resize(n);
+        for (auto& kvp : xs)
+          if (!read(kvp.first) || !read(kvp.second))
+            return false;
+        x = table{std::make_move_iterator(xs.begin()),
+                  std::make_move_iterator(xs.end())};
+        return true;
+      }
+      case vector_tag: {
+        uint64_t n = 0;
+        if (!get_size(n))
+          return false;
+        vector xs;
+        xs.resize(n);
+        const timestamp* prev = nullptr;
+        for (auto& y : xs) {
+          if (!read(y, prev))
+            return false;
+          if (auto ts = get_if<timestamp>(y))
+            prev = ts;
+        }
+        x = std::move(xs);
+        return true;
+      }
+    }
+  }
+
+  bool skip(uint8_t tag) {
+    if (tag >= short_string_tag) {
+      size_t n = tag - short_string_tag;
+      return n <= max_short_string && advance(n);
+    }
+    if (tag >= small_integer_tag)
+      return true;
+    uint64_t n = 0;
+    switch (tag) {
+      default:
+        return false;
+      case none_tag:
+      case false_tag:
+      case true_tag:
+        return true;
+      case count_tag:
+      case integer_tag:
+      case timestamp_tag:
+      case timestamp_delta_tag:
+      case timespan_tag:
+        return get_varint(n);
+      case real_tag:
+        return advance(8);
+      case string_tag:
+      case enum_value_tag:
+        return get_varint(n) && advance(n);
+      case v4_address_tag:
+        return advance(4);
+      case v6_address_tag:
+        return advance(16);
+      case v4_subnet_tag:
+        return advance(5);
+      case v6_subnet_tag:
+        return advance(17);
+      case port_tag:
+        return get_varint(n) && advance(1);
+      case set_tag:
+      case vector_tag:
+        if (!get_size(n))
+          return false;
+        for (uint64_t i = 0; i < n; ++i)
+          if (!skip())
+            return false;
+        return true;
+      case table_tag:
+        if (!get_size(n))
+          return false;
+        for (uint64_t i = 0; i < n * 2; ++i)
+          if (!skip())
+            return false;
+        return true;
+    }
+  }
+
+  size_t remaining() const noexcept {
+    return static_cast<size_t>(end_ - pos_);
+  }
+
+  bool advance(uint64_t n) {
+    if (n > remaining())
+      return false;
+    pos_ += n;
+    return true;
+  }
+
+  bool get(uint8_t& x) {
+    if (pos_ == end_)
+      return false;
+    x = static_cast<uint8_t>(*pos_++);
+    return true;
+  }
+
+  bool get_varint(uint64_t& x) {
+    x = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte = 0;
+      if (!get(byte))
+        return false;
+      x |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+        return true;
+    }
+    return false;
+  }
+
+  /// Reads the size of a container. Each element occupies at least one byte,
+  /// i.e., we can reject sizes that exceed the remaining bytes before
+  /// allocating memory for the elements.
+  bool get_size(uint64_t& x) {
+    return get_varint(x) && x <= remaining();
+  }
+
+  bool get_address(bool v4, address& x) {
+    size_t n = v4 ? 4 : 16;
+    if (remaining() < n)
+      return false;
+    auto& bytes = x.bytes();
+    if (v4) {
+      static constexpr uint8_t v4_mapped_prefix[12] = {0, 0, 0, 0, 0,    0,
+                                                       0, 0, 0, 0, 0xFF, 0xFF};
+      memcpy(bytes.data(), v4_mapped_prefix, 12);
+      memcpy(bytes.data() + 12, pos_, 4);
+    } else {
+      memcpy(bytes.data(), pos_, 16);
+    }
+    pos_ += n;
+    return true;
+  }
+
+  bool read_string(size_t n, data& x) {
+    if (n > remaining())
+      return false;
+    x = std::string{pos_, n};
+    pos_ += n;
+    return true;
+  }
+
+  const char* pos_;
+  const char* end_;
+};
+
+template <class T>
+constexpr uint8_t index_of() {
+  return static_cast<uint8_t>(caf::detail::tl_index_of<data::types, T>::value);
+}
+
+} // namespace
+
+// -- writer -------------------------------------------------------------------
+
+void writer::operator()(none) {
+  put(none_tag);
+}
+
+void writer::operator()(boolean x) {
+  put(x ? true_tag : false_tag);
+}
+
+void writer::operator()(count x) {
+  if (x <= max_small_count) {
+    put(small_count_tag + static_cast<uint8_t>(x));
+    return;
+  }
+  put(count_tag);
+  put_varint(x);
+}
+
+void writer::operator()(integer x) {
+  if (x >= min_small_integer && x <= max_small_integer) {
+    put(small_integer_tag + static_cast<uint8_t>(x - min_small_integer));
+    return;
+  }
+  put(integer_tag);
+  put_varint(zigzag(x));
+}
+
+void writer::operator()(real x) {
+  uint64_t bits;
+  static_assert(sizeof(bits) == sizeof(x));
+  memcpy(&bits, &x, sizeof(x));
+  put(real_tag);
+  for (int i = 0; i < 8; ++i)
+    put(static_cast<uint8_t>(bits >> (i * 8)));
+}
+
+void writer::operator()(const std::string& x) {
+  if (x.size() <= max_short_string)
+    put(short_string_tag + static_cast<uint8_t>(x.size()));
+  else {
+    put(string_tag);
+    put_varint(x.size());
+  }
+  buf_.insert(buf_.end(), x.begin(), x.end());
+}
+
+void writer::operator()(const address& x) {
+  put(x.is_v4() ? v4_address_tag : v6_address_tag);
+  put_address(x);
+}
+
+void writer::operator()(const subnet& x) {
+  put(x.network().is_v4() ? v4_subnet_tag : v6_subnet_tag);
+  put_address(x.network());
+  put(x.length());
+}
+
+void writer::operator()(port x) {
+  put(port_tag);
+  put_varint(x.number());
+  put(static_cast<uint8_t>(x.type()));
+}
+
+void writer::operator()(timestamp x) {
+  put(timestamp_tag);
+  put_varint(zigzag(x.time_since_epoch().count()));
+}
+
+void writer::operator()(timespan x) {
+  put(timespan_tag);
+  put_varint(zigzag(x.count()));
+}
+
+void writer::operator()(const enum_value& x) {
+  put(enum_value_tag);
+  put_varint(x.name.size());
+  buf_.insert(buf_.end(), x.name.begin(), x.name.end());
+}
+
+void writer::operator()(const set& xs) {
+  put(set_tag);
+  put_varint(xs.size());
+  for (auto& x : xs)
+    (*this)(x);
+}
+
+void writer::operator()(const table& xs) {
+  put(table_tag);
+  put_varint(xs.size());
+  for (auto& kvp : xs) {
+    (*this)(kvp.first);
+    (*this)(kvp.second);
+  }
+}
+
+void writer::operator()(const vector& xs) {
+  begin_vector(xs.size());
+  const timestamp* prev = nullptr;
+  for (auto& x : xs) {
+    if (auto ts = get_if<timestamp>(x)) {
+      (*this)(*ts, prev);
+      prev = ts;
+    } else {
+      (*this)(x);
+    }
+  }
+}
+
+void writer::operator()(const data& x) {
+  caf::visit(*this, x);
+}
+
+void writer::operator()(timestamp x, const timestamp* prev) {
+  if (prev == nullptr) {
+    (*this)(x);
+    return;
+  }
+  put(timestamp_delta_tag);
+  put_varint(zigzag(delta(x, *prev)));
+}
+
+void writer::begin_vector(size_t n) {
+  put(vector_tag);
+  put_varint(n);
+}
+
+void writer::put(uint8_t x) {
+  buf_.push_back(static_cast<char>(x));
+}
+
+void writer::put_varint(uint64_t x) {
+  while (x > 0x7F) {
+    put(static_cast<uint8_t>(x | 0x80));
+    x >>= 7;
+  }
+  put(static_cast<uint8_t>(x));
+}
+
+void writer::put_address(const address& x) {
+  auto& bytes = x.bytes();
+  auto first = reinterpret_cast<const char*>(bytes.data());
+  if (x.is_v4())
+    first += 12;
+  buf_.insert(buf_.end(), first,
+              reinterpret_cast<const char*>(bytes.data()) + bytes.size());
+}
+
+void encode(const data& x, std::vector<char>& buf) {
+  buf.push_back(static_cast<char>(version));
+  write(x, buf);
+}
+
+caf::error decode(const char* buf, size_t size, data& x) {
+  if (!is_compact(buf, size))
+    return make_error(ec::invalid_data, "unknown encoding version");
+  decoder f{buf + 1, buf + size};
+  if (!f.read(x) || !f.at_end())
+    return make_error(ec::invalid_data, "malformed compact encoding");
+  return caf::none;
+}
+
+// -- access to individual values ----------------------------------------------
+
+void write(const data& x, std::vector<char>& buf) {
+  writer f{buf};
+  f(x);
+}
+
+uint8_t type_index(uint8_t tag) noexcept {
+  if (tag >= short_string_tag)
+    return static_cast<size_t>(tag - short_string_tag) <= max_short_string
+             ? index_of<std::string>()
+             : 0xFF;
+  if (tag >= small_count_tag)
+    return index_of<count>();
+  if (tag >= small_integer_tag)
+    return index_of<integer>();
+  switch (tag) {
+    default:
+      return 0xFF;
+    case none_tag:
+      return index_of<none>();
+    case false_tag:
+    case true_tag:
+      return index_of<boolean>();
+    case count_tag:
+      return index_of<count>();
+    case integer_tag:
+      return index_of<integer>();
+    case real_tag:
+      return index_of<real>();
+    case string_tag:
+      return index_of<std::string>();
+    case v4_address_tag:
+    case v6_address_tag:
+      return index_of<address>();
+    case v4_subnet_tag:
+    case v6_subnet_tag:
+      return index_of<subnet>();
+    case port_tag:
+      return index_of<port>();
+    case timestamp_tag:
+    case timestamp_delta_tag:
+      return index_of<timestamp>();
+    case timespan_tag:
+      return index_of<timespan>();
+    case enum_value_tag:
+      return index_of<enum_value>();
+    case set_tag:
+      return index_of<set>();
+    case table_tag:
+      return index_of<table>();
+    case vector_tag:
+      return index_of<vector>();
+  }
+}
+
+bool is_relative(uint8_t tag) noexcept {
+  return tag == timestamp_delta_tag;
+}
+
+const char* read(const char* first, const char* last, data& x,
+                 const timestamp* base) {
+  decoder f{first, last};
+  return f.read(x, base) ? f.pos() : nullptr;
+}
+
+const char* skip(const char* first, const char* last) {
+  decoder f{first, last};
+  return f.skip() ? f.pos() : nullptr;
+}
+
+const char* read_size(const char* first, const char* last, size_t& n) {
+  decoder f{first, last};
+  return f.read_size(n) ? f.pos() : nullptr;
+}
+
+const char* read_string(const char* first, const char* last, size_t& n) {
+  decoder f{first, last};
+  return f.read_string(n) ? f.pos() : nullptr;
+}
+
+} // namespace compact_encoding
+} // namespace detail
+} // namespace broker
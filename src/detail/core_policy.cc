@@ -69,10 +69,12 @@ void core_policy::unblock_peer(caf::actor peer) {
   if ( it == blocked_msgs.end() )
     return;
 
+  auto buf = std::move(it->second);
+  blocked_msgs.erase(it);
+
   auto pit = peer_to_ipath_.find(peer);
 
   if ( pit == peer_to_ipath_.end() ) {
-    blocked_msgs.erase(it);
     BROKER_DEBUG("dropped batches after unblocking peer: path no longer exists" << peer);
     return;
   }
@@ -80,20 +82,20 @@ void core_policy::unblock_peer(caf::actor peer) {
   auto& slot = pit->second;
   auto sap = actor_cast<strong_actor_ptr>(peer);
 
-  for ( auto& batch : it->second ) {
+  BROKER_INFO("replay buffered messages from peer" << peer
+              << BROKER_ARG2("size", buf->size())
+              << BROKER_ARG2("dropped", buf->dropped()));
+  auto err = buf->drain(self()->context(), [&](peer_buffer::batch& xs) {
     BROKER_DEBUG("handle blocked batch" << peer);
+    auto batch = make_message(std::move(xs));
     before_handle_batch(slot, sap);
     handle_batch(slot, sap, batch);
     after_handle_batch(slot, sap);
-  }
-
-  blocked_msgs.erase(it);
-}
-
-static bool ends_with(const std::string& s, const std::string& ending) {
-  if (ending.size() > s.size())
-    return false;
-  return std::equal(ending.rbegin(), ending.rend(), s.rbegin());
+  });
+  if (err)
+    BROKER_ERROR("failed to replay spilled batches from peer" << peer << err);
+  state_->emit_status<sc::peer_buffer_drained>(peer,
+                                               "replayed buffered messages");
 }
 
 void core_policy::handle_batch(stream_slot, const strong_actor_ptr& peer,
@@ -107,8 +109,28 @@ void core_policy::handle_batch(stream_slot, const strong_actor_ptr& peer,
 
     if ( it != blocked_peers.end() ) {
       BROKER_DEBUG("buffer batch from blocked peer" << peer);
-      auto& bmsgs = blocked_msgs[peer_actor];
-      bmsgs.emplace_back(std::move(xs));
+      auto& buf = blocked_msgs[peer_actor];
+      if (buf == nullptr) {
+        peer_buffer::limits cfg;
+        cfg.memory = state_->options.peer_buffer_memory_limit;
+        cfg.spill_directory = state_->options.peer_buffer_spill_directory;
+        cfg.spill = state_->options.peer_buffer_spill_limit;
+        buf = std::make_unique<peer_buffer>(std::move(cfg));
+        state_->emit_status<sc::peer_buffering>(peer_actor,
+                                                "buffering blocked peer");
+      }
+      using push_result = peer_buffer::push_result;
+      auto before = buf->worst_result();
+      auto& batch = xs.get_mutable_as<peer_trait::batch>(0);
+      auto after = buf->push(self()->context(), batch);
+      if (after > before) {
+        if (after == push_result::spilled)
+          state_->emit_status<sc::peer_buffer_overflow>(
+            peer_actor, "spilling messages from blocked peer to disk");
+        else if (after == push_result::dropped)
+          state_->emit_status<sc::peer_buffer_overflow>(
+            peer_actor, "dropping messages from blocked peer");
+      }
       return;
     }
 
@@ -119,24 +141,31 @@ void core_policy::handle_batch(stream_slot, const strong_actor_ptr& peer,
     // Only received from other peers. Extract content for to local workers
     // or stores and then forward to other peers.
     for (auto& msg : xs.get_mutable_as<peer_trait::batch>(0)) {
-      const topic* t;
-      // Dispatch to local workers or stores messages.
-      if (is_data_message(msg)) {
-        auto& dm = get<data_message>(msg.content);
-        t = &get_topic(dm);
-        if (num_workers > 0)
-          workers().push(dm);
-      } else {
-        auto& cm = get<command_message>(msg.content);
-        t = &get_topic(cm);
-        if (num_stores > 0)
-          stores().push(cm);
+      // Dispatch to local workers or stores messages. Messages from peers
+      // arrive packed and we only decode them for local subscribers.
+      bool deliver_locally;
+      if (is_data_message(msg))
+        deliver_locally = num_workers > 0
+                          && workers().has_subscribers(get_topic(msg));
+      else
+        deliver_locally = num_stores > 0
+                          && stores().has_subscribers(get_topic(msg));
+      if (deliver_locally) {
+        if (auto err = unpack(self()->context(), msg)) {
+          BROKER_ERROR("dropped a message with invalid payload:" << err);
+          continue;
+        }
+        if (is_data_message(msg))
+          workers().push(get<data_message>(msg.content));
+        else
+          stores().push(get<command_message>(msg.content));
       }
+      auto t = &get_topic(msg);
       // Check if forwarding is on.
       if (!state_->options.forward)
         continue;
       // Somewhat hacky, but don't forward data store clone messages.
-      if (ends_with(t->string(), topics::clone_suffix.string()))
+      if (is_clone(t->flags()))
         continue;
       // Either decrease TTL if message has one already, or add one.
       if (--msg.ttl == 0) {
@@ -354,7 +383,10 @@ bool core_policy::update_peer(const actor& hdl, filter_type filter) {
     BROKER_DEBUG("cannot update filter on unknown peer");
     return false;
   }
-  peers().filter(i->second).second = std::move(filter);
+  // Go through set_filter for updating the filter index.
+  auto addr = peers().filter(i->second).first;
+  peers().set_filter(i->second, std::make_pair(std::move(addr),
+                                               std::move(filter)));
   return true;
 }
 
@@ -418,6 +450,19 @@ void core_policy::push(data_message msg) {
   //local_push(std::move(x), std::move(y));
 }
 
+/// Pushes a batch of data to peers.
+void core_policy::push(std::vector<data_message> msgs) {
+  BROKER_TRACE(BROKER_ARG2("num_msgs", msgs.size()));
+  auto ttl = state_->options.ttl;
+  for (auto& msg : msgs) {
+    auto x = make_node_message(std::move(msg), ttl);
+    if (recorder_ != nullptr)
+      try_record(x);
+    peers().push(std::move(x));
+  }
+  peers().emit_batches();
+}
+
 /// Pushes data to peers and stores.
 void core_policy::push(command_message msg) {
   BROKER_TRACE(BROKER_ARG(msg));
@@ -425,6 +470,33 @@ void core_policy::push(command_message msg) {
   //local_push(std::move(x), std::move(y));
 }
 
+/// Pushes a batch of commands to peers.
+void core_policy::push(std::vector<command_message> msgs) {
+  BROKER_TRACE(BROKER_ARG2("num_msgs", msgs.size()));
+  auto ttl = state_->options.ttl;
+  for (auto& msg : msgs) {
+    auto x = make_node_message(std::move(msg), ttl);
+    if (recorder_ != nullptr)
+      try_record(x);
+    peers().push(std::move(x));
+  }
+  peers().emit_batches();
+}
+
+/// Pushes a pre-encoded message to peers.
+void core_policy::push(node_message msg) {
+  BROKER_TRACE(BROKER_ARG(msg));
+  msg.ttl = state_->options.ttl;
+  // The recorder writes the content of messages, i.e., needs the value.
+  if (recorder_ != nullptr) {
+    if (auto err = unpack(self()->context(), msg)) {
+      BROKER_ERROR("dropped a message with invalid payload:" << err);
+      return;
+    }
+  }
+  remote_push(std::move(msg));
+}
+
 auto core_policy::out() noexcept -> downstream_manager_type& {
   return parent_->out();
 }
@@ -480,6 +552,65 @@ std::vector<caf::actor> core_policy::get_peer_handles() {
   return peers;
 }
 
+std::vector<lane_depths> core_policy::get_lane_depths() {
+  std::vector<lane_depths> result;
+  auto& states = peers().states();
+  for (auto& kvp : opath_to_peer_) {
+    auto i = states.find(kvp.first);
+    if (i == states.end())
+      continue;
+    lane_depths tmp;
+    tmp.peer.node = kvp.second.node();
+    if (auto addrs = state_->cache.find(kvp.second))
+      tmp.peer.network = *addrs;
+    // Without priority lanes, store commands share the bulk buffer.
+    tmp.control = peers().control_buffered(kvp.first);
+    tmp.bulk = i->second.buf.size();
+    result.emplace_back(std::move(tmp));
+  }
+  return result;
+}
+
+std::vector<batching_info> core_policy::get_batching_info() {
+  std::vector<batching_info> result;
+  auto& mgr = peers();
+  for (auto& kvp : opath_to_peer_) {
+    auto path = mgr.path(kvp.first);
+    if (path == nullptr)
+      continue;
+    batching_info tmp;
+    tmp.peer.node = kvp.second.node();
+    if (auto addrs = state_->cache.find(kvp.second))
+      tmp.peer.network = *addrs;
+    tmp.batch_size = static_cast<size_t>(path->desired_batch_size);
+    tmp.open_credit = static_cast<size_t>(path->open_credit);
+    if (auto ctl = mgr.controller(kvp.first)) {
+      tmp.rate = ctl->rate();
+      tmp.rtt = ctl->rtt();
+      tmp.credit_target = ctl->credit_target(mgr.batching());
+    }
+    result.emplace_back(std::move(tmp));
+  }
+  return result;
+}
+
+std::vector<peer_buffer_info> core_policy::get_peer_buffers() {
+  std::vector<peer_buffer_info> result;
+  for (auto& kvp : blocked_msgs) {
+    auto& buf = *kvp.second;
+    peer_buffer_info tmp;
+    tmp.peer.node = kvp.first.node();
+    if (auto addrs = state_->cache.find(kvp.first))
+      tmp.peer.network = *addrs;
+    tmp.size = buf.size();
+    tmp.memory_usage = buf.memory_usage();
+    tmp.spill_usage = buf.spill_usage();
+    tmp.dropped = buf.dropped();
+    result.emplace_back(std::move(tmp));
+  }
+  return result;
+}
+
 core_policy::ttl core_policy::initial_ttl() const {
   return static_cast<ttl>(state_->options.ttl);
 }
@@ -0,0 +1,71 @@
+#include "broker/detail/expiry_queue.hh"
+
+#include <algorithm>
+
+namespace broker {
+namespace detail {
+
+void expiry_queue::schedule(const data& key, timestamp deadline) {
+  auto i = keys_.find(key);
+  if (i == keys_.end()) {
+    keys_.emplace(key, entry{deadline, deadline});
+    push(deadline, key);
+    return;
+  }
+  i->second.deadline = deadline;
+  // A later deadline takes effect once the current heap entry comes up. Only
+  // an earlier deadline requires a new heap entry.
+  if (deadline < i->second.scheduled) {
+    i->second.scheduled = deadline;
+    push(deadline, key);
+    compact();
+  }
+}
+
+void expiry_queue::cancel(const data& key) {
+  if (keys_.erase(key) > 0)
+    compact();
+}
+
+void expiry_queue::clear() {
+  keys_.clear();
+  heap_.clear();
+}
+
+void expiry_queue::drain(timestamp now, std::vector<data>& xs) {
+  while (!heap_.empty() && heap_.front().first <= now) {
+    std::pop_heap(heap_.begin(), heap_.end(), heap_order{});
+    auto x = std::move(heap_.back());
+    heap_.pop_back();
+    auto i = keys_.find(x.second);
+    if (i == keys_.end() || i->second.scheduled != x.first)
+      continue; // Outdated entry.
+    if (i->second.deadline <= now) {
+      keys_.erase(i);
+      xs.emplace_back(std::move(x.second));
+    } else {
+      i->second.scheduled = i->second.deadline;
+      push(i->second.deadline, std::move(x.second));
+    }
+  }
+}
+
+void expiry_queue::push(timestamp t, data key) {
+  heap_.emplace_back(t, std::move(key));
+  std::push_heap(heap_.begin(), heap_.end(), heap_order{});
+}
+
+void expiry_queue::compact() {
+  if (heap_.size() < 64 || heap_.size() <= 2 * keys_.size())
+    return;
+  heap_.clear();
+  heap_.reserve(keys_.size());
+  for (auto& kvp : keys_) {
+    kvp.second.scheduled = kvp.second.deadline;
+    heap_.emplace_back(kvp.second.deadline, kvp.first);
+  }
+  std::make_heap(heap_.begin(), heap_.end(), heap_order{});
+}
+
+} // namespace detail
+} // namespace broker
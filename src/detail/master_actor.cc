@@ -1,11 +1,18 @@
 #include "broker/logger.hh" // Needs to come before CAF includes.
 
+#include <vector>
+
 #include <caf/event_based_actor.hpp>
 #include <caf/actor.hpp>
 #include <caf/make_message.hpp>
 #include <caf/sum_type.hpp>
 #include <caf/behavior.hpp>
+#include <caf/downstream.hpp>
+#include <caf/downstream_msg.hpp>
+#include <caf/inbound_path.hpp>
 #include <caf/stateful_actor.hpp>
+#include <caf/stream_sink.hpp>
+#include <caf/stream_slot.hpp>
 #include <caf/system_messages.hpp>
 #include <caf/unit.hpp>
 #include <caf/error.hpp>
@@ -13,6 +20,9 @@
 #include "broker/atoms.hh"
 #include "broker/convert.hh"
 #include "broker/data.hh"
+#include "broker/defaults.hh"
+#include "broker/error.hh"
+#include "broker/snapshot.hh"
 #include "broker/store.hh"
 #include "broker/time.hh"
 #include "broker/topic.hh"
@@ -29,6 +39,49 @@ static inline optional<timestamp> to_opt_timestamp(timestamp ts,
   return span ? ts + *span : optional<timestamp>();
 }
 
+// Returns the value of a command for passing it to the backend. Moves the
+// value unless the master still needs the command for its clones or for its
+// replication log. The log stays empty until the first clone attaches.
+static inline data take_value(const master_state& st, data& x) {
+  if (st.clones.empty() && st.log.max_size() == 0)
+    return std::move(x);
+  return x;
+}
+
+namespace {
+
+struct snapshot_stream_state {
+  backend_cursor_ptr cursor;
+  std::vector<snapshot_entry> buf;
+  bool at_end = false;
+};
+
+/// Applies each batch of commands from the core in a single backend batch.
+class master_sink : public caf::stream_sink<command_message> {
+public:
+  using super = caf::stream_sink<command_message>;
+
+  master_sink(caf::scheduled_actor* self, master_state* state)
+    : caf::stream_manager(self), super(self), state_(state) {
+    // nop
+  }
+
+protected:
+  void handle(caf::inbound_path*, caf::downstream_msg::batch& x) override {
+    using vec_type = std::vector<command_message>;
+    if (x.xs.match_elements<vec_type>()) {
+      state_->command(x.xs.get_mutable_as<vec_type>(0));
+      return;
+    }
+    BROKER_ERROR("received unexpected batch type (dropped)");
+  }
+
+private:
+  master_state* state_;
+};
+
+} // namespace
+
 const char* master_state::name = "master_actor";
 
 master_state::master_state() : self(nullptr), clock(nullptr) {
@@ -37,46 +90,89 @@ master_state::master_state() : self(nullptr), clock(nullptr) {
 
 void master_state::init(caf::event_based_actor* ptr, std::string&& nm,
                         backend_pointer&& bp, caf::actor&& parent,
-                        endpoint::clock* ep_clock) {
+                        size_t max_log_size, endpoint::clock* ep_clock) {
   BROKER_ASSERT(ep_clock != nullptr);
   self = ptr;
   id = std::move(nm);
   clones_topic = id / topics::clone_suffix;
   backend = std::move(bp);
   core = std::move(parent);
+  log_size = max_log_size;
   clock = ep_clock;
   auto es = backend->expiries();
   if (!es)
     die("failed to get master expiries while initializing");
-  for (auto& e : *es) {
-    auto& key = e.first;
-    auto& expire_time = e.second;
-    auto n = clock->now();
-    auto dur = expire_time - n;
-    auto msg = caf::make_message(atom::expire::value, std::move(key));
-    clock->send_later(self, dur, std::move(msg));
-  }
+  for (auto& e : *es)
+    expirations.schedule(e.first, e.second);
+  schedule_tick();
 }
 
 void master_state::broadcast(internal_command&& x) {
-  self->send(core, atom::publish::value,
-             make_command_message(clones_topic, std::move(x)));
+  if (in_batch) {
+    batch_commands.emplace_back(std::move(x));
+    return;
+  }
+  log.append(x);
+  if (!clones.empty())
+    self->send(core, atom::publish::value,
+               make_command_message(clones_topic, std::move(x)));
+}
+
+void master_state::broadcast(std::vector<internal_command>&& xs) {
+  for (auto& x : xs)
+    log.append(x);
+  if (clones.empty() || xs.empty())
+    return;
+  std::vector<command_message> msgs;
+  msgs.reserve(xs.size());
+  for (auto& x : xs)
+    msgs.emplace_back(make_command_message(clones_topic, std::move(x)));
+  self->send(core, atom::publish::value, std::move(msgs));
 }
 
 void master_state::remind(timespan expiry, const data& key) {
-  auto msg = caf::make_message(atom::expire::value, key);
-  clock->send_later(self, expiry, std::move(msg));
+  expirations.schedule(key, clock->now() + expiry);
+  schedule_tick();
+}
+
+void master_state::schedule_tick() {
+  if (tick_scheduled || expirations.empty())
+    return;
+  tick_scheduled = true;
+  auto msg = caf::make_message(atom::tick::value, atom::expire::value);
+  clock->send_later(self, defaults::expiry_tick_interval, std::move(msg));
+}
+
+void master_state::tick() {
+  tick_scheduled = false;
+  std::vector<data> keys;
+  expirations.drain(clock->now(), keys);
+  if (!keys.empty())
+    expire(keys);
+  schedule_tick();
 }
 
-void master_state::expire(data& key) {
-  BROKER_INFO("EXPIRE" << key);
-  auto result = backend->expire(key, clock->now());
-  if (!result)
-    BROKER_ERROR("failed to expire key:" << to_string(result.error()));
-  else if (!*result)
-    BROKER_WARNING("ignoring stale expiration reminder");
-  else {
-    broadcast_cmd_to_clones(erase_command{std::move(key)});
+void master_state::expire(std::vector<data>& keys) {
+  BROKER_INFO("EXPIRE" << keys.size() << "keys");
+  auto now = clock->now();
+  std::vector<data> expired;
+  begin_batch();
+  for (auto& key : keys) {
+    auto result = backend->expire(key, now);
+    if (!result) {
+      BROKER_ERROR("failed to expire key:" << to_string(result.error()));
+    } else if (!*result) {
+      BROKER_WARNING("ignoring stale expiration of" << key);
+    } else {
+      broadcast_cmd_to_clones(erase_command{key});
+      expired.emplace_back(std::move(key));
+    }
+  }
+  // Try again on the next tick if the backend still has the keys.
+  if (!commit_batch()) {
+    for (auto& key : expired)
+      expirations.schedule(key, now);
+    schedule_tick();
   }
 }
 
@@ -88,6 +184,59 @@ void master_state::command(internal_command::variant_type& cmd) {
   caf::visit(*this, cmd);
 }
 
+void master_state::command(std::vector<command_message>& xs) {
+  begin_batch();
+  for (auto& x : xs) {
+    // TODO: our operator() overloads require mutable references, but
+    //       only a fraction actually benefit from it.
+    auto cmd = move_command(x);
+    if (caf::holds_alternative<snapshot_command>(cmd)) {
+      // Snapshots must include all previous commands of this batch.
+      commit_batch();
+      command(cmd);
+      begin_batch();
+    } else {
+      command(cmd);
+    }
+  }
+  commit_batch();
+}
+
+void master_state::begin_batch() {
+  BROKER_ASSERT(!in_batch);
+  auto res = backend->begin_batch();
+  if (!res) {
+    BROKER_ERROR("failed to begin batch on master:" << res.error());
+    return;
+  }
+  in_batch = true;
+}
+
+bool master_state::commit_batch() {
+  if (!in_batch)
+    return true;
+  in_batch = false;
+  auto cmds = std::move(batch_commands);
+  batch_commands.clear();
+  auto inserts = std::move(batch_inserts);
+  batch_inserts.clear();
+  auto res = backend->commit_batch();
+  if (!res) {
+    // The backend discarded the batch. Since neither the clones nor the
+    // replication log saw its commands, they remain consistent with us.
+    BROKER_ERROR("failed to commit batch on master, dropped"
+                 << cmds.size() << "modifications:" << res.error());
+    for (auto& x : inserts)
+      self->send(x.first, caf::make_message(make_error(ec::backend_failure),
+                                            x.second));
+    return false;
+  }
+  for (auto& x : inserts)
+    self->send(x.first, caf::make_message(data{true}, x.second));
+  broadcast(std::move(cmds));
+  return true;
+}
+
 void master_state::operator()(none) {
   BROKER_INFO("received empty command");
 }
@@ -95,13 +244,15 @@ void master_state::operator()(none) {
 void master_state::operator()(put_command& x) {
   BROKER_INFO("PUT" << x.key << "->" << x.value << "with expiry" << (x.expiry ? to_string(*x.expiry) : "none"));
   auto et = to_opt_timestamp(clock->now(), x.expiry);
-  auto result = backend->put(x.key, x.value, et);
+  auto result = backend->put(x.key, take_value(*this, x.value), et);
   if (!result) {
     BROKER_WARNING("failed to put" << x.key << "->" << x.value);
     return; // TODO: propagate failure? to all clones? as status msg?
   }
   if (x.expiry)
     remind(*x.expiry, x.key);
+  else
+    expirations.cancel(x.key);
   broadcast_cmd_to_clones(std::move(x));
 }
 
@@ -122,15 +273,20 @@ void master_state::operator()(put_unique_command& x) {
     return;
   }
 
-  self->send(x.who, caf::make_message(data{true}, x.req_id));
   auto et = to_opt_timestamp(clock->now(), x.expiry);
-  auto result = backend->put(x.key, x.value, et);
+  auto result = backend->put(x.key, take_value(*this, x.value), et);
 
   if (!result) {
     BROKER_WARNING("failed to put_unique" << x.key << "->" << x.value);
-    return; // TODO: propagate failure? to all clones? as status msg?
+    self->send(x.who, caf::make_message(std::move(result.error()), x.req_id));
+    return;
   }
 
+  if (in_batch)
+    batch_inserts.emplace_back(x.who, x.req_id);
+  else
+    self->send(x.who, caf::make_message(data{true}, x.req_id));
+
   if (x.expiry)
     remind(*x.expiry, x.key);
 
@@ -146,13 +302,15 @@ void master_state::operator()(erase_command& x) {
     BROKER_WARNING("failed to erase" << x.key);
     return; // TODO: propagate failure? to all clones? as status msg?
   }
+  expirations.cancel(x.key);
   broadcast_cmd_to_clones(std::move(x));
 }
 
 void master_state::operator()(add_command& x) {
   BROKER_INFO("ADD" << x);
   auto et = to_opt_timestamp(clock->now(), x.expiry);
-  auto result = backend->add(x.key, x.value, x.init_type, et);
+  auto result = backend->add(x.key, take_value(*this, x.value), x.init_type,
+                             et);
   if (!result) {
     BROKER_WARNING("failed to add" << x.value << "to" << x.key);
     return; // TODO: propagate failure? to all clones? as status msg?
@@ -181,11 +339,28 @@ void master_state::operator()(snapshot_command& x) {
     BROKER_INFO("snapshot command with invalid address received");
     return;
   }
-  auto ss = backend->snapshot();
-  if (!ss)
+  if (x.since > 0 && log.covers(x.since)) {
+    // The clone only missed a few updates, e.g., after a brief disconnect.
+    // Hence, we send only the commands since its last update. The clone
+    // applies them in place of a snapshot and uses the sync point below in
+    // the same way.
+    auto delta = log.since(x.since);
+    BROKER_INFO("send" << delta.size() << "missed commands to clone");
+    log.max_size(log_size);
+    self->monitor(x.remote_core);
+    clones.emplace(x.remote_core->address(), x.remote_clone);
+    broadcast_cmd_to_clones(snapshot_sync_command{x.remote_clone});
+    self->send(x.remote_clone, atom::update::value, std::move(delta));
+    return;
+  }
+  auto cursor = backend->cursor();
+  if (!cursor)
     die("failed to snapshot master");
   self->monitor(x.remote_core);
   clones.emplace(x.remote_core->address(), x.remote_clone);
+  // Once a clone attached, it may come back after losing its connection.
+  // Hence, the log keeps commands from now on, starting with the sync point.
+  log.max_size(log_size);
 
   // The snapshot gets sent over a different channel than updates,
   // so we send a "sync" point over the update channel that target clone
@@ -193,19 +368,32 @@ void master_state::operator()(snapshot_command& x) {
   // received the now-outdated snapshot.
   broadcast_cmd_to_clones(snapshot_sync_command{x.remote_clone});
 
-  // TODO: possible improvements to do here
-  // (1) Use a separate *streaming* channel to send the snapshot.
-  //     A benefit of that would potentially be less latent queries
-  //     that go directly against the master store.
-  // (2) Always keep an updated snapshot in memory on the master to
-  //     avoid numerous expensive retrievals from persistent backends
-  //     in quick succession (e.g. at startup).
-  // (3) As an alternative to (2), give backends an API to stream
-  //     key-value pairs without ever needing the full snapshot in
-  //     memory.  Note that this would require halting the application
-  //     of updates on the master while there are any snapshot streams
-  //     still underway.
-  self->send(x.remote_clone, set_command{std::move(*ss)});
+  // We stream the snapshot to the clone, reading only as many entries from
+  // the backend as the clone has credit for. The cursor reads the state of
+  // the backend at the sync point above, while we keep applying commands.
+  self->make_source(
+    x.remote_clone,
+    [&](snapshot_stream_state& st) {
+      st.cursor = std::move(*cursor);
+    },
+    [](snapshot_stream_state& st, caf::downstream<snapshot_entry>& out,
+       size_t num) {
+      st.buf.clear();
+      auto more = st.cursor->next(num, st.buf);
+      if (!more)
+        die("failed to snapshot master");
+      for (auto& x : st.buf)
+        out.push(std::move(x));
+      st.at_end = !*more;
+    },
+    [](const snapshot_stream_state& st) {
+      return st.at_end;
+    },
+    [](snapshot_stream_state&, const caf::error& err) {
+      if (err)
+        BROKER_WARNING("snapshot stream aborted:" << err);
+    }
+  );
 }
 
 void master_state::operator()(snapshot_sync_command&) {
@@ -221,16 +409,17 @@ void master_state::operator()(clear_command& x) {
   auto res = backend->clear();
   if (!res)
     die("failed to clear master");
+  expirations.clear();
   broadcast_cmd_to_clones(std::move(x));
 }
 
 caf::behavior master_actor(caf::stateful_actor<master_state>* self,
                            caf::actor core, std::string id,
                            master_state::backend_pointer backend,
-                           endpoint::clock* clock) {
+                           size_t log_size, endpoint::clock* clock) {
   self->monitor(core);
   self->state.init(self, std::move(id), std::move(backend),
-                   std::move(core), clock);
+                   std::move(core), log_size, clock);
   self->set_down_handler(
     [=](const caf::down_msg& msg) {
       if (msg.source == core) {
@@ -251,8 +440,8 @@ caf::behavior master_actor(caf::stateful_actor<master_state>* self,
     [=](atom::sync_point, caf::actor& who) {
       self->send(who, atom::sync_point::value);
     },
-    [=](atom::expire, data& key) {
-      self->state.expire(key);
+    [=](atom::tick, atom::expire) {
+      self->state.tick();
     },
     [=](atom::get, atom::keys) -> expected<data> {
       auto x = self->state.backend->keys();
@@ -306,25 +495,11 @@ caf::behavior master_actor(caf::stateful_actor<master_state>* self,
     // --- stream handshake with core ------------------------------------------
     [=](const store::stream_type& in) {
       BROKER_DEBUG("received stream handshake from core");
-      self->make_sink(
-        // input stream
-        in,
-        // initialize state
-        [](caf::unit_t&) {
-          // nop
-        },
-        // processing step
-        [=](caf::unit_t&, store::stream_type::value_type y) {
-          // TODO: our operator() overloads require mutable references, but
-          //       only a fraction actually benefit from it.
-          auto cmd = move_command(y);
-          self->state.command(cmd);
-        },
-        // cleanup
-        [](caf::unit_t&, const caf::error&) {
-          // nop
-        }
-      );
+      auto& st = self->state;
+      if (st.sink == nullptr)
+        st.sink = caf::make_counted<master_sink>(self, &st);
+      if (st.sink->add_unchecked_inbound_path(in) == caf::invalid_stream_slot)
+        BROKER_WARNING("failed to init stream to master");
     }
   };
 }
@@ -1,6 +1,9 @@
 #include <set>
 #include <cstdint>
+#include <iterator>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "broker/detail/appliers.hh"
 #include "broker/detail/memory_backend.hh"
@@ -8,6 +11,32 @@
 namespace broker {
 namespace detail {
 
+namespace {
+
+/// Iterates over a copy of the store, i.e., modifications after creating the
+/// cursor do not affect it.
+class memory_cursor : public backend_cursor {
+public:
+  template <class Map>
+  explicit memory_cursor(const Map& xs) {
+    xs_.reserve(xs.size());
+    for (auto& x : xs)
+      xs_.emplace_back(x.first, x.second.first);
+    pos_ = xs_.begin();
+  }
+
+  expected<bool> next(size_t n, std::vector<snapshot_entry>& xs) override {
+    for (; n > 0 && pos_ != xs_.end(); --n, ++pos_)
+      xs.emplace_back(std::move(*pos_));
+    return pos_ != xs_.end();
+  }
+
+private:
+  std::vector<snapshot_entry> xs_;
+  std::vector<snapshot_entry>::iterator pos_;
+};
+
+} // namespace
 
 memory_backend::memory_backend(backend_options opts)
   : options_{std::move(opts)} {
@@ -20,17 +49,17 @@ memory_backend::put(const data& key, data value, optional<timestamp> expiry) {
   return {};
 }
 
-expected<void> memory_backend::add(const data& key, const data& value,
-								   data::type init_type,
+expected<void> memory_backend::add(const data& key, data value,
+                                   data::type init_type,
                                    optional<timestamp> expiry) {
   auto i = store_.find(key);
   if (i == store_.end()) {
     if (init_type == data::type::none)
       return ec::type_clash;
     auto newv = std::make_pair(data::from_type(init_type), expiry);
-    i = store_.emplace(std::move(key), std::move(newv)).first;
+    i = store_.emplace(key, std::move(newv)).first;
   }
-  auto result = caf::visit(adder{value}, i->second.first);
+  auto result = caf::visit(adder{std::move(value)}, i->second.first);
   if (result)
     i->second.second = std::move(expiry);
   return result;
@@ -75,9 +104,13 @@ expected<data> memory_backend::get(const data& key) const {
 }
 
 expected<data> memory_backend::keys() const {
-  set keys;
-  for ( auto i = store_.begin(); i != store_.end(); i++ )
-    keys.insert(i->first);
+  // Sorting all keys at once is cheaper than inserting them one by one.
+  vector xs;
+  xs.reserve(store_.size());
+  for (auto& kvp : store_)
+    xs.emplace_back(kvp.first);
+  set keys(std::make_move_iterator(xs.begin()),
+           std::make_move_iterator(xs.end()));
   return expected<data>(std::move(keys));
 }
 
@@ -106,6 +139,10 @@ expected<snapshot> memory_backend::snapshot() const {
   return {std::move(ss)};
 }
 
+expected<backend_cursor_ptr> memory_backend::cursor() const {
+  return {std::make_unique<memory_cursor>(store_)};
+}
+
 expected<expirables> memory_backend::expiries() const {
   expirables rval;
 
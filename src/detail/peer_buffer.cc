@@ -0,0 +1,163 @@
+#include "broker/detail/peer_buffer.hh"
+
+#include <algorithm>
+#include <atomic>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+#include <caf/detail/get_process_id.hpp>
+
+#include "broker/detail/filesystem.hh"
+#include "broker/error.hh"
+#include "broker/logger.hh"
+
+namespace broker {
+namespace detail {
+
+namespace {
+
+using buffer_type = caf::binary_serializer::container_type;
+
+/// Unpacked messages only travel between peers in the same process. We don't
+/// know their size without serializing them, so we charge a flat fee.
+constexpr size_t unpacked_value_size = 64;
+
+std::string make_spill_file_name(const std::string& dir) {
+  static std::atomic<size_t> next_id;
+  auto result = dir;
+  result += "/broker-spill-";
+  result += std::to_string(caf::detail::get_process_id());
+  result += '-';
+  result += std::to_string(next_id++);
+  result += ".dat";
+  return result;
+}
+
+} // namespace
+
+peer_buffer::peer_buffer(limits cfg) : cfg_(std::move(cfg)) {
+  // nop
+}
+
+peer_buffer::~peer_buffer() {
+  close_spill_file();
+}
+
+peer_buffer::push_result peer_buffer::push(caf::execution_unit* ctx,
+                                           batch& xs) {
+  auto result = push_impl(ctx, xs);
+  worst_result_ = std::max(worst_result_, result);
+  return result;
+}
+
+size_t peer_buffer::approx_size(const node_message& x) {
+  auto result = sizeof(node_message) + get_topic(x).string().size();
+  if (x.packed)
+    result += x.cache->size();
+  else
+    result += unpacked_value_size;
+  return result;
+}
+
+peer_buffer::push_result peer_buffer::push_impl(caf::execution_unit* ctx,
+                                                batch& xs) {
+  if (spill_file_.is_open())
+    return spill(ctx, xs);
+  size_t bytes = 0;
+  for (auto& x : xs)
+    bytes += approx_size(x);
+  if (memory_usage_ + bytes > cfg_.memory && !memory_.empty())
+    return spill(ctx, xs);
+  memory_usage_ += bytes;
+  size_ += xs.size();
+  memory_.emplace_back(std::move(xs));
+  return push_result::buffered;
+}
+
+peer_buffer::push_result peer_buffer::spill(caf::execution_unit* ctx,
+                                            batch& xs) {
+  auto drop = [&] {
+    dropped_ += xs.size();
+    return push_result::dropped;
+  };
+  if (cfg_.spill_directory.empty() || spill_failed_)
+    return drop();
+  if (!spill_file_.is_open()) {
+    spill_file_name_ = make_spill_file_name(cfg_.spill_directory);
+    spill_file_.open(spill_file_name_, std::ios::in | std::ios::out
+                                         | std::ios::trunc | std::ios::binary);
+    if (!spill_file_.is_open()) {
+      BROKER_ERROR("unable to open spill file:" << spill_file_name_);
+      spill_file_name_.clear();
+      spill_failed_ = true;
+      return drop();
+    }
+  }
+  buffer_type buf;
+  caf::binary_serializer sink{ctx, buf};
+  if (auto err = sink(xs)) {
+    BROKER_ERROR("unable to serialize a batch for spilling:" << err);
+    return drop();
+  }
+  uint64_t n = buf.size();
+  if (spill_usage_ + sizeof(n) + n > cfg_.spill)
+    return drop();
+  if (!spill_file_.write(reinterpret_cast<const char*>(&n), sizeof(n))
+      || !spill_file_.write(buf.data(), buf.size())) {
+    BROKER_ERROR("unable to write to spill file:" << spill_file_name_);
+    return drop();
+  }
+  spill_usage_ += sizeof(n) + n;
+  size_ += xs.size();
+  return push_result::spilled;
+}
+
+caf::error peer_buffer::read_spilled(caf::execution_unit* ctx, batch& xs,
+                                     bool& done) {
+  if (!reading_) {
+    // Switch from writing to reading on the first call.
+    spill_file_.flush();
+    spill_file_.seekg(0);
+    reading_ = true;
+  }
+  uint64_t n = 0;
+  if (!spill_file_.read(reinterpret_cast<char*>(&n), sizeof(n))) {
+    if (spill_file_.eof()) {
+      done = true;
+      return caf::none;
+    }
+    return make_error(ec::end_of_file, spill_file_name_);
+  }
+  buffer_type buf(n);
+  if (!spill_file_.read(buf.data(), static_cast<std::streamsize>(n)))
+    return make_error(ec::end_of_file, spill_file_name_);
+  xs.clear();
+  caf::binary_deserializer source{ctx, buf};
+  return source(xs);
+}
+
+void peer_buffer::close_spill_file() {
+  if (spill_file_name_.empty())
+    return;
+  spill_file_.close();
+  detail::remove(spill_file_name_);
+  spill_file_name_.clear();
+  spill_usage_ = 0;
+  reading_ = false;
+}
+
+const char* to_string(peer_buffer::push_result x) {
+  switch (x) {
+    default:
+      return "<unknown>";
+    case peer_buffer::push_result::buffered:
+      return "buffered";
+    case peer_buffer::push_result::spilled:
+      return "spilled";
+    case peer_buffer::push_result::dropped:
+      return "dropped";
+  }
+}
+
+} // namespace detail
+} // namespace broker
@@ -0,0 +1,39 @@
+#include "broker/detail/replication_log.hh"
+
+#include "broker/detail/assert.hh"
+
+namespace broker {
+namespace detail {
+
+replication_log::replication_log(size_t max_size) : max_size_(max_size) {
+  // nop
+}
+
+bool replication_log::covers(sequence_number since) const noexcept {
+  return since <= last_seq_ && last_seq_ - since <= entries_.size();
+}
+
+void replication_log::max_size(size_t value) {
+  max_size_ = value;
+  while (entries_.size() > max_size_)
+    entries_.pop_front();
+}
+
+void replication_log::append(internal_command& x) {
+  x.seq = ++last_seq_;
+  if (max_size_ == 0)
+    return;
+  if (entries_.size() == max_size_)
+    entries_.pop_front();
+  entries_.emplace_back(x);
+}
+
+std::vector<internal_command>
+replication_log::since(sequence_number since) const {
+  BROKER_ASSERT(covers(since));
+  auto n = static_cast<size_t>(last_seq_ - since);
+  return {entries_.end() - static_cast<std::ptrdiff_t>(n), entries_.end()};
+}
+
+} // namespace detail
+} // namespace broker
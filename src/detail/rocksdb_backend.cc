@@ -1,5 +1,11 @@
+#include <rocksdb/comparator.h>
 #include <rocksdb/db.h>
 #include <rocksdb/options.h>
+#include <rocksdb/utilities/write_batch_with_index.h>
+
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "broker/logger.hh"
 
@@ -42,16 +48,78 @@ data from_key_blob(const char* data, size_t size) {
   return from_blob<broker::data>(data + 1, size - 1);
 }
 
+/// Walks over the application data with a single iterator that reads from a
+/// snapshot of the database, i.e., later writes do not affect the cursor.
+class rocksdb_cursor : public backend_cursor {
+public:
+  rocksdb_cursor(rocksdb::DB* db, size_t* open_cursors)
+    : db_(db), open_cursors_(open_cursors) {
+    ++*open_cursors_;
+    rocksdb::ReadOptions opts;
+    opts.fill_cache = false;
+    opts.snapshot = snapshot_ = db_->GetSnapshot();
+    i_.reset(db_->NewIterator(opts));
+    i_->Seek(rocksdb::Slice{&pfx, 1}); // initializes iterator
+  }
+
+  ~rocksdb_cursor() override {
+    // The iterator must go away before releasing its snapshot.
+    i_.reset();
+    db_->ReleaseSnapshot(snapshot_);
+    --*open_cursors_;
+  }
+
+  expected<bool> next(size_t n, std::vector<snapshot_entry>& xs) override {
+    for (; n > 0 && at_data(); --n) {
+      auto key = from_key_blob<prefix::data>(i_->key().data(),
+                                             i_->key().size());
+      auto value = from_value_blob(i_->value().data(), i_->value().size());
+      if (!value) {
+        BROKER_ERROR("failed to decode value:" << value.error());
+        return ec::backend_failure;
+      }
+      xs.emplace_back(std::move(key), std::move(*value));
+      i_->Next();
+    }
+    if (!i_->status().ok()) {
+      BROKER_ERROR("failed to read next chunk:" << i_->status().ToString());
+      return ec::backend_failure;
+    }
+    return at_data();
+  }
+
+private:
+  static constexpr char pfx = static_cast<char>(prefix::data);
+
+  bool at_data() const {
+    return i_->Valid() && i_->key()[0] == pfx;
+  }
+
+  rocksdb::DB* db_;
+  size_t* open_cursors_;
+  const rocksdb::Snapshot* snapshot_;
+  std::unique_ptr<rocksdb::Iterator> i_;
+};
+
 } // namespace <anonymous>
 
 struct rocksdb_backend::impl {
-  template <class Key, class Value>
-  bool put(const Key& key, const Value& value) {
+  /// Passes a write batch to `f` and writes its modifications. Inside of a
+  /// batch (see `begin_batch`), `f` adds its modifications to the pending
+  /// batch instead.
+  template <class F>
+  bool write(F f) {
     if (!db)
       return false;
-    auto status = db->Put({}, key, value);
+    if (pending) {
+      f(*pending);
+      return true;
+    }
+    rocksdb::WriteBatch batch;
+    f(batch);
+    auto status = db->Write({}, &batch);
     if (!status.ok()) {
-      BROKER_ERROR("failed put key-value-pair:" << status.ToString());
+      BROKER_ERROR("failed to write batch:" << status.ToString());
       return false;
     }
     return true;
@@ -59,23 +127,25 @@ struct rocksdb_backend::impl {
 
   template <class Key, class Value>
   bool put(Key& key, const Value& value, optional<timestamp> expiry) {
-    if (!db)
-      return false;
-    rocksdb::WriteBatch batch;
-    batch.Put(key, value);
-    // Write expiry.
-    if (expiry) {
-      BROKER_ASSERT(key.size() > 1);
-      key[0] = static_cast<char>(prefix::expiry); // reuse key blob
-      auto blob = to_blob(*expiry);
-      batch.Put(key, blob);
-    }
-    auto status = db->Write({}, &batch);
-    if (!status.ok()) {
-      BROKER_ERROR("failed to put key-value pair:" << status.ToString());
-      return false;
-    }
-    return true;
+    return write([&](rocksdb::WriteBatchBase& batch) {
+      batch.Put(key, value);
+      // Write expiry.
+      if (expiry) {
+        BROKER_ASSERT(key.size() > 1);
+        key[0] = static_cast<char>(prefix::expiry); // reuse key blob
+        auto blob = to_blob(*expiry);
+        batch.Put(key, blob);
+      }
+    });
+  }
+
+  /// Looks up `key` in the pending batch and in the database.
+  template <class Key>
+  rocksdb::Status lookup(const Key& key, std::string* value) {
+    if (pending)
+      return pending->GetFromBatchAndDB(db, rocksdb::ReadOptions{}, key,
+                                        value);
+    return db->Get(rocksdb::ReadOptions{}, key, value);
   }
 
   template <class Key>
@@ -84,11 +154,13 @@ struct rocksdb_backend::impl {
       return ec::backend_failure;
     std::string value;
     bool exists;
-    if (!db->KeyMayExist({}, key, &value, &exists))
-      return ec::no_such_key;
-    if (exists)
-      return value;
-    auto status = db->Get(rocksdb::ReadOptions{}, key, &value);
+    if (!pending) {
+      if (!db->KeyMayExist({}, key, &value, &exists))
+        return ec::no_such_key;
+      if (exists)
+        return value;
+    }
+    auto status = lookup(key, &value);
     if (status.IsNotFound())
       return ec::no_such_key;
     if (!status.ok()) {
@@ -107,11 +179,13 @@ struct rocksdb_backend::impl {
       return ec::backend_failure;
     bool exists;
     std::string value; // unused, but can't pass nullptr
-    if (!db->KeyMayExist({}, key, &value, &exists))
-      return false;
-    if (exists)
-      return true;
-    auto status = db->Get(rocksdb::ReadOptions{}, key, nullptr);
+    if (!pending) {
+      if (!db->KeyMayExist({}, key, &value, &exists))
+        return false;
+      if (exists)
+        return true;
+    }
+    auto status = lookup(key, &value);
     if (status.IsNotFound())
       return false;
     if (!status.ok()) {
@@ -121,20 +195,16 @@ struct rocksdb_backend::impl {
     return true;
   }
 
-  template <class Key>
-  expected<void> erase(const Key& key) {
-    if (!db)
-      return ec::backend_failure;
-    auto status = db->Delete({}, key);
-    if (!status.ok()) {
-      BROKER_ERROR("failed to delete key:" << status.ToString());
-      return ec::backend_failure;
-    }
-  }
-
   rocksdb::DB* db = nullptr;
+
+  /// Collects modifications between `begin_batch` and `commit_batch`.
+  std::unique_ptr<rocksdb::WriteBatchWithIndex> pending;
+
   count exact_size_threshold = 10000;
   std::string path;
+
+  /// Number of cursors that read from `db`.
+  size_t open_cursors = 0;
 };
 
 rocksdb_backend::rocksdb_backend(backend_options opts)
@@ -199,13 +269,13 @@ expected<void> rocksdb_backend::put(const data& key, data value,
   if (!impl_->db)
     return ec::backend_failure;
   auto key_blob = to_key_blob<prefix::data>(key);
-  auto value_blob = to_blob(value);
+  auto value_blob = to_value_blob(value);
   if (!impl_->put(key_blob, value_blob, expiry))
     return ec::backend_failure;
   return {};
 }
 
-expected<void> rocksdb_backend::add(const data& key, const data& value,
+expected<void> rocksdb_backend::add(const data& key, data value,
                                     data::type init_type,
                                     optional<timestamp> expiry) {
   auto key_blob = to_key_blob<prefix::data>(key);
@@ -216,12 +286,17 @@ expected<void> rocksdb_backend::add(const data& key, const data& value,
       return value_blob.error();
     v = data::from_type(init_type);
   } else {
-    v = from_blob<data>(*value_blob);
+    auto x = from_value_blob(*value_blob);
+    if (!x) {
+      BROKER_ERROR("failed to decode value:" << x.error());
+      return ec::backend_failure;
+    }
+    v = std::move(*x);
   }
-  auto result = caf::visit(adder{value}, v);
+  auto result = caf::visit(adder{std::move(value)}, v);
   if (!result)
     return result;
-  if (!impl_->put(key_blob, to_blob(v), expiry))
+  if (!impl_->put(key_blob, to_value_blob(v), expiry))
     return ec::backend_failure;
   return {};
 }
@@ -232,35 +307,64 @@ expected<void> rocksdb_backend::subtract(const data& key, const data& value,
   auto value_blob = impl_->get(key_blob);
   if (!value_blob)
     return value_blob.error();
-  auto v = from_blob<data>(*value_blob);
-  auto result = caf::visit(remover{value}, v);
+  auto v = from_value_blob(*value_blob);
+  if (!v) {
+    BROKER_ERROR("failed to decode value:" << v.error());
+    return ec::backend_failure;
+  }
+  auto result = caf::visit(remover{value}, *v);
   if (!result)
     return result;
-  *value_blob = to_blob(v);
+  *value_blob = to_value_blob(*v);
   if (!impl_->put(key_blob, *value_blob, expiry))
     return ec::backend_failure;
   return {};
 }
 
 expected<void> rocksdb_backend::erase(const data& key) {
-  if (!impl_->db)
-    return ec::backend_failure;
-  rocksdb::WriteBatch batch;
   auto key_blob = to_key_blob<prefix::data>(key);
-  batch.Delete(key_blob);
-  key_blob[0] = static_cast<char>(prefix::expiry);
-  batch.Delete(key_blob);
-  auto status = impl_->db->Write({}, &batch);
-  if (!status.ok()) {
-    BROKER_ERROR("failed to delete key:" << status.ToString());
+  auto ok = impl_->write([&](rocksdb::WriteBatchBase& batch) {
+    batch.Delete(key_blob);
+    key_blob[0] = static_cast<char>(prefix::expiry);
+    batch.Delete(key_blob);
+  });
+  if (!ok)
     return ec::backend_failure;
-  }
   return {};
 }
 
 expected<void> rocksdb_backend::clear() {
   if (!impl_->db)
     return ec::backend_failure;
+  // Clearing drops all earlier modifications of the current batch, while
+  // later modifications still go to the batch.
+  if (impl_->pending)
+    impl_->pending->Clear();
+  if (impl_->pending || impl_->open_cursors > 0) {
+    // Inside a batch, destroying the database would take effect immediately,
+    // even if committing the batch fails later. Cursors still read from the
+    // current database. Hence, we delete all entries in both cases instead of
+    // destroying the database.
+    std::vector<std::string> keys;
+    std::unique_ptr<rocksdb::Iterator> i{impl_->db->NewIterator({})};
+    for (auto pfx : {prefix::data, prefix::expiry}) {
+      auto first = static_cast<char>(pfx);
+      for (i->Seek(rocksdb::Slice{&first, 1});
+           i->Valid() && i->key()[0] == first; i->Next())
+        keys.emplace_back(i->key().ToString());
+    }
+    if (!i->status().ok()) {
+      BROKER_ERROR("failed to clear DB:" << i->status().ToString());
+      return ec::backend_failure;
+    }
+    auto ok = impl_->write([&](rocksdb::WriteBatchBase& batch) {
+      for (auto& key : keys)
+        batch.Delete(key);
+    });
+    if (!ok)
+      return ec::backend_failure;
+    return {};
+  }
   std::string path = impl_->path;
   delete impl_->db;
   impl_->db = nullptr;
@@ -287,29 +391,55 @@ expected<bool> rocksdb_backend::expire(const data& key, timestamp ts) {
   auto expiry = from_blob<timestamp>(*expiry_blob);
   if (ts < expiry)
     return false;
-  rocksdb::WriteBatch batch;
-  batch.Delete(key_blob);
-  key_blob[0] = static_cast<char>(prefix::data);
-  batch.Delete(key_blob);
-  auto status = impl_->db->Write({}, &batch);
+  auto ok = impl_->write([&](rocksdb::WriteBatchBase& batch) {
+    batch.Delete(key_blob);
+    key_blob[0] = static_cast<char>(prefix::data);
+    batch.Delete(key_blob);
+  });
+  if (!ok)
+    return ec::backend_failure;
+  return true;
+}
+
+expected<void> rocksdb_backend::begin_batch() {
+  if (!impl_->db)
+    return ec::backend_failure;
+  // Overwriting keys in the index allows lookups to see the latest value.
+  impl_->pending = std::make_unique<rocksdb::WriteBatchWithIndex>(
+    rocksdb::BytewiseComparator(), 0, true);
+  return {};
+}
+
+expected<void> rocksdb_backend::commit_batch() {
+  if (!impl_->pending)
+    return {};
+  auto batch = std::move(impl_->pending);
+  if (!impl_->db)
+    return ec::backend_failure;
+  auto status = impl_->db->Write({}, batch->GetWriteBatch());
   if (!status.ok()) {
-    BROKER_ERROR("failed to delete key:" << status.ToString());
+    BROKER_ERROR("failed to commit batch:" << status.ToString());
     return ec::backend_failure;
   }
-  return true;
+  return {};
 }
 
 expected<data> rocksdb_backend::get(const data& key) const {
   auto value_blob = impl_->get(to_key_blob<prefix::data>(key));
   if (!value_blob)
     return value_blob.error();
-  return from_blob<data>(*value_blob);
+  auto value = from_value_blob(*value_blob);
+  if (!value) {
+    BROKER_ERROR("failed to decode value:" << value.error());
+    return ec::backend_failure;
+  }
+  return value;
 }
 
 expected<data> rocksdb_backend::keys() const {
   if (!impl_->db)
     return ec::backend_failure;
-  set result;
+  vector xs;
   rocksdb::ReadOptions opts;
   opts.fill_cache = false;
   auto i = std::unique_ptr<rocksdb::Iterator>{impl_->db->NewIterator(opts)};
@@ -317,14 +447,16 @@ expected<data> rocksdb_backend::keys() const {
   i->Seek(rocksdb::Slice{&pfx, 1}); // initializes iterator
   while (i->Valid() && i->key()[0] == pfx) {
     auto key = from_key_blob<prefix::data>(i->key().data(), i->key().size());
-    result.insert(std::move(key));
+    xs.emplace_back(std::move(key));
     i->Next();
   }
   if (!i->status().ok()) {
     BROKER_ERROR("failed to get keys:" << i->status().ToString());
     return ec::backend_failure;
   }
-  return {std::move(result)};
+  // RocksDB orders keys by their blob, which differs from the order of data.
+  return {set(std::make_move_iterator(xs.begin()),
+              std::make_move_iterator(xs.end()))};
 }
 
 expected<bool> rocksdb_backend::exists(const data& key) const {
@@ -367,8 +499,12 @@ expected<snapshot> rocksdb_backend::snapshot() const {
   i->Seek(rocksdb::Slice{&pfx, 1}); // initializes iterator
   while (i->Valid() && i->key()[0] == pfx) {
     auto key = from_key_blob<prefix::data>(i->key().data(), i->key().size());
-    auto value = from_blob<data>(i->value().data(), i->value().size());
-    result.emplace(std::move(key), std::move(value));
+    auto value = from_value_blob(i->value().data(), i->value().size());
+    if (!value) {
+      BROKER_ERROR("failed to decode value:" << value.error());
+      return ec::backend_failure;
+    }
+    result.emplace(std::move(key), std::move(*value));
     i->Next();
   }
   if (!i->status().ok()) {
@@ -378,6 +514,12 @@ expected<snapshot> rocksdb_backend::snapshot() const {
   return {std::move(result)};
 }
 
+expected<backend_cursor_ptr> rocksdb_backend::cursor() const {
+  if (!impl_->db)
+    return ec::backend_failure;
+  return {std::make_unique<rocksdb_cursor>(impl_->db, &impl_->open_cursors)};
+}
+
 expected<expirables> rocksdb_backend::expiries() const {
   if (!impl_->db)
     return ec::backend_failure;
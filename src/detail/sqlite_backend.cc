@@ -3,6 +3,9 @@
 #include <cstdio> // std::snprintf
 #include <utility>
 #include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -30,6 +33,75 @@ auto make_statement_guard = [](sqlite3_stmt* stmt) {
   return caf::detail::make_scope_guard([=] { sqlite3_reset(stmt); });
 };
 
+/// Reads the store table in chunks, ordered by row ID. The cursor reads
+/// through its own connection inside a single read transaction. In WAL mode,
+/// this gives the cursor a fixed view of the database while the backend keeps
+/// writing through its main connection.
+class sqlite_cursor : public backend_cursor {
+public:
+  sqlite_cursor() = default;
+
+  ~sqlite_cursor() override {
+    if (stmt_ != nullptr)
+      sqlite3_finalize(stmt_);
+    if (db_ != nullptr) {
+      sqlite3_exec(db_, "rollback transaction;", nullptr, nullptr, nullptr);
+      sqlite3_close(db_);
+    }
+  }
+
+  bool open(const std::string& path) {
+    BROKER_LSAN_DISABLE();
+    auto result = sqlite3_open_v2(path.c_str(), &db_, SQLITE_OPEN_READONLY,
+                                  nullptr);
+    BROKER_LSAN_ENABLE();
+    if (result != SQLITE_OK)
+      return false;
+    result = sqlite3_prepare_v2(db_,
+                                "select rowid, key, value from store "
+                                "where rowid > ? order by rowid limit ?;",
+                                -1, &stmt_, nullptr);
+    if (result != SQLITE_OK)
+      return false;
+    // The first read inside the transaction pins the view of the database.
+    result = sqlite3_exec(db_,
+                          "begin transaction; select count(*) from meta;",
+                          nullptr, nullptr, nullptr);
+    return result == SQLITE_OK;
+  }
+
+  expected<bool> next(size_t n, std::vector<snapshot_entry>& xs) override {
+    auto guard = make_statement_guard(stmt_);
+    if (sqlite3_bind_int64(stmt_, 1, last_row_) != SQLITE_OK
+        || sqlite3_bind_int64(stmt_, 2, static_cast<sqlite3_int64>(n))
+             != SQLITE_OK)
+      return ec::backend_failure;
+    size_t rows = 0;
+    auto result = SQLITE_DONE;
+    while ((result = sqlite3_step(stmt_)) == SQLITE_ROW) {
+      last_row_ = sqlite3_column_int64(stmt_, 0);
+      auto key = from_blob<data>(sqlite3_column_blob(stmt_, 1),
+                                 sqlite3_column_bytes(stmt_, 1));
+      auto value = from_value_blob(sqlite3_column_blob(stmt_, 2),
+                                   sqlite3_column_bytes(stmt_, 2));
+      if (!value) {
+        BROKER_ERROR("failed to decode value:" << value.error());
+        return ec::backend_failure;
+      }
+      xs.emplace_back(std::move(key), std::move(*value));
+      ++rows;
+    }
+    if (result != SQLITE_DONE)
+      return ec::backend_failure;
+    return rows == n;
+  }
+
+private:
+  sqlite3* db_ = nullptr;
+  sqlite3_stmt* stmt_ = nullptr;
+  sqlite3_int64 last_row_ = std::numeric_limits<sqlite3_int64>::min();
+};
+
 } // namespace <anonymous>
 
 struct sqlite_backend::impl {
@@ -78,6 +150,24 @@ struct sqlite_backend::impl {
       BROKER_ERROR("failed to open database:" << path);
       return false;
     }
+    // Let SQLite retry for a while instead of failing right away with
+    // SQLITE_BUSY if another connection holds a lock on the database.
+    sqlite3_busy_timeout(db, 1000);
+    // Switch to write-ahead logging. This allows cursors to read from a
+    // fixed view of the database on a second connection while the backend
+    // keeps writing.
+    std::string journal_mode;
+    auto store_mode = [](void* ptr, int argc, char** argv, char**) {
+      if (argc > 0 && argv[0] != nullptr)
+        *static_cast<std::string*>(ptr) = argv[0];
+      return 0;
+    };
+    result = sqlite3_exec(db, "pragma journal_mode=wal;", store_mode,
+                          &journal_mode, nullptr);
+    wal = result == SQLITE_OK && journal_mode == "wal";
+    if (!wal)
+      BROKER_WARNING("failed to enable WAL mode, cursors read a copy");
+    file = path;
     // Create table for store meta data.
     result = sqlite3_exec(db,
                           "create table if not exists "
@@ -121,6 +211,10 @@ struct sqlite_backend::impl {
       {&expiries, "select key, expiry from store where expiry is not null;"},
       {&clear, "delete from store;"},
       {&keys, "select key from store;"},
+
+      {&begin, "begin transaction;"},
+      {&commit, "commit transaction;"},
+      {&rollback, "rollback transaction;"},
     };
     auto prepare = [&](sqlite3_stmt** stmt, const char* sql) {
       finalize.push_back(*stmt);
@@ -137,7 +231,7 @@ struct sqlite_backend::impl {
   bool modify(const data& key, const data& value,
               optional<timestamp> expiry) {
     auto key_blob = to_blob(key);
-    auto value_blob = to_blob(value);
+    auto value_blob = to_value_blob(value);
     auto guard = make_statement_guard(update);
 
     // Bind value.
@@ -170,6 +264,8 @@ struct sqlite_backend::impl {
   }
 
   backend_options options;
+  std::string file;
+  bool wal = false;
   sqlite3* db = nullptr;
   sqlite3_stmt* replace = nullptr;
   sqlite3_stmt* update = nullptr;
@@ -182,6 +278,9 @@ struct sqlite_backend::impl {
   sqlite3_stmt* expiries = nullptr;
   sqlite3_stmt* clear = nullptr;
   sqlite3_stmt* keys = nullptr;
+  sqlite3_stmt* begin = nullptr;
+  sqlite3_stmt* commit = nullptr;
+  sqlite3_stmt* rollback = nullptr;
   std::vector<sqlite3_stmt*> finalize;
 };
 
@@ -205,7 +304,7 @@ expected<void> sqlite_backend::put(const data& key, data value,
   if (result != SQLITE_OK)
     return ec::backend_failure;
   // Bind value.
-  auto value_blob = to_blob(value);
+  auto value_blob = to_value_blob(value);
   result = sqlite3_bind_blob64(impl_->replace, 2, value_blob.data(),
                                value_blob.size(), SQLITE_STATIC);
   if (result != SQLITE_OK)
@@ -223,7 +322,7 @@ expected<void> sqlite_backend::put(const data& key, data value,
   return {};
 }
 
-expected<void> sqlite_backend::add(const data& key, const data& value,
+expected<void> sqlite_backend::add(const data& key, data value,
                                    data::type init_type,
                                    optional<timestamp> expiry) {
   auto v = get(key);
@@ -235,7 +334,7 @@ expected<void> sqlite_backend::add(const data& key, const data& value,
   } else {
     vv = std::move(*v);
   }
-  auto result = caf::visit(adder{value}, vv);
+  auto result = caf::visit(adder{std::move(value)}, vv);
   if (!result)
     return result;
   return put(key, std::move(vv), expiry);
@@ -302,6 +401,31 @@ expected<bool> sqlite_backend::expire(const data& key, timestamp ts) {
   return sqlite3_changes(impl_->db) == 1;
 }
 
+expected<void> sqlite_backend::begin_batch() {
+  if (!impl_->db)
+    return ec::backend_failure;
+  auto guard = make_statement_guard(impl_->begin);
+  if (sqlite3_step(impl_->begin) != SQLITE_DONE)
+    return ec::backend_failure;
+  return {};
+}
+
+expected<void> sqlite_backend::commit_batch() {
+  if (!impl_->db)
+    return ec::backend_failure;
+  auto guard = make_statement_guard(impl_->commit);
+  if (sqlite3_step(impl_->commit) == SQLITE_DONE)
+    return {};
+  BROKER_ERROR("failed to commit transaction:" << sqlite3_errmsg(impl_->db));
+  // A failed commit leaves the transaction open (unless SQLite already rolled
+  // it back on its own).
+  if (sqlite3_get_autocommit(impl_->db) == 0) {
+    auto rollback_guard = make_statement_guard(impl_->rollback);
+    sqlite3_step(impl_->rollback);
+  }
+  return ec::backend_failure;
+}
+
 expected<data> sqlite_backend::get(const data& key) const {
   if (!impl_->db)
     return ec::backend_failure;
@@ -316,23 +440,29 @@ expected<data> sqlite_backend::get(const data& key) const {
 	  return ec::no_such_key;
 	if (result != SQLITE_ROW)
     return ec::backend_failure;
-	return from_blob<data>(sqlite3_column_blob(impl_->lookup, 0),
-                         sqlite3_column_bytes(impl_->lookup, 0));
+  auto value = from_value_blob(sqlite3_column_blob(impl_->lookup, 0),
+                               sqlite3_column_bytes(impl_->lookup, 0));
+  if (!value) {
+    BROKER_ERROR("failed to decode value:" << value.error());
+    return ec::backend_failure;
+  }
+  return value;
 }
 
 expected<data> sqlite_backend::keys() const {
   if (!impl_->db)
     return ec::backend_failure;
   auto guard = make_statement_guard(impl_->keys);
-  set keys;
+  vector xs;
   auto result = SQLITE_DONE;
   while ((result = sqlite3_step(impl_->keys)) == SQLITE_ROW) {
     auto key = from_blob<data>(sqlite3_column_blob(impl_->keys, 0),
                                sqlite3_column_bytes(impl_->keys, 0));
-    keys.insert(std::move(key));
+    xs.emplace_back(std::move(key));
   }
   if (result == SQLITE_DONE)
-    return {std::move(keys)};
+    return {set(std::make_move_iterator(xs.begin()),
+                std::make_move_iterator(xs.end()))};
   return ec::backend_failure;
 }
 
@@ -375,15 +505,33 @@ expected<snapshot> sqlite_backend::snapshot() const {
   while ((result = sqlite3_step(impl_->snapshot)) == SQLITE_ROW) {
     auto key = from_blob<data>(sqlite3_column_blob(impl_->snapshot, 0),
                                sqlite3_column_bytes(impl_->snapshot, 0));
-    auto value = from_blob<data>(sqlite3_column_blob(impl_->snapshot, 1),
+    auto value = from_value_blob(sqlite3_column_blob(impl_->snapshot, 1),
                                  sqlite3_column_bytes(impl_->snapshot, 1));
-    ss.emplace(std::move(key), std::move(value));
+    if (!value) {
+      BROKER_ERROR("failed to decode value:" << value.error());
+      return ec::backend_failure;
+    }
+    ss.emplace(std::move(key), std::move(*value));
   }
   if (result == SQLITE_DONE)
     return {std::move(ss)};
   return ec::backend_failure;
 }
 
+expected<backend_cursor_ptr> sqlite_backend::cursor() const {
+  if (!impl_->db)
+    return ec::backend_failure;
+  // Without WAL mode, readers on a second connection would block writes.
+  if (!impl_->wal)
+    return abstract_backend::cursor();
+  auto result = std::make_unique<sqlite_cursor>();
+  if (!result->open(impl_->file)) {
+    BROKER_ERROR("failed to open cursor on" << impl_->file);
+    return ec::backend_failure;
+  }
+  return {std::move(result)};
+}
+
 expected<expirables> sqlite_backend::expiries() const {
   if (!impl_->db)
     return ec::backend_failure;
@@ -0,0 +1,110 @@
+#include "broker/detail/topic_table.hh"
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+namespace broker {
+namespace detail {
+
+namespace {
+
+constexpr size_t min_purge_threshold = 1024;
+
+// Must match the constants in the namespace `broker::topics`.
+constexpr char master_suffix[] = "<$>/data/master";
+constexpr char clone_suffix[] = "<$>/data/clone";
+constexpr char errors_topic[] = "<$>/data/errors";
+constexpr char statuses_topic[] = "<$>/data/statuses";
+
+template <size_t N>
+bool ends_with(const std::string& str, const char (&suffix)[N]) {
+  constexpr auto n = N - 1;
+  return str.size() >= n && str.compare(str.size() - n, n, suffix) == 0;
+}
+
+} // namespace
+
+topic_table::topic_table()
+  : purge_threshold_(min_purge_threshold), next_id_(1) {
+  // nop
+}
+
+topic_entry_ptr topic_table::intern(const std::string& str) {
+  return intern_impl(str);
+}
+
+topic_entry_ptr topic_table::intern(std::string&& str) {
+  return intern_impl(std::move(str));
+}
+
+size_t topic_table::size() const {
+  std::shared_lock<std::shared_mutex> guard{mtx_};
+  return entries_.size();
+}
+
+topic_table& topic_table::instance() {
+  // Never destroyed, since topics may outlive other static objects.
+  static auto ptr = new topic_table;
+  return *ptr;
+}
+
+topic_flags topic_table::classify(const std::string& str) {
+  auto result = topic_flags::none;
+  if (ends_with(str, clone_suffix))
+    result = result + topic_flags::clone;
+  if (ends_with(str, master_suffix))
+    result = result + topic_flags::master;
+  if (str == errors_topic)
+    result = result + topic_flags::errors;
+  if (str == statuses_topic)
+    result = result + topic_flags::statuses;
+  return result;
+}
+
+template <class String>
+topic_entry_ptr topic_table::intern_impl(String&& str) {
+  if (str.empty())
+    return nullptr;
+  { // Fast path: the entry exists and is alive.
+    std::shared_lock<std::shared_mutex> guard{mtx_};
+    auto i = entries_.find(str);
+    if (i != entries_.end())
+      if (auto ptr = i->second.lock())
+        return ptr;
+  }
+  std::unique_lock<std::shared_mutex> guard{mtx_};
+  // Check again, since another thread may have added the entry meanwhile.
+  auto i = entries_.find(str);
+  if (i != entries_.end()) {
+    if (auto ptr = i->second.lock())
+      return ptr;
+    auto h = std::hash<std::string>{}(str);
+    auto flags = classify(str);
+    auto ptr = std::make_shared<const topic_entry>(
+      topic_entry{std::forward<String>(str), h, next_id_++, flags});
+    i->second = ptr;
+    return ptr;
+  }
+  purge_if_needed();
+  auto h = std::hash<std::string>{}(str);
+  auto ptr = std::make_shared<const topic_entry>(
+    topic_entry{std::string{str}, h, next_id_++, classify(str)});
+  entries_.emplace(std::forward<String>(str), ptr);
+  return ptr;
+}
+
+void topic_table::purge_if_needed() {
+  if (entries_.size() < purge_threshold_)
+    return;
+  for (auto i = entries_.begin(); i != entries_.end();) {
+    if (i->second.expired())
+      i = entries_.erase(i);
+    else
+      ++i;
+  }
+  purge_threshold_ = std::max(min_purge_threshold, entries_.size() * 2);
+}
+
+} // namespace detail
+} // namespace broker
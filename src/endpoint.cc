@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <unordered_set>
 
 #include <caf/config.hpp>
@@ -17,6 +20,9 @@
 #include "broker/atoms.hh"
 #include "broker/core_actor.hh"
 #include "broker/defaults.hh"
+#include "broker/detail/assert.hh"
+#include "broker/detail/clone_view.hh"
+#include "broker/detail/compact_encoding.hh"
 #include "broker/detail/die.hh"
 #include "broker/detail/filesystem.hh"
 #include "broker/endpoint.hh"
@@ -197,6 +203,18 @@ endpoint::endpoint(configuration config)
       detail::die("CAF OpenSSL manager is not available");
   BROKER_INFO("creating endpoint");
   core_ = system_.spawn(core_actor, filter_type{}, config_.options(), clock_);
+  cores_.emplace_back(core_);
+  auto num_shards = config_.options().core_shards;
+  if (num_shards > 1) {
+    BROKER_INFO("spawning" << (num_shards - 1) << "additional core shards");
+    std::vector<caf::actor> shards;
+    for (unsigned i = 1; i < num_shards; ++i) {
+      auto shard = system_.spawn(core_shard, core_, config_.options(), clock_);
+      shards.emplace_back(shard);
+      cores_.emplace_back(std::move(shard));
+    }
+    caf::anon_send(core_, atom::shard::value, std::move(shards));
+  }
 }
 
 endpoint::~endpoint() {
@@ -226,8 +244,10 @@ void endpoint::shutdown() {
     self->wait_for(children_);
     children_.clear();
   }
-  BROKER_DEBUG("send shutdown message to core actor");
-  anon_send(core_, atom::shutdown::value);
+  BROKER_DEBUG("send shutdown message to core actors");
+  for (auto& hdl : cores_)
+    anon_send(hdl, atom::shutdown::value);
+  cores_.clear();
   core_ = nullptr;
   system_.~actor_system();
   delete clock_;
@@ -337,15 +357,84 @@ std::vector<topic> endpoint::peer_subscriptions() const {
   return result;
 }
 
+std::vector<lane_depths> endpoint::peer_lane_depths() const {
+  std::vector<lane_depths> result;
+  caf::scoped_actor self{system_};
+  // Each shard has its own paths to a peer, so we sum up per peer node.
+  auto add = [&](lane_depths& x) {
+    auto same_node = [&](const lane_depths& y) {
+      return y.peer.node == x.peer.node;
+    };
+    auto i = std::find_if(result.begin(), result.end(), same_node);
+    if (i == result.end()) {
+      result.emplace_back(std::move(x));
+    } else {
+      i->control += x.control;
+      i->bulk += x.bulk;
+    }
+  };
+  for (auto& hdl : cores_)
+    self->request(hdl, caf::infinite, atom::get::value, atom::peer::value,
+                  atom::lanes::value)
+    .receive(
+      [&](std::vector<lane_depths>& xs) {
+        for (auto& x : xs)
+          add(x);
+      },
+      [](const caf::error& e) {
+        detail::die("failed to get peer lane depths:", to_string(e));
+      }
+    );
+  return result;
+}
+
+std::vector<batching_info> endpoint::peer_batching() const {
+  std::vector<batching_info> result;
+  caf::scoped_actor self{system_};
+  for (auto& hdl : cores_)
+    self->request(hdl, caf::infinite, atom::get::value, atom::peer::value,
+                  atom::batching::value)
+    .receive(
+      [&](std::vector<batching_info>& xs) {
+        result.insert(result.end(), std::make_move_iterator(xs.begin()),
+                      std::make_move_iterator(xs.end()));
+      },
+      [](const caf::error& e) {
+        detail::die("failed to get peer batching info:", to_string(e));
+      }
+    );
+  return result;
+}
+
+std::vector<peer_buffer_info> endpoint::peer_buffers() const {
+  std::vector<peer_buffer_info> result;
+  caf::scoped_actor self{system_};
+  for (auto& hdl : cores_)
+    self->request(hdl, caf::infinite, atom::get::value, atom::peer::value,
+                  atom::buffers::value)
+    .receive(
+      [&](std::vector<peer_buffer_info>& xs) {
+        result.insert(result.end(), std::make_move_iterator(xs.begin()),
+                      std::make_move_iterator(xs.end()));
+      },
+      [](const caf::error& e) {
+        detail::die("failed to get peer buffers:", to_string(e));
+      }
+    );
+  return result;
+}
+
 void endpoint::forward(std::vector<topic> ts)
 {
   BROKER_INFO("forwarding topics" << ts);
-  caf::anon_send(core(), atom::subscribe::value, std::move(ts));
+  for (auto& hdl : cores_)
+    caf::anon_send(hdl, atom::subscribe::value, ts);
 }
 
 void endpoint::publish(topic t, data d) {
   BROKER_INFO("publishing" << std::make_pair(t, d));
-  caf::anon_send(core(), atom::publish::value,
+  auto& hdl = core(t);
+  caf::anon_send(hdl, atom::publish::value,
                  make_data_message(std::move(t), std::move(d)));
 }
 
@@ -357,14 +446,63 @@ void endpoint::publish(const endpoint_info& dst, topic t, data d) {
 
 void endpoint::publish(data_message x){
   BROKER_INFO("publishing" << x);
-  caf::anon_send(core(), atom::publish::value, std::move(x));
+  auto& hdl = core(get_topic(x));
+  caf::anon_send(hdl, atom::publish::value, std::move(x));
 }
 
-
 void endpoint::publish(std::vector<data_message> xs) {
   BROKER_INFO("publishing" << xs.size() << "messages");
+  if (xs.empty())
+    return;
+  if (cores_.size() < 2) {
+    caf::anon_send(core_, atom::publish::value, std::move(xs));
+    return;
+  }
+  // Send one batch per core, preserving the order of messages per topic.
+  std::vector<std::vector<data_message>> batches(cores_.size());
+  for (auto& x : xs)
+    batches[core_index(get_topic(x))].emplace_back(std::move(x));
+  for (size_t i = 0; i < batches.size(); ++i)
+    if (!batches[i].empty())
+      caf::anon_send(cores_[i], atom::publish::value, std::move(batches[i]));
+}
+
+void endpoint::publish_batch(topic t, std::vector<data> xs) {
+  BROKER_INFO("publishing" << xs.size() << "messages to" << t);
+  if (xs.empty())
+    return;
+  std::vector<data_message> msgs;
+  msgs.reserve(xs.size());
   for (auto& x : xs)
-    publish(std::move(x));
+    msgs.emplace_back(make_data_message(t, std::move(x)));
+  auto& hdl = core(t);
+  caf::anon_send(hdl, atom::publish::value, std::move(msgs));
+}
+
+void endpoint::publish_encoded(topic t, std::vector<char> buf) {
+  BROKER_INFO("publishing" << buf.size() << "encoded bytes to" << t);
+  BROKER_ASSERT(detail::compact_encoding::is_compact(buf.data(), buf.size()));
+  auto& hdl = core(t);
+  caf::anon_send(hdl, atom::publish::value,
+                 make_packed_node_message(std::move(t), std::move(buf)));
+}
+
+const caf::actor& endpoint::core(const topic& t) const {
+  return cores_.empty() ? core_ : cores_[core_index(t)];
+}
+
+size_t endpoint::core_index(const topic& t) const {
+  // Data stores and status events always use the primary core.
+  if (cores_.size() < 2 || t.flags() != topic_flags::none)
+    return 0;
+  return t.hash() % cores_.size();
+}
+
+std::shared_ptr<size_t> endpoint::join_cores(caf::event_based_actor* self,
+                                             std::vector<topic> topics) {
+  for (auto& hdl : cores_)
+    self->send(self * hdl, atom::join::value, topics);
+  return std::make_shared<size_t>(cores_.size());
 }
 
 publisher endpoint::make_publisher(topic ts) {
@@ -426,12 +564,15 @@ expected<store> endpoint::attach_clone(std::string name,
                                        double mutation_buffer_interval) {
   BROKER_INFO("attaching clone store" << name);
   expected<store> res{ec::unspecified};
+  detail::clone_view_ptr view;
+  if (config_.options().clone_local_reads)
+    view = std::make_shared<detail::clone_view>();
   caf::scoped_actor self{core()->home_system()};
   self->request(core(), caf::infinite, atom::store::value, atom::clone::value,
                 atom::attach::value, name, resync_interval, stale_interval,
-                mutation_buffer_interval).receive(
+                mutation_buffer_interval, view).receive(
     [&](caf::actor& clone) {
-      res = store{std::move(clone), std::move(name)};
+      res = store{std::move(clone), std::move(name), std::move(view)};
     },
     [&](caf::error& e) {
       res = std::move(e);
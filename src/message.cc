@@ -0,0 +1,140 @@
+#include "broker/message.hh"
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+#include <caf/deserializer.hpp>
+#include <caf/make_counted.hpp>
+#include <caf/serializer.hpp>
+
+#include "broker/detail/assert.hh"
+#include "broker/detail/compact_encoding.hh"
+#include "broker/error.hh"
+
+namespace broker {
+namespace detail {
+
+namespace {
+
+using buffer_type = payload_cache::buffer_type;
+
+/// Identifies the type of the value in the blob.
+enum class message_kind : uint8_t {
+  data,
+  command,
+};
+
+/// Encodes data in the compact encoding. Commands carry actor handles that
+/// only CAF's serializers can handle.
+caf::error encode_value(caf::execution_unit* ctx,
+                        const node_message::value_type& x, buffer_type& buf) {
+  if (is_data_message(x)) {
+    compact_encoding::encode(get<1>(caf::get<data_message>(x)), buf);
+    return caf::none;
+  }
+  caf::binary_serializer sink{ctx, buf};
+  return sink(get<1>(caf::get<command_message>(x)));
+}
+
+caf::error write_blob(caf::serializer& sink, const char* data, size_t size) {
+  auto n = size;
+  if (auto err = sink.begin_sequence(n))
+    return err;
+  if (auto err = sink.apply_raw(n, const_cast<char*>(data)))
+    return err;
+  return sink.end_sequence();
+}
+
+} // namespace
+
+caf::error save_node_message(caf::serializer& sink, node_message& x) {
+  auto kind = static_cast<uint8_t>(is_data_message(x) ? message_kind::data
+                                                      : message_kind::command);
+  if (auto err = sink(x.ttl, kind, get_topic(x).string()))
+    return err;
+  if (x.packed)
+    return write_blob(sink, x.cache->data(), x.cache->size());
+  if (x.cache == nullptr) {
+    // Messages with a single receiver don't carry a cache. We still need to
+    // encode the value as blob to keep the wire format uniform.
+    thread_local buffer_type scratch;
+    scratch.clear();
+    if (auto err = encode_value(sink.context(), x.content, scratch))
+      return err;
+    return write_blob(sink, scratch.data(), scratch.size());
+  }
+  auto encode = [&](buffer_type& out) {
+    return encode_value(sink.context(), x.content, out);
+  };
+  if (auto err = x.cache->get_or_encode(encode))
+    return err;
+  return write_blob(sink, x.cache->data(), x.cache->size());
+}
+
+caf::error load_node_message(caf::deserializer& source, node_message& x) {
+  uint8_t kind = 0;
+  std::string str;
+  if (auto err = source(x.ttl, kind, str))
+    return err;
+  size_t n = 0;
+  if (auto err = source.begin_sequence(n))
+    return err;
+  buffer_type buf(n);
+  if (auto err = source.apply_raw(n, buf.data()))
+    return err;
+  if (auto err = source.end_sequence())
+    return err;
+  switch (static_cast<message_kind>(kind)) {
+    case message_kind::data:
+      x.content = make_data_message(std::move(str), data{});
+      break;
+    case message_kind::command:
+      x.content = make_command_message(std::move(str), internal_command{});
+      break;
+    default:
+      return make_error(ec::invalid_tag, "invalid node message kind");
+  }
+  // Decoding the value happens lazily, since we might only relay the message.
+  x.cache = caf::make_counted<payload_cache>(std::move(buf));
+  x.packed = true;
+  return caf::none;
+}
+
+caf::error unpack(caf::execution_unit* ctx, node_message& x) {
+  if (!x.packed)
+    return caf::none;
+  BROKER_ASSERT(x.cache != nullptr);
+  auto buf = x.cache->data();
+  auto size = x.cache->size();
+  caf::binary_deserializer source{ctx, buf, size};
+  caf::error err;
+  if (!is_data_message(x))
+    err = source(get<1>(caf::get<command_message>(x.content).unshared()));
+  else if (compact_encoding::is_compact(buf, size))
+    err = compact_encoding::decode(
+      buf, size, get<1>(caf::get<data_message>(x.content).unshared()));
+  else
+    err = source(get<1>(caf::get<data_message>(x.content).unshared()));
+  if (!err)
+    x.packed = false;
+  return err;
+}
+
+data_view payload_view(const node_message& x) {
+  if (!x.packed || !is_data_message(x))
+    return {};
+  BROKER_ASSERT(x.cache != nullptr);
+  return {x.cache->data(), x.cache->size()};
+}
+
+} // namespace detail
+
+node_message make_packed_node_message(topic t,
+                                      detail::payload_cache::buffer_type buf,
+                                      uint16_t ttl) {
+  node_message result{make_data_message(std::move(t), data{}), ttl};
+  result.cache = caf::make_counted<detail::payload_cache>(std::move(buf));
+  result.packed = true;
+  return result;
+}
+
+} // namespace broker
@@ -7,6 +7,7 @@
 #include "broker/endpoint.hh"
 #include "broker/message.hh"
 #include "broker/topic.hh"
+#include "broker/zeek.hh"
 
 using namespace caf;
 
@@ -27,6 +28,24 @@ struct publisher_worker_state {
   size_t counter = 0;
   bool shutting_down = false;
 
+  /// Maximum number of values per `zeek::Batch`. Batching is off when 0.
+  size_t max_batch_size = 0;
+
+  /// Maximum time a value waits in `pending` before we flush the batch.
+  timespan max_batch_delay;
+
+  /// Values for the next batch.
+  vector pending;
+
+  /// Topic of the values in `pending`.
+  topic pending_topic;
+
+  /// Signals that a delayed `flush` message is on its way.
+  bool flush_scheduled = false;
+
+  /// Signals that the next batch goes out regardless of its size.
+  bool flush_now = false;
+
   static const char* name;
 
   void tick() {
@@ -44,29 +63,77 @@ struct publisher_worker_state {
            ? std::accumulate(buf.begin(), buf.end(), size_t{0}) / buf.size()
            : 0;
   }
+
+  void add_to_batch(data_message&& x) {
+    if (pending.empty())
+      pending_topic = get_topic(x);
+    pending.emplace_back(std::move(get<1>(x.unshared())));
+  }
+
+  data_message make_batch() {
+    auto batch = zeek::Batch{std::move(pending)};
+    pending = vector{};
+    pending.reserve(max_batch_size);
+    return make_data_message(pending_topic, batch.move_data());
+  }
 };
 
 const char* publisher_worker_state::name = "publisher_worker";
 
 behavior publisher_worker(stateful_actor<publisher_worker_state>* self,
-                          endpoint* ep,
+                          caf::actor core,
                           detail::shared_publisher_queue_ptr<> qptr) {
   auto handler = self->make_source(
-    ep->core(),
+    std::move(core),
     [](unit_t&) {
       // nop
     },
     [=](unit_t&, downstream<data_message>& out, size_t num) {
       auto& st = self->state;
-      auto consumed = qptr->consume(num, [&](data_message&& x) {
-        out.push(std::move(x));
-      });
-      if (consumed > 0) {
-        st.counter += consumed;
+      if (st.max_batch_size == 0) {
+        // Ship values that we have collected while batching was on.
+        if (!st.pending.empty()) {
+          out.push(st.make_batch());
+          if (--num == 0)
+            return;
+        }
+        auto consumed = qptr->consume(num, [&](data_message&& x) {
+          out.push(std::move(x));
+        });
+        if (consumed > 0) {
+          st.counter += consumed;
+        }
+        return;
+      }
+      // Each batch consumes one unit of credit.
+      size_t emitted = 0;
+      auto capacity = num * st.max_batch_size;
+      auto max_values = capacity > st.pending.size()
+                          ? capacity - st.pending.size()
+                          : size_t{0};
+      auto add = [&](data_message&& x) {
+        st.add_to_batch(std::move(x));
+        if (st.pending.size() >= st.max_batch_size) {
+          out.push(st.make_batch());
+          ++emitted;
+        }
+      };
+      if (max_values > 0)
+        st.counter += qptr->consume(max_values, add);
+      if (st.pending.empty())
+        return;
+      if ((st.flush_now || st.shutting_down) && emitted < num) {
+        out.push(st.make_batch());
+        st.flush_now = false;
+      } else if (!st.flush_scheduled) {
+        st.flush_scheduled = true;
+        self->delayed_send(self, st.max_batch_delay, atom::flush::value);
       }
     },
     [=](const unit_t&) {
-      return self->state.shutting_down && qptr->buffer_size() == 0;
+      auto& st = self->state;
+      return st.shutting_down && qptr->buffer_size() == 0
+             && st.pending.empty();
     }
   ).ptr();
   //self->delayed_send(self, std::chrono::seconds(1), atom::tick::value);
@@ -75,6 +142,26 @@ behavior publisher_worker(stateful_actor<publisher_worker_state>* self,
       if (handler->generate_messages())
         handler->push();
     },
+    [=](atom::batching, size_t max_size, timespan max_delay) {
+      auto& st = self->state;
+      st.max_batch_size = max_size;
+      st.max_batch_delay = max_delay;
+      // Ship values that we have collected for the previous configuration.
+      if (!st.pending.empty()) {
+        st.flush_now = true;
+        if (handler->generate_messages())
+          handler->push();
+      }
+    },
+    [=](atom::flush) {
+      auto& st = self->state;
+      st.flush_scheduled = false;
+      if (st.pending.empty())
+        return;
+      st.flush_now = true;
+      if (handler->generate_messages())
+        handler->push();
+    },
     [=](atom::tick) {
       auto& st = self->state;
       st.tick();
@@ -96,7 +183,7 @@ behavior publisher_worker(stateful_actor<publisher_worker_state>* self,
 publisher::publisher(endpoint& ep, topic t)
   : drop_on_destruction_(false),
     queue_(detail::make_shared_publisher_queue(queue_size)),
-    worker_(ep.system().spawn(publisher_worker, &ep, queue_)),
+    worker_(ep.system().spawn(publisher_worker, ep.core(t), queue_)),
     topic_(std::move(t)) {
   // nop
 }
@@ -135,6 +222,10 @@ void publisher::drop_all_on_destruction() {
   drop_on_destruction_ = true;
 }
 
+void publisher::set_batching(size_t max_size, timespan max_delay) {
+  anon_send(worker_, atom::batching::value, max_size, max_delay);
+}
+
 void publisher::publish(data x) {
   BROKER_INFO("publishing" << std::make_pair(topic_, x));
   if (queue_->produce(topic_, std::move(x)))
@@ -20,6 +20,12 @@ const char* to_string(sc code) noexcept {
       return "peer_removed";
     case sc::peer_lost:
       return "peer_lost";
+    case sc::peer_buffering:
+      return "peer_buffering";
+    case sc::peer_buffer_overflow:
+      return "peer_buffer_overflow";
+    case sc::peer_buffer_drained:
+      return "peer_buffer_drained";
   }
 }
 
@@ -34,6 +40,9 @@ bool convert(const std::string& str, sc& code) noexcept {
   BROKER_SC_FROM_STRING(peer_added)
   BROKER_SC_FROM_STRING(peer_removed)
   BROKER_SC_FROM_STRING(peer_lost)
+  BROKER_SC_FROM_STRING(peer_buffering)
+  BROKER_SC_FROM_STRING(peer_buffer_overflow)
+  BROKER_SC_FROM_STRING(peer_buffer_drained)
   return false;
 }
 
@@ -63,6 +72,9 @@ const std::string* status::message() const {
     case sc::peer_added:
     case sc::peer_removed:
     case sc::peer_lost:
+    case sc::peer_buffering:
+    case sc::peer_buffer_overflow:
+    case sc::peer_buffer_drained:
       return &context_.get_as<std::string>(1);
   }
 }
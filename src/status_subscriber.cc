@@ -10,7 +10,7 @@
 
 #define BROKER_RETURN_CONVERTED_MSG()                                          \
   auto& t = get_topic(msg);                                                    \
-  if (t == topics::errors) {                                                   \
+  if (is_errors(t.flags())) {                                                  \
     if (auto value = to<error>(get_data(msg)))                                 \
       return value_type{std::move(*value)};                                    \
     BROKER_WARNING("received malformed error");                                \
@@ -22,7 +22,7 @@
 
 #define BROKER_APPEND_CONVERTED_MSG()                                          \
   auto& t = get_topic(msg);                                                    \
-  if (t == topics::errors) {                                                   \
+  if (is_errors(t.flags())) {                                                  \
     if (auto value = to<error>(get_data(msg)))                                 \
       result.emplace_back(std::move(*value));                                  \
     else                                                                       \
@@ -13,6 +13,7 @@
 #include "broker/store.hh"
 #include "broker/expected.hh"
 #include "broker/internal_command.hh"
+#include "broker/detail/clone_view.hh"
 #include "broker/detail/flare_actor.hh"
 
 using namespace broker::detail;
@@ -107,10 +108,14 @@ const std::string& store::name() const {
 }
 
 expected<data> store::exists(data key) const {
+  if (view_)
+    return view_->exists(key);
   return request<data>(atom::exists::value, std::move(key));
 }
 
 expected<data> store::get(data key) const {
+  if (view_)
+    return view_->get(key);
   return request<data>(atom::get::value, std::move(key));
 }
 
@@ -131,6 +136,9 @@ expected<data> store::put_unique(data key, data val, optional<timespan> expiry)
     [&](data& x, request_id) {
       res = std::move(x);
     },
+    [&](caf::error& e, request_id) {
+      res = std::move(e);
+    },
     [&](atom::tick) {
     },
     [&](caf::error& e) {
@@ -142,10 +150,14 @@ expected<data> store::put_unique(data key, data val, optional<timespan> expiry)
 }
 
 expected<data> store::get_index_from_value(data key, data index) const {
+  if (view_)
+    return view_->get(key, index);
   return request<data>(atom::get::value, std::move(key), std::move(index));
 }
 
 expected<data> store::keys() const {
+  if (view_)
+    return view_->keys();
   return request<data>(atom::get::value, atom::keys::value);
 }
 
@@ -178,8 +190,11 @@ void store::clear() const {
             make_internal_command<clear_command>());
 }
 
-store::store(caf::actor actor, std::string name)
-  : frontend_{std::move(actor)}, name_{std::move(name)} {
+store::store(caf::actor actor, std::string name,
+             std::shared_ptr<detail::clone_view> view)
+  : frontend_{std::move(actor)},
+    name_{std::move(name)},
+    view_{std::move(view)} {
   // nop
 }
 
@@ -66,8 +66,6 @@ bool convert(const subnet& sn, std::string& str) {
 } // namespace broker
 
 size_t std::hash<broker::subnet>::operator()(const broker::subnet& v) const {
-  auto result = size_t{0};
-  broker::detail::hash_combine(result, v.network());
-  broker::detail::hash_combine(result, v.length());
-  return result;
+  auto& bytes = v.network().bytes();
+  return broker::detail::hash_bytes(bytes.data(), bytes.size(), v.length());
 }
@@ -1,18 +1,25 @@
 #include "broker/logger.hh" // Must come before any CAF include.
 #include "broker/subscriber.hh"
 
+#include <algorithm>
 #include <cstddef>
+#include <memory>
 #include <utility>
 #include <chrono>
 #include <numeric>
+#include <vector>
 
+#include <caf/actor.hpp>
 #include <caf/scheduled_actor.hpp>
 #include <caf/send.hpp>
+#include <caf/stream_manager.hpp>
+#include <caf/stream_slot.hpp>
 
 #include "broker/atoms.hh"
 #include "broker/endpoint.hh"
 #include "broker/filter_type.hh"
 #include "broker/logger.hh"
+#include "broker/zeek.hh"
 
 #include "broker/detail/assert.hh"
 
@@ -31,6 +38,16 @@ struct subscriber_worker_state {
 
   bool calculate_rate = true;
 
+  /// Replaces `zeek::Batch` messages with the messages in the batch.
+  bool unbatch = false;
+
+  /// Consumes the input streams from all cores.
+  caf::stream_manager_ptr sink;
+
+  /// Stores the handle and our slot at the sender for each input stream. With
+  /// sharding enabled, each core opens its own stream to the worker.
+  std::vector<std::pair<caf::actor, caf::stream_slot>> inputs;
+
   static const char* name;
 
   void tick() {
@@ -52,6 +69,34 @@ struct subscriber_worker_state {
 
 const char* subscriber_worker_state::name = "subscriber_worker";
 
+bool is_batch(const data_message& x) {
+  return zeek::Message::type(get_data(x)) == zeek::Message::Type::Batch;
+}
+
+/// Replaces each `zeek::Batch` in `xs` with the messages in the batch. The
+/// messages keep the topic of the batch.
+void unbatch(std::vector<data_message>& xs) {
+  if (std::none_of(xs.begin(), xs.end(), is_batch))
+    return;
+  std::vector<data_message> result;
+  result.reserve(xs.size());
+  for (auto& x : xs) {
+    if (!is_batch(x)) {
+      result.emplace_back(std::move(x));
+      continue;
+    }
+    auto& fields = get<vector>(get<1>(x.unshared()));
+    auto msgs = fields.size() > 2 ? get_if<vector>(fields[2]) : nullptr;
+    if (msgs == nullptr) {
+      result.emplace_back(std::move(x));
+      continue;
+    }
+    for (auto& msg : *msgs)
+      result.emplace_back(make_data_message(get_topic(x), std::move(msg)));
+  }
+  xs.swap(result);
+}
+
 class subscriber_sink : public stream_sink<data_message> {
 public:
   using super = stream_sink<data_message>;
@@ -78,6 +123,8 @@ protected:
     using vec_type = std::vector<data_message>;
     if (x.xs.match_elements<vec_type>()) {
       auto& xs = x.xs.get_mutable_as<vec_type>(0);
+      if (state_->unbatch)
+        unbatch(xs);
       auto xs_size = xs.size();
       state_->counter += xs_size;
       queue_->produce(xs_size, std::make_move_iterator(xs.begin()),
@@ -97,24 +144,34 @@ behavior subscriber_worker(stateful_actor<subscriber_worker_state>* self,
                            endpoint* ep,
                            detail::shared_subscriber_queue_ptr<> qptr,
                            std::vector<topic> ts, size_t max_qsize) {
-  self->send(self * ep->core(), atom::join::value, std::move(ts));
+  for (auto& core : ep->cores())
+    self->send(self * core, atom::join::value, ts);
   self->set_default_handler(skip);
+  auto add_input = [=](const endpoint::stream_type& in) {
+    BROKER_ASSERT(qptr != nullptr);
+    auto& st = self->state;
+    if (st.sink == nullptr)
+      st.sink = make_counted<subscriber_sink>(self, &st, qptr, max_qsize);
+    auto slot = st.sink->add_unchecked_inbound_path(in);
+    if (slot == invalid_stream_slot) {
+      BROKER_WARNING("failed to init stream to subscriber_worker");
+      return false;
+    }
+    auto path = st.sink->get_inbound_path(slot);
+    BROKER_ASSERT(path != nullptr);
+    st.inputs.emplace_back(actor_cast<actor>(path->hdl), path->slots.sender);
+    return true;
+  };
   return {
     [=](const endpoint::stream_type& in) {
-      BROKER_ASSERT(qptr != nullptr);
-      auto mgr = make_counted<subscriber_sink>(self, &self->state, qptr,
-                                               max_qsize);
-      auto slot = mgr->add_unchecked_inbound_path(in);
-      if (slot == invalid_stream_slot) {
-        BROKER_WARNING("failed to init stream to subscriber_worker");
+      if (!add_input(in))
         return;
-      }
-      auto path = mgr->get_inbound_path(slot);
-      BROKER_ASSERT(path != nullptr);
-      auto slot_at_sender = path->slots.sender;
       self->set_default_handler(print_and_drop);
       self->delayed_send(self, std::chrono::seconds(1), atom::tick::value);
       self->become(
+        [=](const endpoint::stream_type& in) {
+          add_input(in);
+        },
         [=](atom::resume) {
           // TODO: nop ?
           // Triggering the actor should be enough to have it check its mailbox
@@ -122,11 +179,25 @@ behavior subscriber_worker(stateful_actor<subscriber_worker_state>* self,
           // manager.
         },
         [=](atom::join a0, atom::update a1, filter_type& f) {
-          self->send(ep->core(), a0, a1, slot_at_sender, std::move(f));
+          for (auto& input : self->state.inputs)
+            self->send(input.first, a0, a1, input.second, f);
         },
         [=](atom::join a0, atom::update a1, filter_type& f, caf::actor& who) {
-          self->send(ep->core(), a0, a1, slot_at_sender, std::move(f),
-                     std::move(who));
+          auto& inputs = self->state.inputs;
+          if (inputs.size() == 1) {
+            self->send(inputs.front().first, a0, a1, inputs.front().second,
+                       std::move(f), std::move(who));
+            return;
+          }
+          // Confirm the update once all cores have applied the new filter.
+          auto pending = std::make_shared<size_t>(inputs.size());
+          auto done = [=] {
+            if (--*pending == 0)
+              self->send(who, true);
+          };
+          for (auto& input : inputs)
+            self->request(input.first, infinite, a0, a1, input.second, f)
+              .then([=] { done(); }, [=](const error&) { done(); });
         },
         [=](atom::tick) {
           auto& st = self->state;
@@ -136,6 +207,9 @@ behavior subscriber_worker(stateful_actor<subscriber_worker_state>* self,
             self->delayed_send(self, std::chrono::seconds(1),
                                atom::tick::value);
         },
+        [=](atom::batching, bool x) {
+          self->state.unbatch = x;
+        },
         [=](atom::tick, bool x) {
           auto& st = self->state;
           if (st.calculate_rate == x)
@@ -203,6 +277,10 @@ void subscriber::set_rate_calculation(bool x) {
   anon_send(worker_, atom::tick::value, x);
 }
 
+void subscriber::set_unbatching(bool x) {
+  anon_send(worker_, atom::batching::value, x);
+}
+
 void subscriber::became_not_full() {
   anon_send(worker_, atom::resume::value);
 }
@@ -4,56 +4,71 @@ namespace broker {
 
 constexpr char topic::reserved[];
 
+namespace {
+
+// Appends `rhs` to `lhs` with a separator.
+void append(std::string& lhs, const std::string& rhs) {
+  if (!rhs.empty() && rhs[0] != topic::sep && !lhs.empty())
+    lhs += topic::sep;
+  lhs += rhs;
+  if (!lhs.empty() && lhs.back() == topic::sep)
+    lhs.pop_back();
+}
+
+} // namespace
+
 std::vector<std::string> topic::split(const topic& t) {
   std::vector<std::string> result;
+  auto& str = t.string();
   std::string::size_type i = 0;
   while (i != std::string::npos) {
-    auto j = t.str_.find(sep, i);
+    auto j = str.find(sep, i);
     if (j == i) {
       ++i;
       continue;
     }
     if (j == std::string::npos)  {
-      result.push_back(t.str_.substr(i));
+      result.push_back(str.substr(i));
       break;
     }
-    result.push_back(t.str_.substr(i, j - i));
-    i = (j == t.str_.size() - 1) ? std::string::npos : j + 1;
+    result.push_back(str.substr(i, j - i));
+    i = (j == str.size() - 1) ? std::string::npos : j + 1;
   }
   return result;
 }
 
 topic topic::join(const std::vector<std::string>& components) {
-  topic result;
+  // Build the string first to avoid interning intermediate results.
+  std::string str;
   for (auto& component : components)
-    result /= component;
-  return result;
+    append(str, component);
+  return topic{std::move(str)};
 }
 
 topic& topic::operator/=(const topic& rhs) {
-  if (!rhs.str_.empty() && rhs.str_[0] != sep && !str_.empty())
-    str_ += sep;
-  str_ += rhs.str_;
-  if (!str_.empty() && str_.back() == sep)
-    str_.pop_back();
+  auto str = string();
+  append(str, rhs.string());
+  entry_ = intern(std::move(str));
   return *this;
 }
 
 const std::string& topic::string() const {
-  return str_;
+  static const std::string empty_string;
+  return entry_ ? entry_->str : empty_string;
 }
 
 bool topic::prefix_of(const topic& t) const {
-  return str_.size() <= t.str_.size()
-         && t.str_.compare(0, str_.size(), str_) == 0;
-}
-
-bool operator==(const topic& lhs, const topic& rhs) {
-  return lhs.string() == rhs.string();
+  if (entry_ == t.entry_ || entry_ == nullptr)
+    return true;
+  if (t.entry_ == nullptr)
+    return false;
+  auto& x = entry_->str;
+  auto& y = t.entry_->str;
+  return x.size() <= y.size() && y.compare(0, x.size(), x) == 0;
 }
 
 bool operator<(const topic& lhs, const topic& rhs) {
-  return lhs.string() < rhs.string();
+  return lhs != rhs && lhs.string() < rhs.string();
 }
 
 topic operator/(const topic& lhs, const topic& rhs) {
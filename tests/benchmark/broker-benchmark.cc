@@ -36,6 +36,12 @@ uint64_t max_received = 0;
 uint64_t max_in_flight = 0;
 bool server = false;
 bool verbose = false;
+bool shard_scaling = false;
+bool print_footprint = false;
+bool measure_rendering = false;
+unsigned max_shards = 8;
+size_t num_topics = 64;
+size_t num_messages = 1000000;
 
 // Global state
 size_t total_recv;
@@ -141,6 +147,105 @@ vector createEventArgs() {
     }
 }
 
+// Computes the memory footprint of a value, i.e., the size of the value itself
+// plus all bytes it allocates on the heap.
+struct footprint_visitor {
+  using result_type = size_t;
+
+  template <class T>
+  size_t operator()(const T&) const {
+    return 0;
+  }
+
+  size_t operator()(const std::string& x) const {
+    // Short strings live in the string object itself.
+    auto first = reinterpret_cast<const char*>(&x);
+    auto last = first + sizeof(x);
+    if (x.data() >= first && x.data() < last)
+      return 0;
+    return x.capacity() + 1;
+  }
+
+  size_t operator()(const enum_value& x) const {
+    return (*this)(x.name);
+  }
+
+  size_t operator()(const set& xs) const {
+    auto result = xs.capacity() * sizeof(data);
+    for (auto& x : xs)
+      result += (*this)(x);
+    return result;
+  }
+
+  size_t operator()(const table& xs) const {
+    auto result = xs.capacity() * sizeof(table::value_type);
+    for (auto& kvp : xs)
+      result += (*this)(kvp.first) + (*this)(kvp.second);
+    return result;
+  }
+
+  size_t operator()(const vector& xs) const {
+    auto result = xs.capacity() * sizeof(data);
+    for (auto& x : xs)
+      result += (*this)(x);
+    return result;
+  }
+
+  size_t operator()(const data& x) const {
+    return caf::visit(*this, x);
+  }
+};
+
+void footprint_mode() {
+  auto xs = createEventArgs();
+  size_t heap = footprint_visitor{}(xs);
+  size_t total = sizeof(vector) + heap;
+  // The largest alternatives determine sizeof(data).
+  std::cout << "sizeof(data): " << sizeof(data) << " bytes\n"
+            << "sizeof(std::string): " << sizeof(std::string) << " bytes\n"
+            << "sizeof(set): " << sizeof(set) << " bytes\n"
+            << "sizeof(table): " << sizeof(table) << " bytes\n"
+            << "sizeof(vector): " << sizeof(vector) << " bytes\n"
+            << "fields: " << xs.size() << '\n'
+            << "heap: " << heap << " bytes\n"
+            << "total: " << total << " bytes, "
+            << (static_cast<double>(total) / xs.size()) << " bytes/field"
+            << std::endl;
+}
+
+template <class F>
+void measure_render(const char* name, const data& x, F f) {
+  size_t bytes = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_messages; ++i)
+    bytes += f(x);
+  auto t1 = std::chrono::steady_clock::now();
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+  auto ns = duration_cast<nanoseconds>(t1 - t0).count();
+  std::cout << name << ": " << (static_cast<double>(ns) / num_messages)
+            << " ns/event, " << (bytes / num_messages) << " bytes/event"
+            << std::endl;
+}
+
+void render_mode() {
+  data event = createEventArgs();
+  measure_render("to_string", event, [](const data& x) {
+    return to_string(x).size();
+  });
+  std::string buf;
+  measure_render("render", event, [&](const data& x) {
+    buf.clear();
+    render(x, buf);
+    return buf.size();
+  });
+  measure_render("render_json", event, [&](const data& x) {
+    buf.clear();
+    render_json(x, buf);
+    return buf.size();
+  });
+}
+
 void send_batch(endpoint& ep, publisher& p) {
   auto name = "event_" + std::to_string(event_type);
   vector batch;
@@ -363,6 +468,56 @@ void server_mode(endpoint& ep, const std::string& iface, int port) {
   std::cout << "received stop message on /benchmark/terminate" << std::endl;
 }
 
+// Runs a server and a client endpoint in this process and measures how long it
+// takes to route `num_messages` events from the client to the server with 1, 2,
+// 4, ..., `max_shards` core shards.
+void shard_scaling_mode() {
+  auto name = "event_" + std::to_string(event_type);
+  std::vector<topic> topics;
+  for (size_t i = 0; i < num_topics; ++i)
+    topics.emplace_back("/benchmark/events/" + std::to_string(i));
+  std::vector<data> events;
+  for (size_t i = 0; i < num_topics; ++i)
+    events.emplace_back(zeek::Event(std::string(name), createEventArgs()));
+  for (unsigned shards = 1; shards <= max_shards; shards *= 2) {
+    broker_options opts;
+    opts.disable_ssl = true;
+    opts.core_shards = shards;
+    endpoint server_ep{configuration{opts}};
+    endpoint client_ep{configuration{opts}};
+    std::atomic<size_t> received{0};
+    server_ep.subscribe(
+      {"/benchmark/events"},
+      [](caf::unit_t&) {
+        // nop
+      },
+      [&](caf::unit_t&, data_message) {
+        ++received;
+      },
+      [](caf::unit_t&, const caf::error&) {
+        // nop
+      });
+    auto port = server_ep.listen("127.0.0.1", 0);
+    if (port == 0 || !client_ep.peer("127.0.0.1", port, timeout::seconds(1))) {
+      std::cerr << "*** unable to connect endpoints" << std::endl;
+      exit(1);
+    }
+    // Give the shards time to complete their handshakes.
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num_messages; ++i)
+      client_ep.publish(topics[i % num_topics], events[i % num_topics]);
+    while (received < num_messages)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    auto t1 = std::chrono::steady_clock::now();
+    using fractional_second = std::chrono::duration<double>;
+    auto secs = std::chrono::duration_cast<fractional_second>(t1 - t0).count();
+    std::cout << "shards=" << shards << " messages=" << num_messages
+              << " time=" << secs << "s rate=" << (num_messages / secs)
+              << " ev/s" << std::endl;
+  }
+}
+
 struct config : configuration {
   using super = configuration;
 
@@ -380,7 +535,20 @@ struct config : configuration {
       .add(max_received, "max-received,m", "stop benchmark after given count")
       .add(max_in_flight, "max-in-flight,f", "report when exceeding this count")
       .add(server, "server", "run in server mode")
-      .add(verbose, "verbose", "enable status output");
+      .add(verbose, "verbose", "enable status output")
+      .add(print_footprint, "footprint",
+           "print the memory footprint of a single event and exit")
+      .add(measure_rendering, "render",
+           "measure rendering a single event as string and exit")
+      .add(shard_scaling, "shard-scaling",
+           "measure local throughput with an increasing number of core shards")
+      .add(max_shards, "max-shards",
+           "maximum number of core shards for --shard-scaling (default: 8)")
+      .add(num_topics, "num-topics",
+           "number of distinct topics for --shard-scaling (default: 64)")
+      .add(num_messages, "num-messages",
+           "messages per run for --shard-scaling and --render "
+           "(default: 1000000)");
   }
 
   using super::init;
@@ -410,6 +578,28 @@ int main(int argc, char** argv) {
   }
   if (cfg.cli_helptext_printed)
     return EXIT_SUCCESS;
+  if (print_footprint) {
+    footprint_mode();
+    return EXIT_SUCCESS;
+  }
+  if (measure_rendering) {
+    if (num_messages == 0) {
+      std::cerr << "*** num-messages must be positive\n\n";
+      usage(cfg, argv[0]);
+      return EXIT_FAILURE;
+    }
+    render_mode();
+    return EXIT_SUCCESS;
+  }
+  if (shard_scaling) {
+    if (max_shards == 0 || num_topics == 0) {
+      std::cerr << "*** max-shards and num-topics must be positive\n\n";
+      usage(cfg, argv[0]);
+      return EXIT_FAILURE;
+    }
+    shard_scaling_mode();
+    return EXIT_SUCCESS;
+  }
   if (cfg.remainder.size() != 1) {
     std::cerr << "*** too many arguments\n\n";
     usage(cfg, argv[0]);
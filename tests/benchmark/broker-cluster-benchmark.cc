@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <iostream>
+#include <map>
+#include <set>
 #include <string>
 #include <thread>
 
@@ -174,7 +177,9 @@ struct config : actor_system_config {
       .add<bool>("generate-config",
                  "creates a config file from given recording directories")
       .add<string_list>("excluded-nodes,e",
-                        "excludes given nodes from the setup");
+                        "excludes given nodes from the setup")
+      .add<caf::timespan>("store-probe-interval",
+                          "time between two updates of master stores");
     set("scheduler.max-threads", 1);
     set("logger.file-verbosity", caf::atom("quiet"));
     broker::configuration::add_message_types(*this);
@@ -238,6 +243,17 @@ struct node {
 
   /// Stores the CAF log level for this node.
   caf::atom_value log_verbosity = caf::atom("quiet");
+
+  /// Optionally stores the name of a master store. The node periodically
+  /// writes probes to the master while publishing its generator file.
+  std::string master_store;
+
+  /// Optionally stores the name of a clone store. The node measures how long
+  /// probes take from the master until arriving here.
+  std::string clone_store;
+
+  /// Stores whether store commands overtake data messages to peers.
+  bool priority_lanes = false;
 };
 
 bool is_sender(const node& x) {
@@ -314,9 +330,18 @@ expected<node> make_node(const string& name, const caf::settings& parameters) {
   SET_FIELD(num_outputs, optional);
   SET_FIELD(inputs_by_node, optional);
   SET_FIELD(log_verbosity, optional);
+  SET_FIELD(master_store, optional);
+  SET_FIELD(clone_store, optional);
+  SET_FIELD(priority_lanes, optional);
   if (!result.generator_file.empty() && !is_file(result.generator_file))
     return make_error(caf::sec::invalid_argument, result.name,
                       "generator file does not exist", result.generator_file);
+  if (!result.master_store.empty() && result.generator_file.empty())
+    return make_error(caf::sec::invalid_argument, result.name,
+                      "master stores require a generator file");
+  if (!result.clone_store.empty() && result.num_inputs == 0)
+    return make_error(caf::sec::invalid_argument, result.name,
+                      "clone stores require num-inputs");
   if (!result.inputs_by_node.empty()) {
     auto plus = [](size_t n, const inputs_by_node_map::value_type& kvp) {
       return n + kvp.second;
@@ -337,6 +362,7 @@ struct node_manager_state {
   };
   broker::detail::generator_file_reader_ptr generator;
   std::vector<caf::actor> children;
+  broker::store store;
 
   node_manager_state() {
     // nop
@@ -351,6 +377,7 @@ struct node_manager_state {
     this_node = this_node_ptr;
     broker::broker_options opts;
     opts.forward = this_node_ptr->forward;
+    opts.priority_lanes = this_node_ptr->priority_lanes;
     opts.disable_ssl = true;
     opts.ignore_broker_conf = true; // Make sure no one messes with our setup.
     broker::configuration cfg{opts};
@@ -450,16 +477,113 @@ void generator(caf::stateful_actor<generator_state>* self, node* this_node,
   }
 }
 
+// -- store probes -------------------------------------------------------------
+
+/// Returns the current time as `count` for writing it into a data store.
+broker::count probe_timestamp() {
+  auto t = std::chrono::steady_clock::now().time_since_epoch();
+  return static_cast<broker::count>(duration_cast<caf::timespan>(t).count());
+}
+
+struct prober_state {
+  ~prober_state() {
+    verbose::println(this_node->name, " sent ", sent, " store probes");
+  }
+
+  node* this_node;
+  size_t sent = 0;
+  static const char* name;
+};
+
+const char* prober_state::name = "prober";
+
+/// Periodically writes the current time to a master store.
+caf::behavior prober(caf::stateful_actor<prober_state>* self, node* this_node,
+                     broker::store store, caf::timespan interval) {
+  self->state.this_node = this_node;
+  self->send(self, broker::atom::tick::value);
+  return {
+    [=](broker::atom::tick) {
+      store.put("probe", probe_timestamp());
+      ++self->state.sent;
+      self->delayed_send(self, interval, broker::atom::tick::value);
+    },
+  };
+}
+
+struct probe_observer_state {
+  ~probe_observer_state() {
+    if (latencies.empty()) {
+      out::println(this_node->name, " (store latency): no probes received");
+      return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto at = [&](double percentile) {
+      auto i = static_cast<size_t>(percentile * (latencies.size() - 1));
+      return duration_cast<fractional_seconds>(latencies[i]);
+    };
+    out::println(this_node->name, " (store latency): ", latencies.size(),
+                 " probes, median ", at(0.5), ", p99 ", at(0.99), ", max ",
+                 at(1.0));
+  }
+
+  node* this_node;
+  std::vector<caf::timespan> latencies;
+  static const char* name;
+};
+
+const char* probe_observer_state::name = "probe_observer";
+
+/// Receives updates for a clone store in parallel to the clone itself and
+/// records how long each probe took from the master to this node.
+caf::behavior probe_observer(caf::stateful_actor<probe_observer_state>* self,
+                             node* this_node, caf::actor core) {
+  self->state.this_node = this_node;
+  std::vector<broker::topic> filter{broker::topic{this_node->clone_store}
+                                    / broker::topics::clone_suffix};
+  self->send(self * core, broker::atom::join::value, broker::atom::store::value,
+             std::move(filter));
+  return {
+    [=](caf::stream<broker::command_message> in) {
+      self->make_sink(
+        in,
+        [](caf::unit_t&) {
+          // nop
+        },
+        [=](caf::unit_t&, std::vector<broker::command_message>& xs) {
+          auto now = probe_timestamp();
+          for (auto& x : xs) {
+            auto cmd = caf::get_if<broker::put_command>(&get_command(x));
+            if (cmd == nullptr)
+              continue;
+            if (auto t0 = broker::get_if<broker::count>(cmd->value))
+              self->state.latencies.emplace_back(now - *t0);
+          }
+        });
+    },
+  };
+}
+
+// -- benchmark modes ----------------------------------------------------------
+
 void run_send_mode(node_manager_actor* self, caf::actor observer) {
   auto this_node = self->state.this_node;
   verbose::println(this_node->name, " starts publishing");
+  caf::actor p;
+  if (!this_node->master_store.empty()) {
+    auto interval = get_or(self->system().config(), "store-probe-interval",
+                           caf::timespan{std::chrono::milliseconds(10)});
+    p = self->spawn(prober, this_node, self->state.store, interval);
+  }
   auto t0 = std::chrono::steady_clock::now();
   auto g = self->spawn(generator, this_node, self->state.ep.core(),
                        std::move(self->state.generator));
-  g->attach_functor([this_node, t0, observer]() mutable {
+  g->attach_functor([this_node, t0, observer, p]() mutable {
     auto t1 = std::chrono::steady_clock::now();
     anon_send(observer, broker::atom::ok::value, broker::atom::write::value,
               this_node->name, duration_cast<caf::timespan>(t1 - t0));
+    if (p)
+      anon_send_exit(p, caf::exit_reason::user_shutdown);
   });
 }
 
@@ -558,6 +682,17 @@ caf::behavior consumer(caf::stateful_actor<consumer_state>* self,
 void run_receive_mode(node_manager_actor* self, caf::actor observer) {
   auto this_node = self->state.this_node;
   auto core = self->state.ep.core();
+  if (!this_node->clone_store.empty()) {
+    // All masters are up and running at this point.
+    if (auto res = self->state.ep.attach_clone(this_node->clone_store)) {
+      self->state.store = std::move(*res);
+      auto o = self->spawn(probe_observer, this_node, core);
+      self->state.children.emplace_back(o);
+    } else {
+      err::println(this_node->name, " failed to attach clone ",
+                   this_node->clone_store, ": ", res.error());
+    }
+  }
   auto c = self->spawn(consumer, this_node, core, observer);
   self->state.children.emplace_back(c);
 }
@@ -642,6 +777,13 @@ caf::behavior node_manager(node_manager_actor* self, node* this_node) {
           }
         }
       }
+      if (!this_node->master_store.empty()) {
+        auto res = st.ep.attach_master(this_node->master_store,
+                                       broker::backend::memory);
+        if (!res)
+          return std::move(res.error());
+        st.store = std::move(*res);
+      }
       if (is_sender(*this_node)) {
         using broker::detail::make_generator_file_reader;
         st.generator = make_generator_file_reader(this_node->generator_file);
@@ -661,6 +803,7 @@ caf::behavior node_manager(node_manager_actor* self, node* this_node) {
     [=](broker::atom::shutdown) -> caf::result<caf::atom_value> {
       for (auto& child : self->state.children)
         self->send_exit(child, caf::exit_reason::user_shutdown);
+      self->state.store = broker::store{};
       // Tell broker to shutdown. This is a blocking function call.
       self->state.ep.shutdown();
       verbose::println(this_node->name, " down");
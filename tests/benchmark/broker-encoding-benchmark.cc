@@ -0,0 +1,168 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+
+#include "broker/configuration.hh"
+#include "broker/data.hh"
+#include "broker/detail/compact_encoding.hh"
+#include "broker/detail/generator_file_reader.hh"
+#include "broker/message.hh"
+
+using namespace broker;
+
+namespace {
+
+size_t num_rounds = 10;
+
+using clock_type = std::chrono::steady_clock;
+
+using buffer_type = caf::binary_serializer::container_type;
+
+struct config : configuration {
+  using super = configuration;
+
+  config() : configuration(skip_init) {
+    opt_group{custom_options_, "global"}.add(
+      num_rounds, "rounds,r",
+      "number of times to encode and decode all values (default: 10)");
+  }
+
+  using super::init;
+
+  std::string help_text() const {
+    return custom_options_.help_text();
+  }
+};
+
+/// Encodes and decodes values in one of the supported formats.
+struct format {
+  const char* name;
+  void (*encode)(const data&, buffer_type&);
+  bool (*decode)(const buffer_type&, data&);
+};
+
+void binary_encode(const data& x, buffer_type& buf) {
+  caf::binary_serializer sink{nullptr, buf};
+  if (auto err = sink(const_cast<data&>(x))) {
+    std::cerr << "*** serialization failed\n";
+    std::abort();
+  }
+}
+
+bool binary_decode(const buffer_type& buf, data& x) {
+  caf::binary_deserializer source{nullptr, buf};
+  return !source(x);
+}
+
+void compact_encode(const data& x, buffer_type& buf) {
+  detail::compact_encoding::encode(x, buf);
+}
+
+bool compact_decode(const buffer_type& buf, data& x) {
+  return !detail::compact_encoding::decode(buf.data(), buf.size(), x);
+}
+
+template <class F>
+double measure(F f) {
+  auto t0 = clock_type::now();
+  f();
+  auto t1 = clock_type::now();
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+  return static_cast<double>(duration_cast<nanoseconds>(t1 - t0).count());
+}
+
+void run(const format& fmt, const std::vector<data>& xs, size_t baseline) {
+  // Encode each value into its own buffer, just like a node message payload.
+  std::vector<buffer_type> bufs(xs.size());
+  size_t total = 0;
+  for (size_t i = 0; i < xs.size(); ++i) {
+    fmt.encode(xs[i], bufs[i]);
+    total += bufs[i].size();
+  }
+  auto encode_ns = measure([&] {
+    buffer_type buf;
+    for (size_t round = 0; round < num_rounds; ++round)
+      for (auto& x : xs) {
+        buf.clear();
+        fmt.encode(x, buf);
+      }
+  });
+  auto decode_ns = measure([&] {
+    data x;
+    for (size_t round = 0; round < num_rounds; ++round)
+      for (auto& buf : bufs)
+        if (!fmt.decode(buf, x)) {
+          std::cerr << "*** deserialization failed\n";
+          std::abort();
+        }
+  });
+  auto n = static_cast<double>(xs.size() * num_rounds);
+  std::cout << "-- " << fmt.name << '\n'
+            << "size: " << total << " bytes, "
+            << (static_cast<double>(total) / xs.size()) << " bytes/value";
+  if (baseline > 0)
+    std::cout << ", " << (100.0 * total / baseline) << "% of binary";
+  std::cout << '\n'
+            << "encoding: " << (encode_ns / n) << " ns/value\n"
+            << "decoding: " << (decode_ns / n) << " ns/value" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  config cfg;
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << "\n\n" << cfg.help_text();
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed)
+    return EXIT_SUCCESS;
+  if (cfg.remainder.empty() || num_rounds == 0) {
+    std::cerr << "*** usage: broker-encoding-benchmark [options] FILE...\n\n"
+              << cfg.help_text();
+    return EXIT_FAILURE;
+  }
+  std::vector<data> xs;
+  for (auto& fname : cfg.remainder) {
+    auto reader = detail::make_generator_file_reader(fname);
+    if (reader == nullptr) {
+      std::cerr << "*** unable to open generator file " << fname << '\n';
+      return EXIT_FAILURE;
+    }
+    detail::generator_file_reader::value_type x;
+    while (!reader->at_end()) {
+      if (auto err = reader->read(x)) {
+        std::cerr << "*** unable to read generator file " << fname << '\n';
+        return EXIT_FAILURE;
+      }
+      if (is_data_message(x))
+        xs.emplace_back(get_data(caf::get<data_message>(x)));
+    }
+  }
+  if (xs.empty()) {
+    std::cerr << "*** no data messages in the generator file(s)\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << xs.size() << " values, " << num_rounds << " rounds"
+            << std::endl;
+  format binary{"binary", binary_encode, binary_decode};
+  format compact{"compact", compact_encode, compact_decode};
+  buffer_type tmp;
+  size_t baseline = 0;
+  for (auto& x : xs) {
+    tmp.clear();
+    binary_encode(x, tmp);
+    baseline += tmp.size();
+  }
+  run(binary, xs, 0);
+  run(compact, xs, baseline);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "broker/configuration.hh"
+#include "broker/detail/filter_index.hh"
+#include "broker/detail/prefix_matcher.hh"
+#include "broker/filter_type.hh"
+#include "broker/topic.hh"
+
+using namespace broker;
+
+namespace {
+
+size_t num_paths = 20;
+size_t num_prefixes = 200;
+size_t num_topics = 50;
+size_t num_messages = 1000000;
+
+using clock_type = std::chrono::steady_clock;
+
+struct config : configuration {
+  using super = configuration;
+
+  config() : configuration(skip_init) {
+    opt_group{custom_options_, "global"}
+      .add(num_paths, "paths,p", "number of subscribers (default: 20)")
+      .add(num_prefixes, "prefixes,f",
+           "number of topic prefixes per subscriber (default: 200)")
+      .add(num_topics, "topics,t",
+           "number of distinct topics in the workload (default: 50)")
+      .add(num_messages, "messages,m",
+           "number of routed messages (default: 1000000)");
+  }
+
+  using super::init;
+
+  std::string help_text() const {
+    return custom_options_.help_text();
+  }
+};
+
+// Generates Zeek-like subscriptions: each path subscribes to its own node
+// topic plus a set of event prefixes shared with other paths.
+std::vector<filter_type> make_filters() {
+  std::vector<filter_type> result;
+  for (size_t i = 0; i < num_paths; ++i) {
+    filter_type xs;
+    xs.emplace_back("/zeek/node/worker-" + std::to_string(i) + "/");
+    for (size_t j = 1; j < num_prefixes; ++j)
+      xs.emplace_back("/zeek/events/" + std::to_string((i + j) % num_prefixes)
+                      + "/");
+    result.emplace_back(std::move(xs));
+  }
+  return result;
+}
+
+std::vector<topic> make_topics() {
+  std::vector<topic> result;
+  for (size_t i = 0; i < num_topics; ++i)
+    result.emplace_back("/zeek/events/" + std::to_string(i * 7 % num_prefixes)
+                        + "/Cluster::hello");
+  return result;
+}
+
+template <class F>
+void run(const char* name, F f) {
+  auto t0 = clock_type::now();
+  size_t hits = 0;
+  for (size_t i = 0; i < num_messages; ++i)
+    hits += f(i);
+  auto t1 = clock_type::now();
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+  auto ns = duration_cast<nanoseconds>(t1 - t0).count();
+  std::cout << name << ": " << (ns / 1e6) << " ms, "
+            << (static_cast<double>(ns) / num_messages) << " ns/msg, " << hits
+            << " deliveries" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  config cfg;
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << "\n\n" << cfg.help_text();
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed)
+    return EXIT_SUCCESS;
+  if (num_paths == 0 || num_prefixes == 0 || num_topics == 0) {
+    std::cerr << "*** paths, prefixes and topics must be positive\n\n"
+              << cfg.help_text();
+    return EXIT_FAILURE;
+  }
+  auto filters = make_filters();
+  auto topics = make_topics();
+  std::cout << num_paths << " paths, " << num_prefixes
+            << " prefixes per path, " << num_topics << " topics, "
+            << num_messages << " messages" << std::endl;
+  run("linear prefix_matcher", [&](size_t i) {
+    detail::prefix_matcher f;
+    auto& t = topics[i % topics.size()];
+    size_t result = 0;
+    for (auto& filter : filters)
+      if (f(filter, t))
+        ++result;
+    return result;
+  });
+  detail::filter_index<uint16_t> index;
+  for (size_t i = 0; i < filters.size(); ++i)
+    index.update(static_cast<uint16_t>(i), filters[i]);
+  run("filter_index", [&](size_t i) {
+    return index.match(topics[i % topics.size()]).size();
+  });
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "broker/configuration.hh"
+#include "broker/data.hh"
+
+using namespace broker;
+
+namespace {
+
+size_t num_keys = 100000;
+size_t num_lookups = 1000000;
+
+using clock_type = std::chrono::steady_clock;
+
+struct config : configuration {
+  using super = configuration;
+
+  config() : configuration(skip_init) {
+    opt_group{custom_options_, "global"}
+      .add(num_keys, "keys,k", "number of distinct keys (default: 100000)")
+      .add(num_lookups, "lookups,l",
+           "number of hash computations and lookups (default: 1000000)");
+  }
+
+  using super::init;
+
+  std::string help_text() const {
+    return custom_options_.help_text();
+  }
+};
+
+// Mimics the hash function prior to wyhash-style mixing: a
+// boost-style combine step and hashing addresses one byte at a time.
+struct legacy_hasher {
+  using result_type = size_t;
+
+  template <class T>
+  static void combine(size_t& seed, const T& x) {
+    seed ^= x + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+
+  template <class T>
+  result_type operator()(const T& x) const {
+    return std::hash<T>{}(x);
+  }
+
+  result_type operator()(const address& x) const {
+    size_t result = 0;
+    for (auto byte : x.bytes())
+      combine(result, std::hash<uint8_t>{}(byte));
+    return result;
+  }
+
+  result_type operator()(const port& x) const {
+    size_t result = 0;
+    combine(result, std::hash<port::number_type>{}(x.number()));
+    combine(result, static_cast<size_t>(x.type()));
+    return result;
+  }
+
+  result_type operator()(const vector& xs) const {
+    size_t result = 0;
+    for (auto& x : xs)
+      combine(result, (*this)(x));
+    combine(result, xs.size());
+    return result;
+  }
+
+  result_type operator()(const data& x) const {
+    size_t result = 0;
+    combine(result, x.get_data().index());
+    combine(result, caf::visit(*this, x));
+    return result;
+  }
+};
+
+struct legacy_hash {
+  size_t operator()(const data& x) const {
+    return legacy_hasher{}(x);
+  }
+};
+
+address make_address(std::minstd_rand& rng) {
+  auto ip = static_cast<uint32_t>(rng());
+  return {&ip, address::family::ipv4, address::byte_order::host};
+}
+
+port make_port(std::minstd_rand& rng) {
+  return {static_cast<port::number_type>(rng() % 65536), port::protocol::tcp};
+}
+
+// Mimics the conn_id records that Zeek uses as table keys.
+std::vector<data> make_keys() {
+  std::minstd_rand rng{42};
+  std::vector<data> result;
+  result.reserve(num_keys);
+  for (size_t i = 0; i < num_keys; ++i)
+    result.emplace_back(vector{make_address(rng), make_port(rng),
+                               make_address(rng), make_port(rng)});
+  return result;
+}
+
+template <class F>
+void run(const char* name, F f) {
+  auto t0 = clock_type::now();
+  size_t sum = 0;
+  for (size_t i = 0; i < num_lookups; ++i)
+    sum += f(i);
+  auto t1 = clock_type::now();
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+  auto ns = duration_cast<nanoseconds>(t1 - t0).count();
+  std::cout << name << ": " << (ns / 1e6) << " ms, "
+            << (static_cast<double>(ns) / num_lookups) << " ns/op"
+            << " (checksum " << sum << ')' << std::endl;
+}
+
+template <class Hash>
+void run_lookups(const char* name, const std::vector<data>& keys,
+                 const std::vector<data>& probes) {
+  std::unordered_map<data, count, Hash> xs;
+  for (size_t i = 0; i < keys.size(); ++i)
+    xs.emplace(keys[i], i);
+  run(name, [&](size_t i) {
+    return xs.count(probes[(i * 7919) % probes.size()]);
+  });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  config cfg;
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << "\n\n" << cfg.help_text();
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed)
+    return EXIT_SUCCESS;
+  if (num_keys == 0) {
+    std::cerr << "*** number of keys must be positive\n\n" << cfg.help_text();
+    return EXIT_FAILURE;
+  }
+  auto keys = make_keys();
+  auto key = [&](size_t i) -> const data& {
+    return keys[(i * 7919) % keys.size()];
+  };
+  std::cout << "-- hashing" << std::endl;
+  run("legacy", [&](size_t i) { return legacy_hash{}(key(i)); });
+  run("current", [&](size_t i) { return key(i).hash(); });
+  std::cout << "-- lookups" << std::endl;
+  run_lookups<legacy_hash>("legacy", keys, make_keys());
+  run_lookups<std::hash<data>>("current", keys, make_keys());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,236 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+
+#include "broker/configuration.hh"
+#include "broker/data.hh"
+
+using namespace broker;
+
+namespace {
+
+size_t num_entries = 10000;
+size_t num_lookups = 1000000;
+size_t num_rounds = 100;
+
+using clock_type = std::chrono::steady_clock;
+
+using buffer_type = caf::binary_serializer::container_type;
+
+struct config : configuration {
+  using super = configuration;
+
+  config() : configuration(skip_init) {
+    opt_group{custom_options_, "global"}
+      .add(num_entries, "entries,e",
+           "number of entries per container (default: 10000)")
+      .add(num_lookups, "lookups,l", "number of lookups (default: 1000000)")
+      .add(num_rounds, "rounds,r",
+           "number of constructions and serializations (default: 100)");
+  }
+
+  using super::init;
+
+  std::string help_text() const {
+    return custom_options_.help_text();
+  }
+};
+
+/// Counts the bytes that a node-based container allocates for its nodes.
+size_t allocated_bytes = 0;
+
+template <class T>
+struct counting_allocator {
+  using value_type = T;
+
+  counting_allocator() = default;
+
+  template <class U>
+  counting_allocator(const counting_allocator<U>&) {
+    // nop
+  }
+
+  T* allocate(size_t n) {
+    allocated_bytes += n * sizeof(T);
+    return std::allocator<T>{}.allocate(n);
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    allocated_bytes -= n * sizeof(T);
+    std::allocator<T>{}.deallocate(ptr, n);
+  }
+};
+
+template <class T, class U>
+bool operator==(const counting_allocator<T>&, const counting_allocator<U>&) {
+  return true;
+}
+
+template <class T, class U>
+bool operator!=(const counting_allocator<T>&, const counting_allocator<U>&) {
+  return false;
+}
+
+using std_set = std::set<data, std::less<data>, counting_allocator<data>>;
+
+using std_table = std::map<data, data, std::less<data>,
+                           counting_allocator<std::pair<const data, data>>>;
+
+// Mimics a Zeek table that maps hosts to connection records.
+std::vector<std::pair<data, data>> make_entries() {
+  std::minstd_rand rng{42};
+  std::vector<std::pair<data, data>> result;
+  result.reserve(num_entries);
+  for (size_t i = 0; i < num_entries; ++i) {
+    auto ip = static_cast<uint32_t>(rng());
+    address key{&ip, address::family::ipv4, address::byte_order::host};
+    vector value{count{i}, port{static_cast<port::number_type>(rng() % 65536),
+                                port::protocol::tcp},
+                 "C" + std::to_string(rng()), timestamp{}};
+    result.emplace_back(std::move(key), std::move(value));
+  }
+  return result;
+}
+
+template <class F>
+void run(const char* name, size_t n, F f) {
+  auto t0 = clock_type::now();
+  size_t hits = 0;
+  for (size_t i = 0; i < n; ++i)
+    hits += f(i);
+  auto t1 = clock_type::now();
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+  auto ns = duration_cast<nanoseconds>(t1 - t0).count();
+  std::cout << name << ": " << (ns / 1e6) << " ms, "
+            << (static_cast<double>(ns) / n) << " ns/op, " << hits << " hits"
+            << std::endl;
+}
+
+template <class T>
+buffer_type serialize(T& xs) {
+  buffer_type buf;
+  caf::binary_serializer sink{nullptr, buf};
+  if (auto err = sink(xs)) {
+    std::cerr << "*** serialization failed\n";
+    std::abort();
+  }
+  return buf;
+}
+
+template <class T>
+size_t deserialize(const buffer_type& buf) {
+  T xs;
+  caf::binary_deserializer source{nullptr, buf};
+  if (auto err = source(xs)) {
+    std::cerr << "*** deserialization failed\n";
+    std::abort();
+  }
+  return xs.size();
+}
+
+template <class Table>
+void run_table(const char* name,
+               const std::vector<std::pair<data, data>>& entries,
+               size_t footprint(const Table&)) {
+  std::cout << "-- " << name << std::endl;
+  run("construction", num_rounds, [&](size_t) {
+    Table xs;
+    for (auto& kvp : entries)
+      xs.emplace(kvp.first, kvp.second);
+    return xs.size();
+  });
+  Table xs;
+  for (auto& kvp : entries)
+    xs.emplace(kvp.first, kvp.second);
+  run("lookup", num_lookups, [&](size_t i) {
+    return xs.count(entries[(i * 7919) % entries.size()].first);
+  });
+  run("iteration", num_rounds, [&](size_t) {
+    size_t result = 0;
+    for (auto& kvp : xs)
+      result += is<vector>(kvp.second) ? 1 : 0;
+    return result;
+  });
+  auto buf = serialize(xs);
+  run("serialization", num_rounds,
+      [&](size_t) { return serialize(xs).size() == buf.size() ? 1 : 0; });
+  run("deserialization", num_rounds,
+      [&](size_t) { return deserialize<Table>(buf); });
+  std::cout << "footprint: " << footprint(xs) << " bytes" << std::endl;
+}
+
+template <class Set>
+void run_set(const char* name,
+             const std::vector<std::pair<data, data>>& entries,
+             size_t footprint(const Set&)) {
+  std::cout << "-- " << name << std::endl;
+  run("construction", num_rounds, [&](size_t) {
+    Set xs;
+    for (auto& kvp : entries)
+      xs.emplace(kvp.first);
+    return xs.size();
+  });
+  Set xs;
+  for (auto& kvp : entries)
+    xs.emplace(kvp.first);
+  run("lookup", num_lookups, [&](size_t i) {
+    return xs.count(entries[(i * 7919) % entries.size()].first);
+  });
+  auto buf = serialize(xs);
+  run("serialization", num_rounds,
+      [&](size_t) { return serialize(xs).size() == buf.size() ? 1 : 0; });
+  run("deserialization", num_rounds,
+      [&](size_t) { return deserialize<Set>(buf); });
+  std::cout << "footprint: " << footprint(xs) << " bytes" << std::endl;
+}
+
+// Both footprints only include the memory of the container itself, i.e.,
+// without memory that the elements allocate on their own.
+
+template <class T>
+size_t node_footprint(const T&) {
+  return allocated_bytes;
+}
+
+template <class T>
+size_t flat_footprint(const T& xs) {
+  return xs.capacity() * sizeof(typename T::value_type);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  config cfg;
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << "\n\n" << cfg.help_text();
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed)
+    return EXIT_SUCCESS;
+  if (num_entries == 0 || num_rounds == 0) {
+    std::cerr << "*** entries and rounds must be positive\n\n"
+              << cfg.help_text();
+    return EXIT_FAILURE;
+  }
+  auto entries = make_entries();
+  std::cout << num_entries << " entries, " << num_lookups << " lookups, "
+            << num_rounds << " rounds" << std::endl;
+  run_table<std_table>("std::map", entries, node_footprint<std_table>);
+  run_table<table>("broker::table", entries, flat_footprint<table>);
+  run_set<std_set>("std::set", entries, node_footprint<std_set>);
+  run_set<set>("broker::set", entries, flat_footprint<set>);
+  return EXIT_SUCCESS;
+}
@@ -19,6 +19,7 @@
 #include "broker/backend_options.hh"
 #include "broker/data.hh"
 #include "broker/detail/abstract_backend.hh"
+#include "broker/detail/appliers.hh"
 #include "broker/detail/assert.hh"
 #include "broker/detail/filesystem.hh"
 #include "broker/detail/make_backend.hh"
@@ -41,6 +42,68 @@ bool all_equal(const std::vector<T>& xs) {
   return i == xs.end();
 }
 
+// Reads all remaining entries of a cursor in chunks of `n` entries.
+expected<broker::snapshot> drain(detail::backend_cursor& c, size_t n) {
+  broker::snapshot result;
+  std::vector<snapshot_entry> buf;
+  for (;;) {
+    auto more = c.next(n, buf);
+    if (!more)
+      return std::move(more.error());
+    if (buf.size() > n)
+      return make_error(ec::unspecified, "cursor exceeded chunk size");
+    for (auto& kvp : buf)
+      if (!result.emplace(std::move(kvp.first), std::move(kvp.second)).second)
+        return make_error(ec::unspecified, "cursor produced duplicate keys");
+    buf.clear();
+    if (!*more)
+      return result;
+  }
+}
+
+// Reads all entries of a backend through a cursor in chunks of `n` entries.
+expected<broker::snapshot> drain(const detail::abstract_backend& backend,
+                                 size_t n) {
+  auto c = backend.cursor();
+  if (!c)
+    return std::move(c.error());
+  return drain(**c, n);
+}
+
+// Produces the entries of the first cursor and makes sure that all other
+// cursors produce the same entries when reaching the end.
+class meta_cursor : public detail::backend_cursor {
+public:
+  explicit meta_cursor(std::vector<detail::backend_cursor_ptr> cursors)
+    : cursors_(std::move(cursors)) {
+    // nop
+  }
+
+  expected<bool> next(size_t n, std::vector<snapshot_entry>& xs) override {
+    auto first = xs.size();
+    auto more = cursors_.front()->next(n, xs);
+    if (!more)
+      return more;
+    for (auto i = xs.begin() + static_cast<std::ptrdiff_t>(first);
+         i != xs.end(); ++i)
+      seen_.emplace(i->first, i->second);
+    if (*more)
+      return true;
+    for (size_t i = 1; i < cursors_.size(); ++i) {
+      auto ys = drain(*cursors_[i], 3);
+      if (!ys)
+        return std::move(ys.error());
+      if (*ys != seen_)
+        return make_error(ec::unspecified, "cursors produced different data");
+    }
+    return false;
+  }
+
+private:
+  std::vector<detail::backend_cursor_ptr> cursors_;
+  broker::snapshot seen_;
+};
+
 class meta_backend : public detail::abstract_backend {
 public:
   meta_backend(backend_options opts) {
@@ -72,7 +135,7 @@ public:
     );
   }
 
-  expected<void> add(const data& key, const data& value, data::type init_type,
+  expected<void> add(const data& key, data value, data::type init_type,
                      optional<timestamp> expiry) override {
     return perform<void>(
       [&](detail::abstract_backend& backend) {
@@ -114,6 +177,22 @@ public:
     );
   }
 
+  expected<void> begin_batch() override {
+    return perform<void>(
+      [](detail::abstract_backend& backend) {
+        return backend.begin_batch();
+      }
+    );
+  }
+
+  expected<void> commit_batch() override {
+    return perform<void>(
+      [](detail::abstract_backend& backend) {
+        return backend.commit_batch();
+      }
+    );
+  }
+
   expected<data> get(const data& key) const override {
     return perform<data>(
       [&](detail::abstract_backend& backend) {
@@ -170,6 +249,17 @@ public:
     );
   }
 
+  expected<detail::backend_cursor_ptr> cursor() const override {
+    std::vector<detail::backend_cursor_ptr> cursors;
+    for (auto& backend : backends_) {
+      auto c = backend->cursor();
+      if (!c)
+        return std::move(c.error());
+      cursors.emplace_back(std::move(*c));
+    }
+    return {std::make_unique<meta_cursor>(std::move(cursors))};
+  }
+
 private:
   template <class T, class F>
   expected<T> perform(F f) {
@@ -349,4 +439,98 @@ TEST(size/snapshot) {
   CHECK_EQUAL(ss->count("foo"), 1u);
 }
 
+TEST(batches) {
+  using namespace std::chrono;
+  RUN(backend->put("foo", 1));
+  RUN(backend->begin_batch());
+  RUN(backend->put("bar", set{1}));
+  MESSAGE("lookups see modifications of the current batch");
+  CHECK_EQUAL(RUN(backend->get("bar")), data{set{1}});
+  CHECK(RUN(backend->exists("bar")));
+  RUN(backend->add("bar", 2, data::type::set));
+  CHECK_EQUAL(RUN(backend->get("bar")), data{set{1, 2}});
+  MESSAGE("failed modifications don't affect the rest of the batch");
+  CHECK_EQUAL(backend->add("foo", "str", data::type::integer), ec::type_clash);
+  CHECK_EQUAL(backend->subtract("baz", 1), ec::no_such_key);
+  RUN(backend->erase("foo"));
+  CHECK(!RUN(backend->exists("foo")));
+  RUN(backend->put("baz", "qux", broker::now() + seconds{10}));
+  RUN(backend->commit_batch());
+  CHECK_EQUAL(RUN(backend->get("bar")), data{set{1, 2}});
+  CHECK_EQUAL(RUN(backend->get("baz")), data{"qux"});
+  CHECK_EQUAL(backend->get("foo"), ec::no_such_key);
+  CHECK_EQUAL(RUN(backend->size()), 2u);
+  MESSAGE("clearing the store drops earlier modifications of the batch");
+  RUN(backend->begin_batch());
+  RUN(backend->put("foo", 2));
+  RUN(backend->clear());
+  RUN(backend->put("bar", 3));
+  RUN(backend->commit_batch());
+  CHECK_EQUAL(RUN(backend->keys()), data{set{"bar"}});
+}
+
+TEST(cursor) {
+  MESSAGE("cursors on empty backends reach the end right away");
+  auto xs = drain(*backend, 3);
+  REQUIRE(xs);
+  CHECK(xs->empty());
+  MESSAGE("cursors produce all entries in chunks");
+  for (count i = 0; i < 10; ++i)
+    REQUIRE(backend->put(i, "value-" + std::to_string(i)));
+  for (size_t n : {size_t{1}, size_t{3}, size_t{10}, size_t{100}}) {
+    xs = drain(*backend, n);
+    REQUIRE(xs);
+    CHECK_EQUAL(*xs, *backend->snapshot());
+  }
+}
+
+TEST(cursors read the state at their creation) {
+  for (count i = 0; i < 10; ++i)
+    RUN(backend->put(i, "value-" + std::to_string(i)));
+  auto snapshot = RUN(backend->snapshot());
+  auto c = RUN(backend->cursor());
+  std::vector<snapshot_entry> buf;
+  CHECK(RUN(c->next(3, buf)));
+  MESSAGE("modify the backend while the cursor is active");
+  RUN(backend->put(count{20}, "new"));
+  RUN(backend->put(count{7}, "changed"));
+  RUN(backend->erase(count{5}));
+  RUN(backend->begin_batch());
+  RUN(backend->put(count{21}, "batched"));
+  RUN(backend->commit_batch());
+  RUN(backend->clear());
+  MESSAGE("the cursor still produces the original entries");
+  auto rest = RUN(drain(*c, 3));
+  for (auto& x : buf)
+    rest.emplace(std::move(x.first), std::move(x.second));
+  CHECK_EQUAL(rest, snapshot);
+  CHECK_EQUAL(RUN(backend->size()), 0u);
+}
+
 FIXTURE_SCOPE_END()
+
+TEST(adders move owned values into containers) {
+  auto x = data{vector{}};
+  auto value = data{vector{1, 2, 3}};
+  auto storage = get<vector>(value).data();
+  auto res = caf::visit(detail::adder{std::move(value)}, x);
+  REQUIRE(res);
+  REQUIRE_EQUAL(get<vector>(x).size(), 1u);
+  CHECK_EQUAL(get<vector>(x).front(), data{vector{1, 2, 3}});
+  // Moving the value leaves its elements where they were.
+  CHECK(get<vector>(get<vector>(x).front()).data() == storage);
+  MESSAGE("key-value pairs move into tables");
+  auto t = data{table{}};
+  auto kvp = data{vector{"key", set{1, 2}}};
+  res = caf::visit(detail::adder{std::move(kvp)}, t);
+  REQUIRE(res);
+  auto i = get<table>(t).find("key");
+  REQUIRE(i != get<table>(t).end());
+  CHECK_EQUAL(i->second, data{set{1, 2}});
+  MESSAGE("adders copy values they do not own");
+  auto y = data{vector{1}};
+  res = caf::visit(detail::adder{y}, x);
+  REQUIRE(res);
+  CHECK_EQUAL(get<vector>(x).back(), y);
+  CHECK_EQUAL(y, data{vector{1}});
+}
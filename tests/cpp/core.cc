@@ -225,6 +225,24 @@ CAF_TEST(local_peers) {
       CAF_REQUIRE_EQUAL(xs, expected);
     }
   );
+  CAF_MESSAGE("publish a batch of messages on core1 in a single message");
+  anon_send(core1, atom::publish::value,
+            data_msgs({{"a", 6}, {"b", 1}, {"b", 2}, {"b", 3}}));
+  expect((atom::publish, std::vector<data_message>),
+         from(_).to(core1).with(_, _));
+  run();
+  CAF_MESSAGE("check log of the consumer after the batch");
+  self->send(leaf, atom::get::value);
+  sched.prioritize(leaf);
+  consume_message();
+  self->receive(
+    [](const buf& xs) {
+      auto expected = data_msgs({{"b", true}, {"b", false}, {"b", true},
+                                 {"b", false}, {"b", true}, {"b", 1},
+                                 {"b", 2}, {"b", 3}});
+      CAF_REQUIRE_EQUAL(xs, expected);
+    }
+  );
   CAF_MESSAGE("unpeer core1 from core2");
   anon_send(core1, atom::unpeer::value, core2);
   run();
@@ -492,6 +510,95 @@ CAF_TEST(sequenced_peering) {
   anon_send_exit(core3, exit_reason::user_shutdown);
 }
 
+// Simulates two endpoints with two shards each. Peering the primary cores
+// also peers the shards and unpeering disconnects the shards again.
+CAF_TEST(sharded_peers) {
+  broker_options options;
+  options.disable_ssl = true;
+  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
+  auto shard1 = sys.spawn(core_shard, core1, options, nullptr);
+  auto core2 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
+  auto shard2 = sys.spawn(core_shard, core2, options, nullptr);
+  anon_send(core1, atom::shard::value, std::vector<actor>{shard1});
+  anon_send(core2, atom::shard::value, std::vector<actor>{shard2});
+  run();
+  auto num_peers = [&](const actor& hdl) {
+    size_t result = 0;
+    sched.inline_next_enqueue();
+    self->request(hdl, infinite, atom::get::value, atom::peer::value).receive(
+      [&](const std::vector<peer_info>& xs) {
+        result = xs.size();
+      },
+      [&](const error& err) {
+        CAF_FAIL(sys.render(err));
+      }
+    );
+    return result;
+  };
+  CAF_MESSAGE("peer the primary cores");
+  self->send(core1, atom::peer::value, core2);
+  run();
+  CAF_CHECK_EQUAL(num_peers(core1), 1u);
+  CAF_CHECK_EQUAL(num_peers(core2), 1u);
+  CAF_CHECK_EQUAL(num_peers(shard1), 1u);
+  CAF_CHECK_EQUAL(num_peers(shard2), 1u);
+  CAF_MESSAGE("unpeer the primary cores");
+  anon_send(core1, atom::unpeer::value, core2);
+  run();
+  CAF_CHECK_EQUAL(num_peers(core1), 0u);
+  CAF_CHECK_EQUAL(num_peers(core2), 0u);
+  CAF_CHECK_EQUAL(num_peers(shard1), 0u);
+  CAF_CHECK_EQUAL(num_peers(shard2), 0u);
+  // Shutdown.
+  CAF_MESSAGE("Shutdown core actors.");
+  anon_send_exit(core1, exit_reason::user_shutdown);
+  anon_send_exit(shard1, exit_reason::user_shutdown);
+  anon_send_exit(core2, exit_reason::user_shutdown);
+  anon_send_exit(shard2, exit_reason::user_shutdown);
+}
+
+// Simulates an endpoint with two shards and an endpoint without shards. The
+// sharded endpoint drops the peering, regardless of which side initiates it.
+CAF_TEST(sharded_and_unsharded_peers) {
+  broker_options options;
+  options.disable_ssl = true;
+  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
+  auto shard1 = sys.spawn(core_shard, core1, options, nullptr);
+  auto core2 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
+  anon_send(core1, atom::shard::value, std::vector<actor>{shard1});
+  run();
+  auto num_peers = [&](const actor& hdl) {
+    size_t result = 0;
+    sched.inline_next_enqueue();
+    self->request(hdl, infinite, atom::get::value, atom::peer::value).receive(
+      [&](const std::vector<peer_info>& xs) {
+        result = xs.size();
+      },
+      [&](const error& err) {
+        CAF_FAIL(sys.render(err));
+      }
+    );
+    return result;
+  };
+  CAF_MESSAGE("the sharded core initiates the peering");
+  self->send(core1, atom::peer::value, core2);
+  run();
+  CAF_CHECK_EQUAL(num_peers(core1), 0u);
+  CAF_CHECK_EQUAL(num_peers(core2), 0u);
+  CAF_CHECK_EQUAL(num_peers(shard1), 0u);
+  CAF_MESSAGE("the unsharded core initiates the peering");
+  self->send(core2, atom::peer::value, core1);
+  run();
+  CAF_CHECK_EQUAL(num_peers(core1), 0u);
+  CAF_CHECK_EQUAL(num_peers(core2), 0u);
+  CAF_CHECK_EQUAL(num_peers(shard1), 0u);
+  // Shutdown.
+  CAF_MESSAGE("Shutdown core actors.");
+  anon_send_exit(core1, exit_reason::user_shutdown);
+  anon_send_exit(shard1, exit_reason::user_shutdown);
+  anon_send_exit(core2, exit_reason::user_shutdown);
+}
+
 CAF_TEST_FIXTURE_SCOPE_END()
 
 namespace {
@@ -6,6 +6,7 @@
 
 #include <chrono>
 #include <cstdint>
+#include <limits>
 #include <map>
 #include <string>
 #include <type_traits>
@@ -120,6 +121,42 @@ TEST(data - relational operators) {
   CHECK_EQUAL(data{1.111}, data{1.111});
 }
 
+TEST(data - hashing) {
+  auto ip = address{};
+  convert("10.0.0.1", ip);
+  auto x = data{vector{ip, port{80, port::protocol::tcp}, "foo", set{1, 2}}};
+  auto h = x.hash();
+  CHECK_EQUAL(std::hash<data>{}(x), h);
+  MESSAGE("equal values have equal hashes");
+  auto y = x;
+  CHECK_EQUAL(y.hash(), h);
+  CHECK_EQUAL(data{set{1, 2}}.hash(), data{set{2, 1}}.hash());
+  CHECK_EQUAL(data{"foo"}.hash(), data{std::string{"foo"}}.hash());
+  MESSAGE("modifying nested containers changes the hash");
+  get<set>(get<vector>(x)[3]).insert(3);
+  CHECK_NOT_EQUAL(x.hash(), h);
+  CHECK_NOT_EQUAL(x.hash(), y.hash());
+  get<set>(get<vector>(x)[3]).erase(3);
+  CHECK_EQUAL(x.hash(), h);
+  MESSAGE("assignment replaces the hash");
+  x = vector{1, 2, 3};
+  CHECK_EQUAL(x.hash(), data{vector{1, 2, 3}}.hash());
+  x = std::move(y);
+  CHECK_EQUAL(x.hash(), h);
+}
+
+TEST(data - hashes reflect changes through earlier references) {
+  auto x = data{table{{"k", set{1}}}};
+  auto& nested = get<set>(get<table>(x)["k"]);
+  auto h = x.hash();
+  nested.insert(2);
+  CHECK_NOT_EQUAL(x.hash(), h);
+  CHECK_EQUAL(x.hash(), data{table{{"k", set{1, 2}}}}.hash());
+  MESSAGE("sets and tables store no state besides their vector");
+  CHECK_EQUAL(sizeof(set), sizeof(std::vector<data>));
+  CHECK_EQUAL(sizeof(table), sizeof(table::container_type));
+}
+
 TEST(data - vector) {
   vector v{42, 43, 44};
   REQUIRE_EQUAL(v.size(), 3u);
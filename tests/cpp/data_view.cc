@@ -0,0 +1,145 @@
+#define SUITE data_view
+
+#include "broker/data_view.hh"
+
+#include "test.hh"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "broker/data.hh"
+#include "broker/detail/compact_encoding.hh"
+
+using namespace broker;
+
+namespace {
+
+struct fixture {
+  std::vector<char> buf;
+
+  data_view view(const data& x) {
+    return make_data_view(x, buf);
+  }
+
+  data_view compact_view(const data& x) {
+    buf.clear();
+    detail::compact_encoding::encode(x, buf);
+    return {buf.data(), buf.size()};
+  }
+
+  static std::string str(data_view x) {
+    auto result = x.as<std::string_view>();
+    return result ? std::string{*result} : "<none>";
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(data_view_tests, fixture)
+
+TEST(default constructed views are invalid) {
+  data_view x;
+  CHECK(!x.valid());
+  CHECK_EQUAL(x.get_type(), data::type::none);
+  CHECK_EQUAL(x.size(), 0u);
+  CHECK(!x.materialize());
+}
+
+TEST(scalars) {
+  CHECK_EQUAL(view(data{}).get_type(), data::type::none);
+  CHECK_EQUAL(view(true).as<boolean>(), true);
+  CHECK_EQUAL(view(count{42}).as<count>(), count{42});
+  CHECK_EQUAL(view(integer{-42}).as<integer>(), integer{-42});
+  CHECK_EQUAL(view(4.2).as<real>(), 4.2);
+  CHECK_EQUAL(str(view("foo")), "foo");
+  CHECK_EQUAL(view(port(80, port::protocol::tcp)).as<port>(),
+              port(80, port::protocol::tcp));
+  CHECK_EQUAL(view(enum_value{"Foo::BAR"}).as<enum_value>(),
+              enum_value{"Foo::BAR"});
+  CHECK_EQUAL(view(timespan{42}).as<timespan>(), timespan{42});
+}
+
+TEST(type mismatches return nil) {
+  CHECK(!view(count{42}).as<integer>());
+  CHECK(!view("foo").as<count>());
+  CHECK(!view(enum_value{"foo"}).as<std::string_view>());
+}
+
+TEST(vectors) {
+  auto x = vector{1, "two", vector{3, 4}, 5.0};
+  auto v = view(x);
+  CHECK(v.is<vector>());
+  CHECK_EQUAL(v.size(), 4u);
+  CHECK_EQUAL(v[0].as<integer>(), integer{1});
+  CHECK_EQUAL(str(v[1]), "two");
+  CHECK_EQUAL(v[2].size(), 2u);
+  CHECK_EQUAL(v[2][1].as<integer>(), integer{4});
+  CHECK_EQUAL(v[3].as<real>(), 5.0);
+  CHECK(!v[4].valid());
+  size_t n = 0;
+  CHECK(v.for_each([&](data_view) { ++n; }));
+  CHECK_EQUAL(n, 4u);
+}
+
+TEST(sets and tables) {
+  auto s = view(set{1, 2, 3});
+  CHECK_EQUAL(s.size(), 3u);
+  CHECK(s.contains(2));
+  CHECK(!s.contains(4));
+  auto t = view(table{{"a", 1}, {"b", vector{2, 3}}});
+  CHECK_EQUAL(t.size(), 2u);
+  CHECK(t.contains("b"));
+  CHECK_EQUAL(t.find("a").as<integer>(), integer{1});
+  CHECK_EQUAL(t.find("b")[1].as<integer>(), integer{3});
+  CHECK(!t.find("c").valid());
+  std::string keys;
+  CHECK(t.for_each_entry([&](data_view key, data_view) {
+    keys += str(key);
+  }));
+  CHECK_EQUAL(keys, "ab");
+}
+
+TEST(materialize restores the value) {
+  auto x = data{vector{1, set{"a", "b"}, table{{1, 2}}, nil}};
+  CHECK_EQUAL(view(x).materialize(), x);
+  data y;
+  CHECK(convert(view(x), y));
+  CHECK_EQUAL(x, y);
+}
+
+TEST(truncated buffers yield invalid views) {
+  auto x = vector{1, "two", 3};
+  auto v = view(x);
+  data_view truncated{buf.data(), buf.size() - 2};
+  CHECK_EQUAL(truncated.size(), 3u);
+  CHECK(!truncated[2].valid() || !truncated[2].as<integer>());
+  CHECK(!truncated.materialize());
+  CHECK(v.materialize());
+}
+
+TEST(views support the compact encoding) {
+  auto t0 = timestamp{timespan{1577836800000000000}};
+  auto t1 = t0 + timespan{42};
+  auto x = data{vector{1, "two", vector{t0, 3, t1}, set{4, 5},
+                       table{{"a", 6}, {"b", 7}}}};
+  auto v = compact_view(x);
+  CHECK(v.is<vector>());
+  CHECK_EQUAL(v.size(), 5u);
+  CHECK_EQUAL(v[0].as<integer>(), integer{1});
+  CHECK_EQUAL(str(v[1]), "two");
+  CHECK(v[2][0].as<timestamp>() == t0);
+  CHECK(v[2][2].as<timestamp>() == t1);
+  std::vector<timestamp> timestamps;
+  CHECK(v[2].for_each([&](data_view y) {
+    if (auto ts = y.as<timestamp>())
+      timestamps.emplace_back(*ts);
+  }));
+  CHECK(timestamps == std::vector<timestamp>({t0, t1}));
+  CHECK(v[3].contains(5));
+  CHECK(!v[3].contains(6));
+  CHECK_EQUAL(v[4].find("b").as<integer>(), integer{7});
+  CHECK_EQUAL(v.materialize(), x);
+}
+
+FIXTURE_SCOPE_END()
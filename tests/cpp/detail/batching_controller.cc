@@ -0,0 +1,81 @@
+#define SUITE batching_controller
+
+#include "broker/detail/batching_controller.hh"
+
+#include "test.hh"
+
+#include <chrono>
+
+using namespace broker;
+
+using std::chrono::milliseconds;
+
+namespace {
+
+struct fixture {
+  using time_point = detail::batching_controller::time_point;
+
+  detail::batching_controller uut;
+
+  detail::batching_controller::settings cfg;
+
+  time_point now;
+
+  fixture() {
+    cfg.latency_target = milliseconds(10);
+    now = time_point{} + milliseconds(1000);
+  }
+
+  /// Simulates one emit with `n` new messages that all leave the buffer.
+  void emit(size_t n, int32_t credit_before, int32_t credit_after) {
+    uut.before_emit(now, n, credit_before);
+    uut.after_emit(now, 0, credit_after);
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(batching_controller_tests, fixture)
+
+TEST(slow streams ship single messages) {
+  for (int i = 0; i < 10; ++i) {
+    emit(1, 100, 99);
+    now += milliseconds(100);
+    emit(0, 100, 100);
+  }
+  CHECK_LESS(uut.rate(), 20.);
+  CHECK_EQUAL(uut.batch_size(cfg, 50), 1);
+}
+
+TEST(fast streams use larger batches up to the requested size) {
+  for (int i = 0; i < 10; ++i) {
+    emit(100, 1000, 900);
+    now += milliseconds(10);
+  }
+  // 100 messages per 10ms are 10k messages per second, i.e., 100 messages
+  // arrive within the latency target.
+  CHECK_GREATER(uut.rate(), 5000.);
+  CHECK_EQUAL(uut.batch_size(cfg, 200), 100);
+  CHECK_EQUAL(uut.batch_size(cfg, 100), 100);
+  // The receiver asks for smaller batches.
+  CHECK_EQUAL(uut.batch_size(cfg, 20), 20);
+}
+
+TEST(acknowledgements update the round trip time) {
+  emit(10, 100, 90);
+  now += milliseconds(4);
+  // The receiver granted new credit.
+  emit(0, 100, 100);
+  CHECK_EQUAL(uut.rtt(), milliseconds(4));
+}
+
+TEST(messages leave the buffer after reaching the latency target) {
+  uut.before_emit(now, 1, 100);
+  CHECK(!uut.flush(cfg, now));
+  uut.after_emit(now, 1, 100);
+  now += milliseconds(10);
+  uut.before_emit(now, 1, 100);
+  CHECK(uut.flush(cfg, now));
+}
+
+FIXTURE_SCOPE_END()
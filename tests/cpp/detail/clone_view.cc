@@ -0,0 +1,79 @@
+#define SUITE clone_view
+
+#include "broker/detail/clone_view.hh"
+
+#include "test.hh"
+
+#include "broker/data.hh"
+#include "broker/error.hh"
+#include "broker/expected.hh"
+
+using namespace broker;
+
+namespace {
+
+using map_type = detail::clone_map;
+
+struct fixture {
+  detail::clone_view view;
+
+  fixture() {
+    view.publish(map_type{{"foo", 42}, {"bar", set{1, 2}}}, false);
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(clone_view_tests, fixture)
+
+TEST(new views are stale) {
+  detail::clone_view fresh;
+  CHECK(fresh.load()->is_stale);
+  CHECK_EQUAL(error_of(fresh.get("foo")), ec::stale_data);
+  CHECK_EQUAL(error_of(fresh.exists("foo")), ec::stale_data);
+  CHECK_EQUAL(error_of(fresh.keys()), ec::stale_data);
+}
+
+TEST(queries read the current version) {
+  CHECK_EQUAL(value_of(view.get("foo")), data{42});
+  CHECK_EQUAL(error_of(view.get("baz")), ec::no_such_key);
+  CHECK_EQUAL(value_of(view.exists("foo")), data{true});
+  CHECK_EQUAL(value_of(view.exists("baz")), data{false});
+  CHECK_EQUAL(value_of(view.get("bar", 2)), data{true});
+  CHECK_EQUAL(value_of(view.get("bar", 3)), data{false});
+  CHECK_EQUAL(value_of(view.keys()), data(set{"bar", "foo"}));
+}
+
+TEST(readers keep the version they loaded) {
+  auto v1 = view.load();
+  view.publish(map_type{{"foo", 23}}, false);
+  CHECK_EQUAL(*v1->store.find("foo"), data{42});
+  CHECK_EQUAL(v1->store.size(), 2u);
+  CHECK_EQUAL(value_of(view.get("foo")), data{23});
+  CHECK_EQUAL(error_of(view.get("bar")), ec::no_such_key);
+}
+
+TEST(versions share entries with the clone) {
+  map_type store{{"foo", 1}, {"bar", 2}};
+  view.publish(store, false);
+  auto v1 = view.load();
+  store.insert_or_assign("foo", 10);
+  *store.find_mutable("bar") = 20;
+  store.emplace("baz", 30);
+  view.publish(store, false);
+  CHECK_EQUAL(*v1->store.find("foo"), data{1});
+  CHECK_EQUAL(*v1->store.find("bar"), data{2});
+  CHECK(!v1->store.contains("baz"));
+  CHECK_EQUAL(value_of(view.get("foo")), data{10});
+  CHECK_EQUAL(value_of(view.get("bar")), data{20});
+  CHECK_EQUAL(value_of(view.get("baz")), data{30});
+}
+
+TEST(stale versions reject all queries) {
+  view.publish(map_type{{"foo", 42}}, true);
+  CHECK_EQUAL(error_of(view.get("foo")), ec::stale_data);
+  CHECK_EQUAL(error_of(view.get("foo", 1)), ec::stale_data);
+  CHECK_EQUAL(error_of(view.exists("foo")), ec::stale_data);
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,150 @@
+#define SUITE compact_encoding
+
+#include "broker/detail/compact_encoding.hh"
+
+#include "test.hh"
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "broker/data.hh"
+#include "broker/detail/blob.hh"
+
+using namespace broker;
+using namespace broker::detail;
+
+namespace {
+
+struct fixture {
+  std::vector<char> buf;
+
+  size_t encoded_size(const data& x) {
+    buf.clear();
+    compact_encoding::encode(x, buf);
+    return buf.size();
+  }
+
+  data roundtrip(const data& x) {
+    buf.clear();
+    compact_encoding::encode(x, buf);
+    data result;
+    if (auto err = compact_encoding::decode(buf.data(), buf.size(), result))
+      FAIL("decoding failed: " << to_string(err));
+    return result;
+  }
+};
+
+timestamp make_ts(integer ns) {
+  return timestamp{timespan{ns}};
+}
+
+} // namespace
+
+FIXTURE_SCOPE(compact_encoding_tests, fixture)
+
+TEST(scalars survive a roundtrip) {
+  auto ip = address{};
+  convert("192.168.1.1", ip);
+  auto ip6 = address{};
+  convert("2001:db8::1", ip6);
+  std::vector<data> xs{nil,
+                       true,
+                       false,
+                       count{0},
+                       count{63},
+                       count{64},
+                       std::numeric_limits<count>::max(),
+                       integer{-16},
+                       integer{15},
+                       integer{-17},
+                       std::numeric_limits<integer>::min(),
+                       std::numeric_limits<integer>::max(),
+                       4.2,
+                       "",
+                       std::string(31, 'x'),
+                       std::string(1000, 'y'),
+                       ip,
+                       ip6,
+                       subnet{ip, 24},
+                       subnet{ip6, 64},
+                       port{8080, port::protocol::tcp},
+                       make_ts(1577836800123456789),
+                       make_ts(-1),
+                       timespan{-42},
+                       enum_value{"Foo::BAR"}};
+  for (auto& x : xs)
+    CHECK_EQUAL(roundtrip(x), x);
+}
+
+TEST(containers survive a roundtrip) {
+  auto timestamps = vector{make_ts(7), make_ts(5), timespan{8}, make_ts(9),
+                           make_ts(std::numeric_limits<integer>::min()),
+                           make_ts(std::numeric_limits<integer>::max())};
+  auto x = data{vector{1, "two", set{3, 4}, table{{"five", 6.0}}, nil,
+                       std::move(timestamps)}};
+  CHECK_EQUAL(roundtrip(x), x);
+  CHECK_EQUAL(roundtrip(set{}), data{set{}});
+  CHECK_EQUAL(roundtrip(table{}), data{table{}});
+  CHECK_EQUAL(roundtrip(vector{}), data{vector{}});
+}
+
+TEST(small values fit into their tag) {
+  // One byte for the version plus one byte for the tag.
+  CHECK_EQUAL(encoded_size(count{42}), 2u);
+  CHECK_EQUAL(encoded_size(integer{-3}), 2u);
+  CHECK_EQUAL(encoded_size(true), 2u);
+  // Short strings add their characters.
+  CHECK_EQUAL(encoded_size("foo"), 5u);
+  // Larger values fall back to varints.
+  CHECK_EQUAL(encoded_size(count{300}), 4u);
+}
+
+TEST(timestamps in vectors store deltas) {
+  auto t0 = make_ts(1577836800000000000);
+  auto single = encoded_size(vector{t0});
+  auto two = encoded_size(vector{t0, t0 + std::chrono::seconds(1)});
+  // A delta of 1s needs 5 bytes plus its tag, whereas the absolute value of
+  // the second timestamp would need 9 bytes.
+  CHECK_EQUAL(two - single, 6u);
+}
+
+TEST(malformed input is an error) {
+  data x;
+  encoded_size(vector{1, "two", 3});
+  CHECK(compact_encoding::decode(buf.data(), buf.size() - 1, x));
+  CHECK(compact_encoding::decode(buf.data() + 1, buf.size() - 1, x));
+  buf.push_back(0);
+  CHECK(compact_encoding::decode(buf.data(), buf.size(), x));
+  // Containers may not claim more elements than bytes remain.
+  std::vector<char> huge{static_cast<char>(compact_encoding::version), 0x12,
+                         static_cast<char>(0xFF), static_cast<char>(0xFF),
+                         static_cast<char>(0xFF), 0x0F};
+  CHECK(compact_encoding::decode(huge.data(), huge.size(), x));
+  // Relative timestamps require a preceding timestamp in the same vector.
+  std::vector<char> orphan{static_cast<char>(compact_encoding::version), 0x0D,
+                           0x02};
+  CHECK(compact_encoding::decode(orphan.data(), orphan.size(), x));
+}
+
+TEST(value blobs accept the binary encoding of previous versions) {
+  auto x = data{table{{"a", vector{1, 2}}}};
+  auto compact = to_value_blob(x);
+  CHECK(compact_encoding::is_compact(compact.data(), compact.size()));
+  CHECK_EQUAL(value_of(from_value_blob(compact)), x);
+  auto legacy = to_blob(x);
+  CHECK(!compact_encoding::is_compact(legacy.data(), legacy.size()));
+  CHECK_EQUAL(value_of(from_value_blob(legacy)), x);
+  CHECK_LESS(compact.size(), legacy.size());
+}
+
+TEST(value blobs report malformed input) {
+  auto compact = to_value_blob(data{vector{1, "two", 3}});
+  compact.pop_back();
+  CHECK(!from_value_blob(compact));
+  auto legacy = to_blob(data{vector{1, "two", 3}});
+  legacy.pop_back();
+  CHECK(!from_value_blob(legacy));
+}
+
+FIXTURE_SCOPE_END()
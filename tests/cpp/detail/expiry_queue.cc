@@ -0,0 +1,84 @@
+#define SUITE expiry_queue
+
+#include "broker/detail/expiry_queue.hh"
+
+#include "test.hh"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "broker/data.hh"
+#include "broker/time.hh"
+
+using namespace broker;
+
+namespace {
+
+using std::chrono::seconds;
+
+struct fixture {
+  detail::expiry_queue queue;
+
+  timestamp t0 = timestamp{} + seconds(100);
+
+  std::vector<data> drain(timestamp now) {
+    std::vector<data> result;
+    queue.drain(now, result);
+    return result;
+  }
+};
+
+using data_vector = std::vector<data>;
+
+} // namespace
+
+FIXTURE_SCOPE(expiry_queue_tests, fixture)
+
+TEST(keys expire in the order of their deadlines) {
+  queue.schedule("b", t0 + seconds(2));
+  queue.schedule("a", t0 + seconds(1));
+  queue.schedule("c", t0 + seconds(3));
+  CHECK_EQUAL(queue.size(), 3u);
+  CHECK_EQUAL(drain(t0), data_vector{});
+  CHECK_EQUAL(drain(t0 + seconds(2)), data_vector({"a", "b"}));
+  CHECK_EQUAL(drain(t0 + seconds(10)), data_vector({"c"}));
+  CHECK(queue.empty());
+}
+
+TEST(refreshing a key moves its deadline) {
+  queue.schedule("a", t0 + seconds(1));
+  queue.schedule("a", t0 + seconds(5));
+  CHECK_EQUAL(queue.size(), 1u);
+  CHECK_EQUAL(drain(t0 + seconds(1)), data_vector{});
+  CHECK_EQUAL(drain(t0 + seconds(5)), data_vector({"a"}));
+  MESSAGE("earlier deadlines take effect as well");
+  queue.schedule("b", t0 + seconds(10));
+  queue.schedule("b", t0 + seconds(6));
+  CHECK_EQUAL(drain(t0 + seconds(6)), data_vector({"b"}));
+  CHECK_EQUAL(drain(t0 + seconds(10)), data_vector{});
+}
+
+TEST(canceled keys never expire) {
+  queue.schedule("a", t0 + seconds(1));
+  queue.schedule("b", t0 + seconds(1));
+  queue.cancel("a");
+  CHECK_EQUAL(drain(t0 + seconds(1)), data_vector({"b"}));
+  queue.schedule("c", t0 + seconds(2));
+  queue.clear();
+  CHECK(queue.empty());
+  CHECK_EQUAL(drain(t0 + seconds(2)), data_vector{});
+}
+
+TEST(frequent rescheduling keeps all keys) {
+  for (int i = 0; i < 1000; ++i) {
+    auto key = data{std::to_string(i)};
+    queue.schedule(key, t0 + seconds(1000 + i));
+    queue.schedule(key, t0 + seconds(i % 10));
+  }
+  CHECK_EQUAL(queue.size(), 1000u);
+  CHECK_EQUAL(drain(t0 + seconds(9)).size(), 1000u);
+  CHECK(queue.empty());
+}
+
+FIXTURE_SCOPE_END()
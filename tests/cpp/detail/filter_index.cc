@@ -0,0 +1,104 @@
+#define SUITE filter_index
+
+#include "broker/detail/filter_index.hh"
+
+#include "test.hh"
+
+#include <cstdint>
+#include <vector>
+
+#include "broker/detail/prefix_matcher.hh"
+
+using namespace broker;
+
+namespace {
+
+using key_list = std::vector<uint16_t>;
+
+struct fixture {
+  detail::filter_index<uint16_t> uut;
+
+  key_list match(const topic& t) {
+    return uut.match(t);
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(filter_index_tests, fixture)
+
+TEST(an empty index matches nothing) {
+  CHECK(uut.empty());
+  CHECK_EQUAL(match("/zeek/events"), key_list{});
+}
+
+TEST(lookups return all keys with a matching prefix) {
+  uut.update(1, {"/zeek/events", "/zeek/stores"});
+  uut.update(2, {"/zeek/events/debugging"});
+  uut.update(3, {"/zeek/"});
+  CHECK_EQUAL(uut.size(), 3u);
+  CHECK_EQUAL(match("/zeek/events"), key_list({1, 3}));
+  CHECK_EQUAL(match("/zeek/events/debugging/foo"), key_list({1, 2, 3}));
+  CHECK_EQUAL(match("/zeek/stores/masters"), key_list({1, 3}));
+  CHECK_EQUAL(match("/zeek"), key_list{});
+  CHECK_EQUAL(match("/bro/events"), key_list{});
+}
+
+TEST(keys appear only once per lookup) {
+  uut.update(1, {"/a", "/a/b", "/a/b/c", "/a/b"});
+  CHECK_EQUAL(match("/a/b/c/d"), key_list({1}));
+}
+
+TEST(the empty topic matches everything) {
+  uut.update(7, {""});
+  uut.update(1, {"/a"});
+  CHECK_EQUAL(match("/a"), key_list({1, 7}));
+  CHECK_EQUAL(match("/b"), key_list({7}));
+}
+
+TEST(updates replace previous filters) {
+  uut.update(1, {"/a"});
+  CHECK_EQUAL(match("/a/b"), key_list({1}));
+  uut.update(1, {"/b"});
+  CHECK_EQUAL(match("/a/b"), key_list{});
+  CHECK_EQUAL(match("/b/a"), key_list({1}));
+  uut.update(1, {});
+  CHECK_EQUAL(match("/b/a"), key_list{});
+  CHECK(uut.empty());
+}
+
+TEST(erasing a key keeps prefixes of other keys intact) {
+  uut.update(1, {"/a", "/b"});
+  uut.update(2, {"/a"});
+  uut.erase(1);
+  CHECK_EQUAL(match("/a"), key_list({2}));
+  CHECK_EQUAL(match("/b"), key_list{});
+  uut.erase(2);
+  CHECK_EQUAL(match("/a"), key_list{});
+  CHECK(uut.empty());
+}
+
+TEST(the index agrees with the prefix matcher) {
+  std::vector<filter_type> filters{
+    {"/zeek/", "/foo/bar"},
+    {"/zeek/events/x", "/foo"},
+    {"/zeek/events/xy"},
+    {"/bar"},
+  };
+  for (uint16_t i = 0; i < filters.size(); ++i)
+    uut.update(i, filters[i]);
+  std::vector<topic> topics{"/zeek/events/x",  "/zeek/events/xyz",
+                            "/foo/bar",        "/foo/baz",
+                            "/bar/foo",        "/zeek",
+                            "/zeek/stores/abc"};
+  detail::prefix_matcher f;
+  for (auto& t : topics) {
+    key_list expected;
+    for (uint16_t i = 0; i < filters.size(); ++i)
+      if (f(filters[i], t))
+        expected.emplace_back(i);
+    CHECK_EQUAL(match(t), expected);
+  }
+}
+
+FIXTURE_SCOPE_END()
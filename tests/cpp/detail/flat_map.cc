@@ -0,0 +1,108 @@
+#define SUITE flat_map
+
+#include "broker/detail/flat_map.hh"
+
+#include "test.hh"
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+
+#include "broker/data.hh"
+
+using namespace broker;
+
+namespace {
+
+using int_map = detail::flat_map<int, std::string>;
+
+using kvp_vector = std::vector<std::pair<int, std::string>>;
+
+} // namespace
+
+TEST(construction sorts by key and keeps the first value) {
+  int_map xs{{2, "b"}, {1, "a"}, {2, "c"}};
+  CHECK_EQUAL(xs.container(), kvp_vector({{1, "a"}, {2, "b"}}));
+}
+
+TEST(element access) {
+  int_map xs;
+  xs[2] = "b";
+  xs[1] = "a";
+  xs[2] = "c";
+  CHECK_EQUAL(xs.container(), kvp_vector({{1, "a"}, {2, "c"}}));
+  CHECK_EQUAL(xs.at(1), "a");
+  auto out_of_range = false;
+  try {
+    xs.at(3);
+  } catch (std::out_of_range&) {
+    out_of_range = true;
+  }
+  CHECK(out_of_range);
+}
+
+TEST(insertion never overrides existing values) {
+  int_map xs{{1, "a"}};
+  CHECK(!xs.emplace(1, "b").second);
+  CHECK(!xs.insert(std::make_pair(1, "b")).second);
+  CHECK(!xs.try_emplace(1, "b").second);
+  CHECK_EQUAL(xs.at(1), "a");
+  CHECK(!xs.insert_or_assign(1, "b").second);
+  CHECK_EQUAL(xs.at(1), "b");
+  xs.insert({{3, "c"}, {1, "x"}, {2, "b"}});
+  CHECK_EQUAL(xs.container(), kvp_vector({{1, "b"}, {2, "b"}, {3, "c"}}));
+}
+
+TEST(lookup and erase) {
+  int_map xs{{1, "a"}, {3, "c"}, {5, "e"}};
+  auto i = xs.find(3);
+  REQUIRE(i != xs.end());
+  i->second = "C";
+  CHECK_EQUAL(xs.at(3), "C");
+  CHECK(xs.find(4) == xs.end());
+  CHECK_EQUAL(xs.lower_bound(4)->first, 5);
+  CHECK_EQUAL(xs.upper_bound(3)->first, 5);
+  CHECK_EQUAL(xs.erase(3), 1u);
+  CHECK_EQUAL(xs.erase(3), 0u);
+  xs.erase(xs.begin());
+  CHECK_EQUAL(xs.container(), kvp_vector({{5, "e"}}));
+}
+
+TEST(iterators expose constant keys) {
+  using reference = decltype(*std::declval<int_map::iterator>());
+  static_assert(std::is_same<reference, int_map::value_type&>::value
+                  && std::is_const<int_map::value_type::first_type>::value,
+                "iterators must not allow modifying keys");
+  int_map xs{{1, "a"}, {2, "b"}};
+  for (auto& kvp : xs)
+    kvp.second += kvp.second;
+  CHECK_EQUAL(xs.container(), kvp_vector({{1, "aa"}, {2, "bb"}}));
+  int_map::const_iterator i = xs.begin();
+  CHECK(i == xs.begin());
+  CHECK_EQUAL(xs.end() - i, 2);
+  CHECK_EQUAL(i[1].second, "bb");
+  CHECK_EQUAL(xs.rbegin()->first, 2);
+}
+
+TEST(serialization uses the format of std::map) {
+  using buffer = caf::binary_serializer::container_type;
+  buffer buf1;
+  buffer buf2;
+  std::map<data, data> xs{{"foo", 1}, {"bar", 2}};
+  table ys{{"foo", 1}, {"bar", 2}};
+  caf::binary_serializer sink1{nullptr, buf1};
+  CHECK_EQUAL(sink1(xs), caf::none);
+  caf::binary_serializer sink2{nullptr, buf2};
+  CHECK_EQUAL(sink2(ys), caf::none);
+  CHECK_EQUAL(buf1, buf2);
+  table zs;
+  caf::binary_deserializer source{nullptr, buf1};
+  CHECK_EQUAL(source(zs), caf::none);
+  CHECK_EQUAL(zs, ys);
+}
@@ -0,0 +1,107 @@
+#define SUITE flat_set
+
+#include "broker/detail/flat_set.hh"
+
+#include "test.hh"
+
+#include <iterator>
+#include <set>
+#include <vector>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+
+#include "broker/data.hh"
+
+using namespace broker;
+
+namespace {
+
+using int_set = detail::flat_set<int>;
+
+using int_vector = std::vector<int>;
+
+} // namespace
+
+TEST(construction sorts elements and removes duplicates) {
+  int_set xs{5, 3, 5, 1};
+  CHECK_EQUAL(xs.container(), int_vector({1, 3, 5}));
+  int_vector ys{9, 2, 2, 7};
+  int_set zs(ys.begin(), ys.end());
+  CHECK_EQUAL(zs.container(), int_vector({2, 7, 9}));
+}
+
+TEST(insert keeps elements ordered and unique) {
+  int_set xs;
+  CHECK(xs.insert(3).second);
+  CHECK(xs.insert(1).second);
+  CHECK(!xs.insert(3).second);
+  CHECK_EQUAL(*xs.insert(2).first, 2);
+  CHECK_EQUAL(xs.container(), int_vector({1, 2, 3}));
+  xs.insert({0, 2, 4});
+  CHECK_EQUAL(xs.container(), int_vector({0, 1, 2, 3, 4}));
+}
+
+TEST(insert with hint falls back to a lookup for bad hints) {
+  int_set xs;
+  auto out = std::inserter(xs, xs.end());
+  for (auto x : {1, 2, 4})
+    *out++ = x;
+  CHECK_EQUAL(xs.container(), int_vector({1, 2, 4}));
+  CHECK_EQUAL(*xs.insert(xs.begin(), 3), 3);
+  CHECK_EQUAL(*xs.insert(xs.end(), 0), 0);
+  CHECK_EQUAL(*xs.insert(xs.end(), 2), 2);
+  CHECK_EQUAL(xs.container(), int_vector({0, 1, 2, 3, 4}));
+}
+
+TEST(lookup and erase) {
+  int_set xs{1, 3, 5, 7};
+  CHECK_EQUAL(xs.count(3), 1u);
+  CHECK_EQUAL(xs.count(4), 0u);
+  CHECK(xs.find(4) == xs.end());
+  CHECK_EQUAL(*xs.lower_bound(4), 5);
+  CHECK_EQUAL(*xs.upper_bound(5), 7);
+  CHECK_EQUAL(xs.erase(3), 1u);
+  CHECK_EQUAL(xs.erase(3), 0u);
+  xs.erase(xs.begin());
+  CHECK_EQUAL(xs.container(), int_vector({5, 7}));
+}
+
+TEST(comparison operators follow std::set) {
+  std::set<int> a{1, 2, 3};
+  std::set<int> b{1, 3};
+  int_set x{1, 2, 3};
+  int_set y{1, 3};
+  CHECK_EQUAL(x < y, a < b);
+  CHECK_EQUAL(y < x, b < a);
+  CHECK(x == int_set({3, 2, 1}));
+  CHECK(x != y);
+}
+
+TEST(serialization uses the format of std::set) {
+  using buffer = caf::binary_serializer::container_type;
+  buffer buf1;
+  buffer buf2;
+  std::set<data> xs{"foo", "bar", 42};
+  set ys{"foo", "bar", 42};
+  caf::binary_serializer sink1{nullptr, buf1};
+  CHECK_EQUAL(sink1(xs), caf::none);
+  caf::binary_serializer sink2{nullptr, buf2};
+  CHECK_EQUAL(sink2(ys), caf::none);
+  CHECK_EQUAL(buf1, buf2);
+  set zs;
+  caf::binary_deserializer source{nullptr, buf1};
+  CHECK_EQUAL(source(zs), caf::none);
+  CHECK_EQUAL(zs, ys);
+}
+
+TEST(deserialization restores the order of unsorted input) {
+  caf::binary_serializer::container_type buf;
+  caf::binary_serializer sink{nullptr, buf};
+  vector unsorted{3, 1, 2, 1};
+  CHECK_EQUAL(sink(unsorted), caf::none);
+  set xs;
+  caf::binary_deserializer source{nullptr, buf};
+  CHECK_EQUAL(source(xs), caf::none);
+  CHECK_EQUAL(xs, set({1, 2, 3}));
+}
@@ -0,0 +1,123 @@
+#define SUITE peer_buffer
+
+#include "broker/detail/peer_buffer.hh"
+
+#include "test.hh"
+
+#include <vector>
+
+#include "broker/data.hh"
+#include "broker/detail/filesystem.hh"
+
+using namespace broker;
+
+namespace {
+
+using batch = detail::peer_buffer::batch;
+
+using push_result = detail::peer_buffer::push_result;
+
+struct fixture {
+  detail::peer_buffer::limits cfg;
+
+  std::string tmp_file;
+
+  fixture() {
+    tmp_file = detail::make_temp_file_name();
+    cfg.memory = 0;
+  }
+
+  ~fixture() {
+    detail::remove(tmp_file);
+  }
+
+  static batch make_batch(int first, int last) {
+    batch result;
+    for (int i = first; i < last; ++i)
+      result.emplace_back(make_node_message(make_data_message("/foo", i), 1));
+    return result;
+  }
+
+  // Returns all buffered values in order.
+  std::vector<data> drain(detail::peer_buffer& buf) {
+    std::vector<data> result;
+    auto err = buf.drain(nullptr, [&](batch& xs) {
+      for (auto& x : xs) {
+        if (auto err = detail::unpack(nullptr, x))
+          FAIL("unpacking failed: " << to_string(err));
+        result.emplace_back(get_data(caf::get<data_message>(x.content)));
+      }
+    });
+    if (err)
+      FAIL("drain failed: " << to_string(err));
+    return result;
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(peer_buffer_tests, fixture)
+
+TEST(batches beyond the memory limit get dropped without spill directory) {
+  detail::peer_buffer buf{cfg};
+  auto xs = make_batch(0, 2);
+  CHECK_EQUAL(buf.push(nullptr, xs), push_result::buffered);
+  auto ys = make_batch(2, 4);
+  CHECK_EQUAL(buf.push(nullptr, ys), push_result::dropped);
+  CHECK_EQUAL(buf.size(), 2u);
+  CHECK_EQUAL(buf.dropped(), 2u);
+  CHECK_EQUAL(buf.worst_result(), push_result::dropped);
+  CHECK_EQUAL(drain(buf), std::vector<data>({0, 1}));
+  CHECK_EQUAL(buf.size(), 0u);
+}
+
+TEST(spilled batches replay in their original order) {
+  cfg.spill_directory = detail::dirname(tmp_file);
+  detail::peer_buffer buf{cfg};
+  for (int i = 0; i < 4; ++i) {
+    auto xs = make_batch(i * 2, i * 2 + 2);
+    buf.push(nullptr, xs);
+  }
+  CHECK_EQUAL(buf.size(), 8u);
+  CHECK_GREATER(buf.spill_usage(), 0u);
+  CHECK_EQUAL(buf.worst_result(), push_result::spilled);
+  CHECK_EQUAL(drain(buf), std::vector<data>({0, 1, 2, 3, 4, 5, 6, 7}));
+  CHECK_EQUAL(buf.spill_usage(), 0u);
+}
+
+TEST(batches beyond the spill limit get dropped) {
+  cfg.spill_directory = detail::dirname(tmp_file);
+  cfg.spill = 1;
+  detail::peer_buffer buf{cfg};
+  auto xs = make_batch(0, 2);
+  CHECK_EQUAL(buf.push(nullptr, xs), push_result::buffered);
+  auto ys = make_batch(2, 4);
+  CHECK_EQUAL(buf.push(nullptr, ys), push_result::dropped);
+  CHECK_EQUAL(drain(buf), std::vector<data>({0, 1}));
+}
+
+TEST(buffers retry opening a spill file only after draining) {
+  auto dir = tmp_file + "-spill";
+  cfg.spill_directory = dir;
+  detail::peer_buffer buf{cfg};
+  for (int i = 0; i < 3; ++i) {
+    auto xs = make_batch(i * 2, i * 2 + 2);
+    buf.push(nullptr, xs);
+  }
+  CHECK_EQUAL(buf.size(), 2u);
+  CHECK_EQUAL(buf.dropped(), 4u);
+  // Creating the directory has no effect until the buffer drained.
+  REQUIRE(detail::mkdirs(dir));
+  auto ys = make_batch(6, 8);
+  CHECK_EQUAL(buf.push(nullptr, ys), push_result::dropped);
+  CHECK_EQUAL(drain(buf), std::vector<data>({0, 1}));
+  for (int i = 0; i < 2; ++i) {
+    auto xs = make_batch(i * 2, i * 2 + 2);
+    buf.push(nullptr, xs);
+  }
+  CHECK_EQUAL(buf.size(), 4u);
+  CHECK_EQUAL(drain(buf), std::vector<data>({0, 1, 2, 3}));
+  detail::remove_all(dir);
+}
+
+FIXTURE_SCOPE_END()
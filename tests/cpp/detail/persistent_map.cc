@@ -0,0 +1,100 @@
+#define SUITE persistent_map
+
+#include "broker/detail/persistent_map.hh"
+
+#include "test.hh"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace broker;
+
+namespace {
+
+/// Maps all keys to one of three hash values to force collisions.
+struct bad_hash {
+  size_t operator()(int x) const {
+    return static_cast<size_t>(x % 3);
+  }
+};
+
+using int_map = detail::persistent_map<int, std::string>;
+
+using colliding_map = detail::persistent_map<int, std::string, bad_hash>;
+
+template <class Map>
+std::map<int, std::string> to_std_map(const Map& xs) {
+  std::map<int, std::string> result;
+  xs.for_each([&](int key, const std::string& value) {
+    result.emplace(key, value);
+  });
+  return result;
+}
+
+template <class Map>
+void check_modifications() {
+  Map xs;
+  std::map<int, std::string> expected;
+  for (int i = 0; i < 1000; ++i) {
+    CHECK(xs.emplace(i, std::to_string(i)));
+    expected.emplace(i, std::to_string(i));
+  }
+  CHECK(!xs.emplace(1, "x"));
+  CHECK(!xs.insert_or_assign(2, "two"));
+  expected[2] = "two";
+  *xs.find_mutable(3) += "!";
+  expected[3] += "!";
+  for (int i = 500; i < 1000; ++i) {
+    CHECK(xs.erase(i));
+    expected.erase(i);
+  }
+  CHECK(!xs.erase(500));
+  CHECK(xs.find_mutable(500) == nullptr);
+  CHECK_EQUAL(xs.size(), expected.size());
+  CHECK_EQUAL(to_std_map(xs), expected);
+  xs.clear();
+  CHECK(xs.empty());
+  CHECK(!xs.contains(1));
+}
+
+} // namespace
+
+TEST(lookup) {
+  int_map xs{{1, "a"}, {2, "b"}};
+  CHECK_EQUAL(xs.size(), 2u);
+  CHECK_EQUAL(*xs.find(1), "a");
+  CHECK_EQUAL(*xs.find(2), "b");
+  CHECK(xs.find(3) == nullptr);
+  CHECK(xs.contains(1));
+  CHECK(!xs.contains(3));
+}
+
+TEST(modifiers) {
+  check_modifications<int_map>();
+}
+
+TEST(modifiers with hash collisions) {
+  check_modifications<colliding_map>();
+}
+
+TEST(copies are independent snapshots) {
+  int_map xs;
+  for (int i = 0; i < 100; ++i)
+    xs.emplace(i, "a");
+  auto snapshot = xs;
+  xs.insert_or_assign(1, "b");
+  *xs.find_mutable(2) = "c";
+  xs.erase(3);
+  xs.emplace(100, "d");
+  CHECK_EQUAL(snapshot.size(), 100u);
+  CHECK_EQUAL(*snapshot.find(1), "a");
+  CHECK_EQUAL(*snapshot.find(2), "a");
+  CHECK_EQUAL(*snapshot.find(3), "a");
+  CHECK(!snapshot.contains(100));
+  CHECK_EQUAL(xs.size(), 100u);
+  CHECK_EQUAL(*xs.find(1), "b");
+  CHECK_EQUAL(*xs.find(2), "c");
+  CHECK(!xs.contains(3));
+  CHECK_EQUAL(*xs.find(100), "d");
+}
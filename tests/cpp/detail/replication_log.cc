@@ -0,0 +1,102 @@
+#define SUITE replication_log
+
+#include "broker/detail/replication_log.hh"
+
+#include "test.hh"
+
+#include <vector>
+
+#include "broker/data.hh"
+#include "broker/internal_command.hh"
+
+using namespace broker;
+
+namespace {
+
+internal_command put(int key) {
+  return make_internal_command<put_command>(data{key}, data{"value"});
+}
+
+using seq_vector = std::vector<sequence_number>;
+
+seq_vector seqs(const std::vector<internal_command>& xs) {
+  seq_vector result;
+  for (auto& x : xs)
+    result.emplace_back(x.seq);
+  return result;
+}
+
+} // namespace
+
+TEST(append assigns consecutive sequence numbers) {
+  detail::replication_log log{10};
+  CHECK_EQUAL(log.last_seq(), 0u);
+  for (int i = 1; i <= 3; ++i) {
+    auto x = put(i);
+    log.append(x);
+    CHECK_EQUAL(x.seq, static_cast<sequence_number>(i));
+  }
+  CHECK_EQUAL(log.last_seq(), 3u);
+  CHECK_EQUAL(log.size(), 3u);
+}
+
+TEST(logs return all commands after a sequence number) {
+  detail::replication_log log{10};
+  for (int i = 1; i <= 5; ++i) {
+    auto x = put(i);
+    log.append(x);
+  }
+  CHECK(log.covers(0));
+  CHECK(log.covers(5));
+  CHECK(!log.covers(6));
+  CHECK_EQUAL(seqs(log.since(2)), seq_vector({3, 4, 5}));
+  CHECK_EQUAL(seqs(log.since(5)), seq_vector{});
+  auto xs = log.since(4);
+  REQUIRE_EQUAL(xs.size(), 1u);
+  auto cmd = caf::get_if<put_command>(&xs.front().content);
+  REQUIRE(cmd != nullptr);
+  CHECK_EQUAL(cmd->key, data{5});
+}
+
+TEST(logs evict the oldest commands) {
+  detail::replication_log log{3};
+  for (int i = 1; i <= 5; ++i) {
+    auto x = put(i);
+    log.append(x);
+  }
+  CHECK_EQUAL(log.size(), 3u);
+  CHECK(!log.covers(1));
+  CHECK(log.covers(2));
+  CHECK_EQUAL(seqs(log.since(2)), seq_vector({3, 4, 5}));
+}
+
+TEST(logs keep commands after growing) {
+  detail::replication_log log;
+  for (int i = 1; i <= 2; ++i) {
+    auto x = put(i);
+    log.append(x);
+  }
+  log.max_size(2);
+  CHECK(!log.covers(1));
+  CHECK(log.covers(2));
+  for (int i = 3; i <= 5; ++i) {
+    auto x = put(i);
+    log.append(x);
+  }
+  CHECK_EQUAL(log.size(), 2u);
+  CHECK(log.covers(3));
+  CHECK_EQUAL(seqs(log.since(3)), seq_vector({4, 5}));
+  log.max_size(1);
+  CHECK_EQUAL(seqs(log.since(4)), seq_vector{5});
+  CHECK(!log.covers(3));
+}
+
+TEST(empty logs only number commands) {
+  detail::replication_log log;
+  auto x = put(1);
+  log.append(x);
+  CHECK_EQUAL(x.seq, 1u);
+  CHECK_EQUAL(log.size(), 0u);
+  CHECK(!log.covers(0));
+  CHECK(log.covers(1));
+}
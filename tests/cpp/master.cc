@@ -8,6 +8,9 @@
 
 #include "broker/atoms.hh"
 #include "broker/backend.hh"
+#include "broker/detail/clone_actor.hh"
+#include "broker/detail/make_backend.hh"
+#include "broker/detail/master_actor.hh"
 #include "broker/data.hh"
 #include "broker/endpoint.hh"
 #include "broker/error.hh"
@@ -23,6 +26,83 @@ using namespace caf;
 using namespace broker;
 using namespace broker::detail;
 
+namespace {
+
+// Streams a single entry to `clone` and then keeps the stream open until the
+// test kills the actor, which aborts the stream.
+void stalling_snapshot(event_based_actor* self, actor clone) {
+  self->make_source(
+    clone,
+    [](bool& sent) { sent = false; },
+    [](bool& sent, downstream<snapshot_entry>& out, size_t) {
+      if (!sent) {
+        out.push(snapshot_entry{"key", "value"});
+        sent = true;
+      }
+    },
+    [](const bool&) { return false; });
+}
+
+template <class T>
+T& deref(const actor& hdl) {
+  return dynamic_cast<T&>(*actor_cast<abstract_actor*>(hdl));
+}
+
+struct fake_core_state {
+  std::vector<sequence_number> snapshot_requests;
+  std::vector<actor> snapshots;
+};
+
+// Plays the core as well as the master for a single clone.
+behavior fake_core(stateful_actor<fake_core_state>* self) {
+  return {
+    [=](atom::store, atom::master, atom::resolve, const string&,
+        actor& clone) {
+      self->send(clone, atom::master::value, actor_cast<actor>(self));
+    },
+    [=](atom::store, atom::master, atom::snapshot, const string&,
+        actor& clone, sequence_number since) {
+      auto& st = self->state;
+      st.snapshot_requests.emplace_back(since);
+      st.snapshots.emplace_back(self->spawn(stalling_snapshot, clone));
+    },
+  };
+}
+
+struct relay_core_state {
+  actor master;
+  std::vector<sequence_number> snapshot_requests;
+  std::vector<command_message> published;
+};
+
+// Connects a single clone to a master and collects the commands of the master
+// for the clones instead of streaming them.
+behavior relay_core(stateful_actor<relay_core_state>* self) {
+  return {
+    [=](atom::store, atom::master, atom::resolve, const string&,
+        actor& clone) {
+      self->send(clone, atom::master::value, self->state.master);
+    },
+    [=](atom::store, atom::master, atom::snapshot, const string&,
+        actor& clone, sequence_number since) {
+      auto& st = self->state;
+      st.snapshot_requests.emplace_back(since);
+      auto cmd = make_internal_command<snapshot_command>(
+        actor_cast<actor>(self), std::move(clone), since);
+      self->send(st.master, atom::local::value, std::move(cmd));
+    },
+    [=](atom::publish, command_message& x) {
+      self->state.published.emplace_back(std::move(x));
+    },
+    [=](atom::publish, std::vector<command_message>& xs) {
+      for (auto& x : xs)
+        self->state.published.emplace_back(std::move(x));
+    },
+  };
+}
+
+} // namespace
+
 CAF_TEST_FIXTURE_SCOPE(local_store_master, base_fixture)
 
 CAF_TEST(local_master) {
@@ -179,3 +259,158 @@ CAF_TEST(master_with_clone) {
 }
 
 CAF_TEST_FIXTURE_SCOPE_END()
+
+namespace {
+
+struct local_reads_fixture : base_fixture {
+  local_reads_fixture() : base_fixture(make_options()) {
+    // nop
+  }
+
+  static broker_options make_options() {
+    broker_options result;
+    result.clone_local_reads = true;
+    return result;
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(store_clone_local_reads,
+                       point_to_point_fixture<local_reads_fixture>)
+
+CAF_TEST(clone_local_reads) {
+  auto core1 = earth.ep.core();
+  auto core2 = mars.ep.core();
+  anon_send(core1, atom::no_events::value);
+  anon_send(core2, atom::no_events::value);
+  CAF_MESSAGE("connect mars and earth");
+  prepare_connection(mars, earth, "mars", 8080u);
+  exec_all();
+  mars.sched.inline_next_enqueue(); // listen() calls middleman().publish()
+  CAF_CHECK_EQUAL(mars.ep.listen("", 8080u), 8080u);
+  exec_all();
+  auto core2_proxy = earth.remote_actor("mars", 8080u);
+  exec_all();
+  CAF_MESSAGE("attach a master on earth and peer with mars");
+  earth.sched.inline_next_enqueue();
+  auto expected_ds_earth = earth.ep.attach_master("foo", memory);
+  CAF_REQUIRE(expected_ds_earth.engaged());
+  auto& ds_earth = *expected_ds_earth;
+  exec_all();
+  ds_earth.put("test", 123);
+  ds_earth.put("xs", set{1, 2});
+  exec_all();
+  earth.self->send(core1, atom::peer::value, core2_proxy);
+  exec_all();
+  CAF_MESSAGE("attach a clone on mars");
+  mars.sched.inline_next_enqueue();
+  auto expected_ds_mars = mars.ep.attach_clone("foo");
+  CAF_REQUIRE(expected_ds_mars.engaged());
+  auto& ds_mars = *expected_ds_mars;
+  exec_all();
+  CAF_MESSAGE("queries on the clone read its view without messaging");
+  CAF_CHECK_EQUAL(value_of(ds_mars.get("test")), data{123});
+  CAF_CHECK_EQUAL(error_of(ds_mars.get("user")), caf::error{ec::no_such_key});
+  CAF_CHECK_EQUAL(value_of(ds_mars.exists("test")), data{true});
+  CAF_CHECK_EQUAL(value_of(ds_mars.exists("user")), data{false});
+  CAF_CHECK_EQUAL(value_of(ds_mars.get_index_from_value("xs", 2)),
+                  data{true});
+  CAF_CHECK_EQUAL(value_of(ds_mars.keys()), data(set{"test", "xs"}));
+  CAF_MESSAGE("the view reflects updates after the clone applied them");
+  ds_mars.put("user", "neverlord");
+  ds_earth.erase("test");
+  exec_all();
+  CAF_CHECK_EQUAL(value_of(ds_mars.get("user")), data{"neverlord"});
+  CAF_CHECK_EQUAL(value_of(ds_mars.exists("test")), data{false});
+  CAF_MESSAGE("the view turns stale once the clone terminates");
+  anon_send_exit(core2, exit_reason::user_shutdown);
+  exec_all();
+  CAF_CHECK_EQUAL(error_of(ds_mars.get("user")), caf::error{ec::stale_data});
+  CAF_CHECK_EQUAL(error_of(ds_mars.exists("user")),
+                  caf::error{ec::stale_data});
+  anon_send_exit(core1, exit_reason::user_shutdown);
+  exec_all();
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
+
+CAF_TEST_FIXTURE_SCOPE(store_clone_snapshots, base_fixture)
+
+CAF_TEST(clones request a new snapshot after an aborted snapshot stream) {
+  endpoint::clock clk{&sys, false};
+  auto core = sys.spawn(fake_core);
+  auto clone = sys.spawn(clone_actor, core, string{"foo"}, 10.0, -1.0, -1.0,
+                         clone_view_ptr{}, &clk);
+  run();
+  auto& st = deref<stateful_actor<fake_core_state>>(core).state;
+  CAF_REQUIRE_EQUAL(st.snapshot_requests.size(), 1u);
+  CAF_MESSAGE("abort the snapshot stream while the master stays up");
+  anon_send_exit(st.snapshots.front(), exit_reason::user_shutdown);
+  run();
+  CAF_REQUIRE_EQUAL(st.snapshot_requests.size(), 2u);
+  CAF_CHECK_EQUAL(st.snapshot_requests.back(), 0u);
+  auto& cst = deref<stateful_actor<clone_state>>(clone).state;
+  CAF_CHECK(cst.awaiting_snapshot);
+  CAF_CHECK_EQUAL(cst.last_seq, 0u);
+  for (auto& hdl : st.snapshots)
+    anon_send_exit(hdl, exit_reason::user_shutdown);
+  anon_send_exit(clone, exit_reason::user_shutdown);
+  anon_send_exit(core, exit_reason::user_shutdown);
+  run();
+}
+
+CAF_TEST(clones catch up from the replication log after reconnecting) {
+  endpoint::clock clk{&sys, false};
+  auto core = sys.spawn(relay_core);
+  auto& st = deref<stateful_actor<relay_core_state>>(core).state;
+  st.master = sys.spawn(master_actor, core, string{"foo"},
+                        make_backend(memory, {}), size_t{10}, &clk);
+  auto put = [&](string key, int value) {
+    anon_send(st.master, atom::local::value,
+              make_internal_command<put_command>(std::move(key), value));
+  };
+  put("a", 1);
+  run();
+  auto& mst = deref<stateful_actor<master_state>>(st.master).state;
+  CAF_MESSAGE("the master only numbers commands without any clone");
+  CAF_CHECK_EQUAL(mst.log.size(), 0u);
+  CAF_CHECK(st.published.empty());
+  auto clone = sys.spawn(clone_actor, core, string{"foo"}, 10.0, -1.0, -1.0,
+                         clone_view_ptr{}, &clk);
+  run();
+  auto& cst = deref<stateful_actor<clone_state>>(clone).state;
+  cst.update(st.published);
+  st.published.clear();
+  run();
+  CAF_REQUIRE_EQUAL(st.snapshot_requests, std::vector<sequence_number>{0});
+  CAF_REQUIRE(!cst.awaiting_snapshot && !cst.awaiting_snapshot_sync);
+  CAF_REQUIRE(cst.store.find("a") != nullptr);
+  CAF_CHECK_EQUAL(*cst.store.find("a"), data{1});
+  auto since = cst.last_seq;
+  CAF_CHECK_NOT_EQUAL(since, 0u);
+  CAF_MESSAGE("the clone misses an update while losing its master");
+  put("b", 2);
+  run();
+  st.published.clear();
+  auto generation = cst.snapshot_generation;
+  anon_send(clone, down_msg{st.master.address(), exit_reason::unreachable});
+  run();
+  CAF_REQUIRE_EQUAL(st.snapshot_requests,
+                    std::vector<sequence_number>({0, since}));
+  CAF_MESSAGE("the master sends only the missed commands");
+  CAF_CHECK_EQUAL(cst.snapshot_generation, generation + 1);
+  CAF_CHECK(!cst.awaiting_snapshot);
+  CAF_REQUIRE(cst.store.find("b") != nullptr);
+  CAF_CHECK_EQUAL(*cst.store.find("b"), data{2});
+  cst.update(st.published);
+  run();
+  CAF_CHECK(!cst.awaiting_snapshot_sync);
+  CAF_CHECK_EQUAL(cst.last_seq, mst.log.last_seq());
+  anon_send_exit(clone, exit_reason::user_shutdown);
+  anon_send_exit(st.master, exit_reason::user_shutdown);
+  anon_send_exit(core, exit_reason::user_shutdown);
+  run();
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -0,0 +1,165 @@
+#define SUITE message
+
+#include "broker/message.hh"
+
+#include "test.hh"
+
+#include <deque>
+#include <vector>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+
+#include "broker/data.hh"
+#include "broker/detail/compact_encoding.hh"
+#include "broker/detail/indexed_downstream_manager.hh"
+#include "broker/topic.hh"
+
+using namespace broker;
+
+namespace {
+
+using buffer_type = caf::binary_serializer::container_type;
+
+buffer_type serialize(node_message& x) {
+  buffer_type buf;
+  caf::binary_serializer sink{nullptr, buf};
+  if (auto err = sink(x))
+    FAIL("serialization failed: " << to_string(err));
+  return buf;
+}
+
+node_message deserialize(const buffer_type& buf) {
+  node_message result;
+  caf::binary_deserializer source{nullptr, buf};
+  if (auto err = source(result))
+    FAIL("deserialization failed: " << to_string(err));
+  return result;
+}
+
+const data& value_of(node_message& x) {
+  if (auto err = detail::unpack(nullptr, x))
+    FAIL("unpacking failed: " << to_string(err));
+  return get_data(caf::get<data_message>(x.content));
+}
+
+struct fixture {
+  node_message msg;
+
+  fixture() {
+    msg = make_node_message(make_data_message("/foo/bar",
+                                              vector{1, "two", 3.}),
+                            42);
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(message_tests, fixture)
+
+TEST(messages without cache survive a roundtrip) {
+  auto buf = serialize(msg);
+  auto copy = deserialize(buf);
+  CHECK_EQUAL(copy.ttl, 42u);
+  REQUIRE(is_data_message(copy));
+  CHECK_EQUAL(get_topic(copy), "/foo/bar"_t);
+  CHECK(copy.packed);
+  CHECK_EQUAL(value_of(copy), data{vector{1, "two", 3.}});
+  CHECK(!copy.packed);
+}
+
+TEST(copies share the cache after preparing a fan out) {
+  detail::prepare_fan_out(msg);
+  REQUIRE(msg.cache != nullptr);
+  auto copy = msg;
+  CHECK(copy.cache == msg.cache);
+  auto buf1 = serialize(msg);
+  auto buf2 = serialize(copy);
+  CHECK_EQUAL(buf1, buf2);
+  // The cache must produce the same bytes as encoding without cache.
+  node_message uncached{msg.content, msg.ttl, nullptr};
+  CHECK_EQUAL(serialize(uncached), buf1);
+}
+
+TEST(relaying packed messages preserves their value) {
+  auto buf = serialize(msg);
+  auto copy = deserialize(buf);
+  CHECK(copy.cache != nullptr);
+  // Forwarding with a different TTL writes the cached payload as-is.
+  copy.ttl = 41;
+  auto fwd = deserialize(serialize(copy));
+  CHECK_EQUAL(fwd.ttl, 41u);
+  CHECK_EQUAL(get_topic(fwd), "/foo/bar"_t);
+  CHECK_EQUAL(value_of(fwd), data{vector{1, "two", 3.}});
+}
+
+TEST(data payloads use the compact encoding) {
+  auto copy = deserialize(serialize(msg));
+  REQUIRE(copy.cache != nullptr);
+  CHECK(detail::compact_encoding::is_compact(copy.cache->data(),
+                                             copy.cache->size()));
+  auto view = detail::payload_view(copy);
+  CHECK_EQUAL(view.size(), 3u);
+  CHECK_EQUAL(view[0].as<integer>(), integer{1});
+  CHECK_EQUAL(view[2].as<real>(), 3.);
+}
+
+TEST(pre-encoded payloads go to peers as they are) {
+  std::vector<char> payload;
+  detail::compact_encoding::encode(vector{1, "two", 3.}, payload);
+  auto x = make_packed_node_message("/foo/bar", payload, 42);
+  CHECK(x.packed);
+  auto copy = deserialize(serialize(x));
+  CHECK_EQUAL(get_topic(copy), "/foo/bar"_t);
+  REQUIRE(copy.cache != nullptr);
+  CHECK_EQUAL(std::vector<char>(copy.cache->data(),
+                                copy.cache->data() + copy.cache->size()),
+              payload);
+  CHECK_EQUAL(value_of(copy), data{vector{1, "two", 3.}});
+}
+
+TEST(command messages survive a roundtrip) {
+  auto cmd = make_internal_command<put_command>(data{"key"}, data{42}, caf::none);
+  node_message x{make_command_message("/foo/store", cmd), 10};
+  auto copy = deserialize(serialize(x));
+  REQUIRE(is_command_message(copy));
+  CHECK(copy.packed);
+  REQUIRE(!detail::unpack(nullptr, copy));
+  auto& content = get_command(caf::get<command_message>(copy.content));
+  REQUIRE(caf::holds_alternative<put_command>(content));
+  CHECK_EQUAL(caf::get<put_command>(content).key, data{"key"});
+}
+
+TEST(store commands overtake queued data messages) {
+  auto cmd = [](int x) {
+    auto c = make_internal_command<erase_command>(data{x});
+    return node_message{make_command_message("/foo/store", std::move(c)), 10};
+  };
+  auto key = [](const node_message& x) {
+    auto& content = get_command(caf::get<command_message>(x.content));
+    return caf::get<erase_command>(content).key;
+  };
+  std::deque<node_message> bulk;
+  std::deque<node_message> control;
+  detail::enqueue(bulk, control, msg, true);
+  detail::enqueue(bulk, control, cmd(1), true);
+  detail::enqueue(bulk, control, msg, true);
+  detail::enqueue(bulk, control, cmd(2), true);
+  REQUIRE_EQUAL(control.size(), 2u);
+  CHECK_EQUAL(key(control[0]), data{1});
+  CHECK_EQUAL(key(control[1]), data{2});
+  REQUIRE_EQUAL(bulk.size(), 2u);
+  CHECK(is_data_message(bulk[0]));
+  CHECK(is_data_message(bulk[1]));
+  // Without priority lanes, the bulk lane keeps the insertion order.
+  bulk.clear();
+  control.clear();
+  detail::enqueue(bulk, control, msg, false);
+  detail::enqueue(bulk, control, cmd(1), false);
+  CHECK(control.empty());
+  REQUIRE_EQUAL(bulk.size(), 2u);
+  CHECK(is_data_message(bulk[0]));
+  CHECK(is_command_message(bulk[1]));
+}
+
+FIXTURE_SCOPE_END()
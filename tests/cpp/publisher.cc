@@ -26,6 +26,7 @@
 #include "broker/filter_type.hh"
 #include "broker/message.hh"
 #include "broker/topic.hh"
+#include "broker/zeek.hh"
 
 using std::cout;
 using std::endl;
@@ -187,4 +188,47 @@ CAF_TEST(nonblocking_publishers) {
   anon_send_exit(leaf, exit_reason::user_shutdown);
 }
 
+CAF_TEST(batching_publishers) {
+  // Spawn/get/configure core actors.
+  broker_options options;
+  options.disable_ssl = true;
+  auto core1 = ep.core();
+  auto core2 = sys.spawn(core_actor, filter_type{"a"}, options, nullptr);
+  anon_send(core1, atom::subscribe::value, filter_type{"a"});
+  anon_send(core1, atom::no_events::value);
+  anon_send(core2, atom::no_events::value);
+  self->send(core1, atom::peer::value, core2);
+  auto leaf = sys.spawn(consumer, filter_type{"a"}, core2);
+  run();
+  auto ev = [](integer i) {
+    return zeek::Event("test", vector{i}).move_data();
+  };
+  { // Lifetime scope of our publisher.
+    auto pub = ep.make_publisher("a");
+    pub.set_batching(3, std::chrono::milliseconds(5));
+    run();
+    // The publisher ships a full batch right away and the remaining events
+    // once their delay expires.
+    pub.publish({ev(1), ev(2), ev(3), ev(4), ev(5)});
+    run();
+    self->send(leaf, atom::get::value);
+    sched.prioritize(leaf);
+    consume_message();
+    self->receive(
+      [&](const std::vector<data_message>& xs) {
+        auto batch1 = zeek::Batch(vector{ev(1), ev(2), ev(3)}).move_data();
+        auto batch2 = zeek::Batch(vector{ev(4), ev(5)}).move_data();
+        auto expected = data_msgs({{"a", batch1}, {"a", batch2}});
+        CAF_REQUIRE_EQUAL(xs, expected);
+      }
+    );
+  }
+  run();
+  // Shutdown.
+  CAF_MESSAGE("Shutdown core actors.");
+  anon_send_exit(core1, exit_reason::user_shutdown);
+  anon_send_exit(core2, exit_reason::user_shutdown);
+  anon_send_exit(leaf, exit_reason::user_shutdown);
+}
+
 CAF_TEST_FIXTURE_SCOPE_END()
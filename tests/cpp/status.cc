@@ -54,10 +54,17 @@ TEST(sc is convertible to and from string) {
   CHECK_EQUAL(to_string(sc::peer_added), "peer_added"s);
   CHECK_EQUAL(to_string(sc::peer_removed), "peer_removed"s);
   CHECK_EQUAL(to_string(sc::peer_lost), "peer_lost"s);
+  CHECK_EQUAL(to_string(sc::peer_buffering), "peer_buffering"s);
+  CHECK_EQUAL(to_string(sc::peer_buffer_overflow), "peer_buffer_overflow"s);
+  CHECK_EQUAL(to_string(sc::peer_buffer_drained), "peer_buffer_drained"s);
   CHECK_EQUAL(from_string<sc>("unspecified"), sc::unspecified);
   CHECK_EQUAL(from_string<sc>("peer_added"), sc::peer_added);
   CHECK_EQUAL(from_string<sc>("peer_removed"), sc::peer_removed);
   CHECK_EQUAL(from_string<sc>("peer_lost"), sc::peer_lost);
+  CHECK_EQUAL(from_string<sc>("peer_buffering"), sc::peer_buffering);
+  CHECK_EQUAL(from_string<sc>("peer_buffer_overflow"),
+              sc::peer_buffer_overflow);
+  CHECK_EQUAL(from_string<sc>("peer_buffer_drained"), sc::peer_buffer_drained);
   CHECK_EQUAL(from_string<sc>("foo"), nil);
 }
 
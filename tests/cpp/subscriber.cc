@@ -7,6 +7,10 @@
 
 #include "test.hh"
 
+#include <set>
+#include <string>
+#include <vector>
+
 #include <caf/actor.hpp>
 #include <caf/downstream.hpp>
 #include <caf/event_based_actor.hpp>
@@ -22,6 +26,7 @@
 #include "broker/filter_type.hh"
 #include "broker/message.hh"
 #include "broker/topic.hh"
+#include "broker/zeek.hh"
 
 using std::cout;
 using std::endl;
@@ -55,6 +60,32 @@ void driver(event_based_actor* self, const actor& sink) {
     [](const buf_type& xs) { return xs.empty(); });
 }
 
+data event(integer i) {
+  return zeek::Event("test", vector{i}).move_data();
+}
+
+void batch_driver(event_based_actor* self, const actor& sink) {
+  using buf_type = std::vector<data_message>;
+  self->make_source(
+    // Destination.
+    sink,
+    // Initialize send buffer with a batch, a single event, and another batch.
+    [](buf_type& xs) {
+      auto batch1 = zeek::Batch(vector{event(1), event(2)}).move_data();
+      auto batch2 = zeek::Batch(vector{event(4)}).move_data();
+      xs = data_msgs({{"b", batch1}, {"b", event(3)}, {"b", batch2}});
+    },
+    // Get next element.
+    [](buf_type& xs, downstream<data_message>& out, size_t num) {
+      auto n = std::min(num, xs.size());
+      for (size_t i = 0u; i < n; ++i)
+        out.push(xs[i]);
+      xs.erase(xs.begin(), xs.begin() + static_cast<ptrdiff_t>(n));
+    },
+    // Did we reach the end?.
+    [](const buf_type& xs) { return xs.empty(); });
+}
+
 } // namespace <anonymous>
 
 CAF_TEST_FIXTURE_SCOPE(subscriber_tests, base_fixture)
@@ -136,4 +167,88 @@ CAF_TEST(nonblocking_subscriber) {
   anon_send_exit(core2, exit_reason::user_shutdown);
 }
 
+CAF_TEST(unbatching_subscriber) {
+  // Spawn/get/configure core actors.
+  broker_options options;
+  options.disable_ssl = true;
+  auto core1 = sys.spawn(core_actor, filter_type{"b"}, options, nullptr);
+  auto core2 = ep.core();
+  anon_send(core2, atom::subscribe::value, filter_type{"b"});
+  anon_send(core1, atom::no_events::value);
+  anon_send(core2, atom::no_events::value);
+  run();
+  auto sub = ep.make_subscriber(filter_type{"b"});
+  sub.set_rate_calculation(false);
+  sub.set_unbatching(true);
+  auto leaf = sub.worker();
+  self->send(core1, atom::peer::value, core2);
+  run();
+  auto d1 = sys.spawn(batch_driver, core1);
+  run();
+  CAF_MESSAGE("check that the subscriber receives individual events");
+  auto expected = data_msgs({{"b", event(1)}, {"b", event(2)},
+                             {"b", event(3)}, {"b", event(4)}});
+  CAF_CHECK_EQUAL(sub.poll(), expected);
+  // Shutdown.
+  CAF_MESSAGE("Shutdown core actors.");
+  anon_send_exit(core1, exit_reason::user_shutdown);
+  anon_send_exit(core2, exit_reason::user_shutdown);
+  anon_send_exit(leaf, exit_reason::user_shutdown);
+  anon_send_exit(d1, exit_reason::user_shutdown);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
+
+namespace {
+
+struct sharded_fixture : base_fixture {
+  sharded_fixture() : base_fixture(make_options()) {
+    // nop
+  }
+
+  static broker_options make_options() {
+    broker_options result;
+    result.core_shards = 2;
+    return result;
+  }
+};
+
+} // namespace <anonymous>
+
+CAF_TEST_FIXTURE_SCOPE(sharded_subscriber_tests, sharded_fixture)
+
+CAF_TEST(subscribers share one state across shards) {
+  CAF_REQUIRE_EQUAL(ep.cores().size(), 2u);
+  // Pick one topic per shard.
+  std::vector<topic> topics;
+  for (auto i = 0; topics.size() < 2 && i < 100; ++i) {
+    topic t{"t" + std::to_string(i)};
+    if (topics.empty() || &ep.core(t) != &ep.core(topics.front()))
+      topics.emplace_back(std::move(t));
+  }
+  CAF_REQUIRE_EQUAL(topics.size(), 2u);
+  using buf = std::vector<data_message>;
+  size_t inits = 0;
+  std::set<const buf*> states;
+  size_t received = 0;
+  ep.subscribe_nosync(
+    topics,
+    [&](buf&) { ++inits; },
+    [&](buf& xs, data_message x) {
+      states.emplace(&xs);
+      xs.emplace_back(std::move(x));
+      received = xs.size();
+    },
+    [](buf&, const error&) {
+      // nop
+    });
+  run();
+  ep.publish(topics[0], data{1});
+  ep.publish(topics[1], data{2});
+  run();
+  CAF_CHECK_EQUAL(inits, 1u);
+  CAF_CHECK_EQUAL(states.size(), 1u);
+  CAF_CHECK_EQUAL(received, 2u);
+}
+
 CAF_TEST_FIXTURE_SCOPE_END()
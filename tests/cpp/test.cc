@@ -2,6 +2,8 @@
 
 #include "test.hh"
 
+#include <utility>
+
 #include <caf/test/unit_test_impl.hpp>
 
 #include <caf/defaults.hpp>
@@ -18,8 +20,12 @@
 using namespace caf;
 using namespace broker;
 
-base_fixture::base_fixture()
-  : ep(make_config()),
+base_fixture::base_fixture() : base_fixture(broker_options{}) {
+  // nop
+}
+
+base_fixture::base_fixture(broker_options options)
+  : ep(make_config(std::move(options))),
     sys(ep.system()),
     self(sys),
     sched(dynamic_cast<scheduler_type&>(sys.scheduler())),
@@ -53,8 +59,7 @@ void base_fixture::deinit_socket_api() {
 #endif
 }
 
-configuration base_fixture::make_config() {
-  broker_options options;
+configuration base_fixture::make_config(broker_options options) {
   options.disable_ssl = true;
   configuration cfg{options};
   test_coordinator_fixture<configuration>::init_config(cfg);
@@ -57,6 +57,9 @@ public:
 
   base_fixture();
 
+  /// Creates the endpoint with custom options. Always disables SSL.
+  explicit base_fixture(broker::broker_options options);
+
   virtual ~base_fixture();
 
   broker::endpoint ep;
@@ -74,7 +77,7 @@ public:
   static void deinit_socket_api();
 
 private:
-  static broker::configuration make_config();
+  static broker::configuration make_config(broker::broker_options options);
 };
 
 inline broker::data value_of(caf::expected<broker::data> x) {
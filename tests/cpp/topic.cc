@@ -88,3 +88,50 @@ TEST(prefix) {
   CAF_CHECK( t5.prefix_of(t4));
   CAF_CHECK( t5.prefix_of(t5));
 }
+
+TEST(interning) {
+  std::string str = "/zeek/events";
+  topic t0 = str;
+  topic t1 = "/zeek/events";
+  topic t2 = "/zeek"_t / "events";
+  topic t3 = "/zeek/event";
+  CHECK_EQUAL(t0.id(), t1.id());
+  CHECK_EQUAL(t0.id(), t2.id());
+  CHECK_NOT_EQUAL(t0.id(), t3.id());
+  CHECK_EQUAL(&t0.string(), &t2.string());
+  CHECK_EQUAL(t0.hash(), std::hash<std::string>{}(str));
+  CHECK_EQUAL(std::hash<topic>{}(t0), std::hash<topic>{}(t2));
+  topic empty;
+  CHECK(empty.empty());
+  CHECK_EQUAL(empty.id(), 0u);
+  CHECK_EQUAL(empty, topic{""});
+  CHECK_EQUAL(empty.string(), "");
+}
+
+TEST(ordering) {
+  topic t0 = "/a";
+  topic t1 = "/a/b";
+  topic t2 = "/b";
+  CHECK_LESS(t0, t1);
+  CHECK_LESS(t1, t2);
+  CHECK(!(t0 < t0));
+  CHECK_LESS(topic{}, t0);
+}
+
+TEST(flags) {
+  CHECK(is_clone(topics::clone_suffix.flags()));
+  CHECK(is_master(topics::master_suffix.flags()));
+  CHECK(is_errors(topics::errors.flags()));
+  CHECK(is_statuses(topics::statuses.flags()));
+  CHECK(is_status_or_error(topics::errors.flags()));
+  CHECK(is_status_or_error(topics::statuses.flags()));
+  auto clone_topic = "mystore"_t / topics::clone_suffix;
+  CHECK(is_clone(clone_topic.flags()));
+  CHECK(!is_master(clone_topic.flags()));
+  auto master_topic = "mystore"_t / topics::master_suffix;
+  CHECK(is_master(master_topic.flags()));
+  CHECK(!is_clone(master_topic.flags()));
+  CHECK(!is_status_or_error(master_topic.flags()));
+  CHECK(topic{"/zeek/events"}.flags() == topic_flags::none);
+  CHECK(topic{}.flags() == topic_flags::none);
+}
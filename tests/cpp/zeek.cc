@@ -4,12 +4,19 @@
 #define SUITE zeek
 
 #include "broker/zeek.hh"
+#include "broker/zeek_schema.hh"
 
 #include "test.hh"
 
+#include <chrono>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "broker/data.hh"
+#include "broker/data_view.hh"
+#include "broker/detail/compact_encoding.hh"
+#include "broker/time.hh"
 
 using namespace broker;
 
@@ -20,3 +27,117 @@ TEST(event) {
   CHECK_EQUAL(ev2.name(), "test");
   CHECK_EQUAL(ev2.args(), args);
 }
+
+TEST(event view) {
+  auto args = vector{1, "s", port(42, port::protocol::tcp)};
+  zeek::Event ev("test", vector(args));
+  std::vector<char> buf;
+  auto msg = make_data_view(ev.as_data(), buf);
+  CHECK_EQUAL(zeek::Message::type(msg), zeek::Message::Type::Event);
+  zeek::EventView view{msg};
+  REQUIRE(view.valid());
+  CHECK_EQUAL(std::string{view.name()}, "test");
+  CHECK_EQUAL(view.args().size(), 3u);
+  CHECK(view.args()[1].is<std::string>());
+  auto materialized = view.materialize();
+  REQUIRE(materialized);
+  CHECK_EQUAL(materialized->args(), args);
+}
+
+TEST(event views reject malformed events) {
+  std::vector<char> buf;
+  auto msg = make_data_view(vector{zeek::ProtocolVersion, count{1},
+                                   vector{42, vector{}}},
+                            buf);
+  zeek::EventView view{msg};
+  CHECK(!view.valid());
+  CHECK(view.name().empty());
+  CHECK(!view.materialize());
+  zeek::EventView empty{data_view{}};
+  CHECK(!empty.valid());
+  CHECK(empty.name().empty());
+  CHECK(!empty.args().valid());
+}
+
+namespace {
+
+using conn_schema = zeek::EventSchema<std::string, timestamp, count, data,
+                                      timestamp, vector>;
+
+timestamp make_ts(integer ns) {
+  return timestamp{timespan{ns}};
+}
+
+} // namespace
+
+TEST(event schemas encode events like the compact encoding) {
+  conn_schema schema{"conn_seen"};
+  auto t0 = make_ts(1577836800000000000);
+  auto t1 = t0 + std::chrono::seconds(1);
+  auto extra = data{t0 + std::chrono::seconds(2)};
+  auto nested = vector{1, "x", t0};
+  std::vector<char> buf;
+  schema.encode(buf, "C1", t0, 42u, extra, t1, nested);
+  auto ev = schema.make_event("C1", t0, 42u, extra, t1, nested);
+  CHECK_EQUAL(ev.name(), "conn_seen");
+  std::vector<char> expected;
+  detail::compact_encoding::encode(ev.as_data(), expected);
+  CHECK_EQUAL(buf, expected);
+  zeek::EventView view{data_view{buf.data(), buf.size()}};
+  REQUIRE(view.valid());
+  CHECK_EQUAL(std::string{view.name()}, "conn_seen");
+}
+
+TEST(event schemas decode typed arguments) {
+  conn_schema schema{"conn_seen"};
+  auto t0 = make_ts(1577836800000000000);
+  auto t1 = t0 + std::chrono::seconds(1);
+  auto extra = data{t0 + std::chrono::seconds(2)};
+  auto nested = vector{1, "x", t0};
+  std::vector<char> buf;
+  schema.encode(buf, "C1", t0, 42u, extra, t1, nested);
+  std::string uid;
+  timestamp ts0;
+  count n = 0;
+  data x;
+  timestamp ts1;
+  vector xs;
+  REQUIRE(schema.decode(buf.data(), buf.size(), uid, ts0, n, x, ts1, xs));
+  CHECK_EQUAL(uid, "C1");
+  CHECK_EQUAL(ts0, t0);
+  CHECK_EQUAL(n, 42u);
+  CHECK_EQUAL(x, extra);
+  CHECK_EQUAL(ts1, t1);
+  CHECK_EQUAL(xs, nested);
+  // Decoding from a data tree yields the same values.
+  auto ev = schema.make_event("C2", t1, 7u, nil, t0, vector{});
+  REQUIRE(schema.decode(ev.as_data(), uid, ts0, n, x, ts1, xs));
+  CHECK_EQUAL(uid, "C2");
+  CHECK_EQUAL(ts0, t1);
+  CHECK_EQUAL(n, 7u);
+  CHECK_EQUAL(x, nil);
+  CHECK_EQUAL(ts1, t0);
+  CHECK(xs.empty());
+}
+
+TEST(event schemas reject mismatching events) {
+  conn_schema schema{"conn_seen"};
+  auto t0 = make_ts(1577836800000000000);
+  std::vector<char> buf;
+  schema.encode(buf, "C1", t0, 42u, nil, t0, vector{});
+  std::string uid;
+  timestamp ts;
+  count n = 0;
+  data x;
+  vector xs;
+  conn_schema other{"conn_lost"};
+  CHECK(!other.decode(buf.data(), buf.size(), uid, ts, n, x, ts, xs));
+  zeek::EventSchema<std::string, count> short_schema{"conn_seen"};
+  CHECK(!short_schema.decode(buf.data(), buf.size(), uid, n));
+  zeek::EventSchema<count, timestamp, count, data, timestamp, vector>
+    wrong_types{"conn_seen"};
+  CHECK(!wrong_types.decode(buf.data(), buf.size(), n, ts, n, x, ts, xs));
+  CHECK(!schema.decode(buf.data(), buf.size() - 1, uid, ts, n, x, ts, xs));
+  auto ev = zeek::Event("conn_seen", vector{"C1"});
+  CHECK(!schema.decode(ev.as_data(), uid, ts, n, x, ts, xs));
+}